@@ -1,10 +1,5 @@
 // Blur Vertex Shader (DirectX 11 / HLSL)
-
-struct VSInput
-{
-    float3 Position : POSITION;
-    float2 TexCoord : TEXCOORD0;
-};
+// Fullscreen triangle from SV_VertexID, drawn with Draw(3, 0) and no vertex or index buffer
 
 struct PSInput
 {
@@ -12,10 +7,13 @@ struct PSInput
     float2 TexCoord : TEXCOORD0;
 };
 
-PSInput main(VSInput input)
+PSInput main(uint vertexId : SV_VertexID)
 {
+    // (-1,-1), (3,-1), (-1,3): covers the viewport, clipped to it
+    float2 ndc = float2((vertexId << 1) & 2, vertexId & 2) * 2.0 - 1.0;
+
     PSInput output;
-    output.Position = float4(input.Position, 1.0);
-    output.TexCoord = input.TexCoord;
+    output.Position = float4(ndc, 0.0, 1.0);
+    output.TexCoord = float2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);
     return output;
 }
@@ -1,19 +1,16 @@
 // Liquid Glass Vertex Shader (DirectX 11 / HLSL)
 
+// 16-bit normalized corners (LiquidGlass.h Vertex), the pass comes from GlassPass in the pixel shader
 struct VSInput
 {
-    float3 Position : POSITION;
+    float2 Position : POSITION;
     float2 TexCoord : TEXCOORD0;
-    float4 Color : COLOR;
-    uint LiquidGlass : BLENDINDICES;
 };
 
 struct PSInput
 {
     float4 Position : SV_POSITION;
     float2 TexCoord : TEXCOORD0;
-    float4 Color : COLOR;
-    nointerpolation uint LiquidGlass : BLENDINDICES;
     nointerpolation float3 MidPoint : TEXCOORD1;
     nointerpolation float2 QuadScale : TEXCOORD2;
 };
@@ -25,6 +22,12 @@ cbuffer TransformBuffer : register(b0)
     float _pad0;
     float2 ObjectSize;
     float2 ScreenSize;
+    float2 CornerRadii;
+    float2 InteriorScale;
+    float4 ShapeRadii;
+    float2 HistoryMidPoint;
+    float HistoryStart;
+    float _pad2;
 };
 
 PSInput main(VSInput input)
@@ -32,13 +35,11 @@ PSInput main(VSInput input)
     PSInput output;
     
     // Scale vertices by ObjectSize, then translate to ObjectPosition
-    float3 scaledPos = input.Position * float3(ObjectSize.x, ObjectSize.y, 1.0);
+    float3 scaledPos = float3(input.Position * ObjectSize, 0.0);
     float4 worldPos = float4(scaledPos + ObjectPosition, 1.0);
     output.Position = mul(ViewProjection, worldPos);
     
     output.TexCoord = input.TexCoord;
-    output.Color = input.Color;
-    output.LiquidGlass = input.LiquidGlass;
     
     // Calculate midpoint in NDC space
     float4 midPointWorld = float4(ObjectPosition, 1.0);
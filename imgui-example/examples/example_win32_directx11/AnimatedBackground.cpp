@@ -0,0 +1,251 @@
+#include "AnimatedBackground.h"
+#include "MappedFile.h"
+#include "stb_image.h"
+#include <limits.h>
+#include <string.h>
+
+static const int DefaultFrameDelayMs = 100;
+
+void DirtyRect::Add(const DirtyRect& other)
+{
+    if (other.IsEmpty())
+        return;
+    if (IsEmpty())
+    {
+        *this = other;
+        return;
+    }
+    x0 = x0 < other.x0 ? x0 : other.x0;
+    y0 = y0 < other.y0 ? y0 : other.y0;
+    x1 = x1 > other.x1 ? x1 : other.x1;
+    y1 = y1 > other.y1 ? y1 : other.y1;
+}
+
+AnimatedBackground::AnimatedBackground()
+{
+    for (int i = 0; i < MaxRingSize; i++)
+    {
+        m_textures[i] = nullptr;
+        m_views[i] = nullptr;
+        m_pending[i] = DirtyRect{ 0, 0, 0, 0 };
+    }
+    m_playing = true;
+    m_ringSize = 0;
+    m_slot = 0;
+    m_width = 0;
+    m_height = 0;
+    m_frame = 0;
+    m_frameTime = 0.0f;
+    m_hasFrame = false;
+    m_revision = 0;
+    m_lastUploadBytes = 0;
+}
+
+AnimatedBackground::~AnimatedBackground()
+{
+    Release();
+}
+
+bool AnimatedBackground::Create(ID3D11Device* device, int width, int height, int ringSize)
+{
+    Release();
+    if (width <= 0 || height <= 0 || ringSize < 2 || ringSize > MaxRingSize)
+        return false;
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width = width;
+    texDesc.Height = height;
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    for (int i = 0; i < ringSize; i++)
+    {
+        if (FAILED(device->CreateTexture2D(&texDesc, nullptr, &m_textures[i])) ||
+            FAILED(device->CreateShaderResourceView(m_textures[i], nullptr, &m_views[i])))
+        {
+            Release();
+            return false;
+        }
+        // Contents are undefined until the first upload
+        m_pending[i] = DirtyRect{ 0, 0, width, height };
+    }
+
+    m_ringSize = ringSize;
+    m_slot = 0;
+    m_hasFrame = false;
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void AnimatedBackground::Release()
+{
+    for (int i = 0; i < MaxRingSize; i++)
+    {
+        if (m_views[i]) m_views[i]->Release();
+        if (m_textures[i]) m_textures[i]->Release();
+        m_views[i] = nullptr;
+        m_textures[i] = nullptr;
+    }
+    m_ringSize = 0;
+    m_frames.clear();
+    m_delays.clear();
+    m_frameDirty.clear();
+    m_frame = 0;
+    m_frameTime = 0.0f;
+}
+
+bool AnimatedBackground::LoadGif(ID3D11Device* device, const char* filename)
+{
+    MappedFile source;
+    if (!source.Open(filename) || source.Size() > (size_t)INT_MAX)
+        return false;
+
+    int* delays = nullptr;
+    int width, height, frameCount, channels;
+    unsigned char* data = stbi_load_gif_from_memory(source.Data(), (int)source.Size(), &delays, &width, &height, &frameCount, &channels, 4);
+    if (!data)
+        return false;
+
+    bool created = Create(device, width, height);
+    if (created)
+    {
+        m_frames.assign(data, data + (size_t)width * height * 4 * frameCount);
+        m_delays.resize(frameCount);
+        for (int i = 0; i < frameCount; i++)
+            m_delays[i] = (delays && delays[i] > 0) ? delays[i] : DefaultFrameDelayMs;
+        BuildFrameDirtyRects();
+    }
+    stbi_image_free(data);
+    stbi_image_free(delays);
+    return created;
+}
+
+bool AnimatedBackground::LoadImageSequence(ID3D11Device* device, const std::vector<std::string>& filenames, int frameDelayMs)
+{
+    std::vector<unsigned char> frames;
+    int width = 0, height = 0;
+    for (size_t i = 0; i < filenames.size(); i++)
+    {
+        int w, h, channels;
+        unsigned char* data = LoadImageMapped(filenames[i].c_str(), &w, &h, &channels, 4);
+        if (!data)
+            return false;
+        if (i == 0)
+        {
+            width = w;
+            height = h;
+            frames.reserve((size_t)width * height * 4 * filenames.size());
+        }
+        bool sameSize = (w == width && h == height);
+        if (sameSize)
+            frames.insert(frames.end(), data, data + (size_t)w * h * 4);
+        stbi_image_free(data);
+        if (!sameSize)
+            return false;
+    }
+
+    if (filenames.empty() || !Create(device, width, height))
+        return false;
+    m_frames.swap(frames);
+    m_delays.assign(filenames.size(), frameDelayMs > 0 ? frameDelayMs : DefaultFrameDelayMs);
+    BuildFrameDirtyRects();
+    return true;
+}
+
+// Bounding box of the pixels that differ from the previous frame, computed once at load
+void AnimatedBackground::BuildFrameDirtyRects()
+{
+    size_t frameCount = m_delays.size();
+    size_t frameSize = (size_t)m_width * m_height * 4;
+    m_frameDirty.resize(frameCount);
+    for (size_t f = 0; f < frameCount; f++)
+    {
+        const uint32_t* cur = (const uint32_t*)&m_frames[f * frameSize];
+        const uint32_t* prev = (const uint32_t*)&m_frames[((f + frameCount - 1) % frameCount) * frameSize];
+        DirtyRect rect = { m_width, m_height, 0, 0 };
+        for (int y = 0; y < m_height; y++)
+        {
+            const uint32_t* a = cur + (size_t)y * m_width;
+            const uint32_t* b = prev + (size_t)y * m_width;
+            if (memcmp(a, b, (size_t)m_width * 4) == 0)
+                continue;
+            int x0 = 0, x1 = m_width;
+            while (a[x0] == b[x0]) x0++;
+            while (a[x1 - 1] == b[x1 - 1]) x1--;
+            rect.x0 = rect.x0 < x0 ? rect.x0 : x0;
+            rect.x1 = rect.x1 > x1 ? rect.x1 : x1;
+            rect.y0 = rect.y0 < y ? rect.y0 : y;
+            rect.y1 = y + 1;
+        }
+        m_frameDirty[f] = rect;
+    }
+}
+
+void AnimatedBackground::PushFrame(ID3D11DeviceContext* context, const unsigned char* rgba, int rowPitch, const DirtyRect* dirty)
+{
+    DirtyRect full = { 0, 0, m_width, m_height };
+    Present(context, rgba, rowPitch, dirty ? *dirty : full);
+}
+
+bool AnimatedBackground::Update(ID3D11DeviceContext* context, float deltaTime)
+{
+    m_lastUploadBytes = 0;
+    if (!m_playing || m_delays.size() < 2)
+    {
+        // Nothing was uploaded yet for a still image
+        if (m_frames.empty() || m_hasFrame)
+            return false;
+        return Present(context, &m_frames[0], m_width * 4, DirtyRect{ 0, 0, 0, 0 });
+    }
+
+    // Catch up on every frame that elapsed, only the last one is uploaded but the
+    // dirty rects of the skipped ones still have to reach every slot
+    m_frameTime += deltaTime * 1000.0f;
+    DirtyRect dirty = { 0, 0, 0, 0 };
+    bool advanced = false;
+    while (m_frameTime >= (float)m_delays[m_frame])
+    {
+        m_frameTime -= (float)m_delays[m_frame];
+        m_frame = (m_frame + 1) % (int)m_delays.size();
+        dirty.Add(m_frameDirty[m_frame]);
+        advanced = true;
+    }
+    if (!advanced && m_hasFrame)
+        return false;
+
+    size_t frameSize = (size_t)m_width * m_height * 4;
+    return Present(context, &m_frames[m_frame * frameSize], m_width * 4, dirty);
+}
+
+// Writes the frame into the next ring slot. Only that slot's stale region is uploaded.
+bool AnimatedBackground::Present(ID3D11DeviceContext* context, const unsigned char* rgba, int rowPitch, const DirtyRect& dirty)
+{
+    if (m_ringSize == 0)
+        return false;
+    for (int i = 0; i < m_ringSize; i++)
+        m_pending[i].Add(dirty);
+
+    // An unchanged frame leaves the visible slot as it is
+    if (dirty.IsEmpty() && m_hasFrame)
+        return false;
+
+    int next = (m_slot + 1) % m_ringSize;
+    DirtyRect& region = m_pending[next];
+    if (!region.IsEmpty())
+    {
+        D3D11_BOX box = { (UINT)region.x0, (UINT)region.y0, 0, (UINT)region.x1, (UINT)region.y1, 1 };
+        const unsigned char* src = rgba + (size_t)region.y0 * rowPitch + (size_t)region.x0 * 4;
+        context->UpdateSubresource(m_textures[next], 0, &box, src, rowPitch, 0);
+        m_lastUploadBytes += (size_t)(region.x1 - region.x0) * (region.y1 - region.y0) * 4;
+        region = DirtyRect{ 0, 0, 0, 0 };
+    }
+    m_slot = next;
+    m_hasFrame = true;
+    m_revision++;
+    return true;
+}
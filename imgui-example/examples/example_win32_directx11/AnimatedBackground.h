@@ -0,0 +1,84 @@
+#pragma once
+#include <d3d11.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Animated background source. Frames come from a GIF, an image sequence, or are
+// pushed as raw RGBA by the application (live content), and are uploaded into a
+// small ring of reusable textures so the GPU never samples the texture being written.
+//
+// Every texture is created once by Create(). Each ring slot remembers the region that
+// changed since it was last written (the union of the per-frame dirty rects), so an
+// upload only touches what actually differs from the frame that slot still holds.
+
+struct DirtyRect
+{
+    int x0, y0, x1, y1;     // Half-open, empty when x0 >= x1 or y0 >= y1
+
+    bool IsEmpty() const { return x0 >= x1 || y0 >= y1; }
+    void Add(const DirtyRect& other);
+};
+
+class AnimatedBackground
+{
+public:
+    enum { MaxRingSize = 3 };
+
+    AnimatedBackground();
+    ~AnimatedBackground();
+
+    // Frame ring for frames of the given size, ringSize 2 (double) or 3 (triple buffered)
+    bool Create(ID3D11Device* device, int width, int height, int ringSize = MaxRingSize);
+    void Release();
+
+    // Decodes every frame up front (frame delays in ms, 0 delays play at 10 fps like browsers do)
+    bool LoadGif(ID3D11Device* device, const char* filename);
+    bool LoadImageSequence(ID3D11Device* device, const std::vector<std::string>& filenames, int frameDelayMs);
+
+    // Live frame from the application, rgba is width*height*4 bytes with the given row pitch.
+    // dirty limits the upload to the region that changed since the previous pushed frame.
+    void PushFrame(ID3D11DeviceContext* context, const unsigned char* rgba, int rowPitch, const DirtyRect* dirty = nullptr);
+
+    // Advances decoded playback. Returns true when the visible frame changed.
+    bool Update(ID3D11DeviceContext* context, float deltaTime);
+
+    ID3D11ShaderResourceView* GetFrame() const { return m_hasFrame ? m_views[m_slot] : nullptr; }
+    uint64_t GetRevision() const { return m_revision; }     // Bumped whenever the visible pixels change
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetFrameCount() const { return (int)m_delays.size(); }
+    int GetFrameIndex() const { return m_frame; }
+    size_t GetLastUploadBytes() const { return m_lastUploadBytes; }
+    size_t GetMemoryBytes() const { return (size_t)m_width * m_height * 4 * m_ringSize; }
+    bool IsPlaying() const { return m_playing; }
+    void SetPlaying(bool playing) { m_playing = playing; }
+
+private:
+    AnimatedBackground(const AnimatedBackground&);
+    AnimatedBackground& operator=(const AnimatedBackground&);
+
+    void BuildFrameDirtyRects();
+    bool Present(ID3D11DeviceContext* context, const unsigned char* rgba, int rowPitch, const DirtyRect& dirty);
+
+private:
+    ID3D11Texture2D* m_textures[MaxRingSize];
+    ID3D11ShaderResourceView* m_views[MaxRingSize];
+    DirtyRect m_pending[MaxRingSize];   // Region of each slot that is older than the newest frame
+    int m_ringSize;
+    int m_slot;
+    bool m_hasFrame;        // Set once a full frame has reached the visible slot
+    int m_width;
+    int m_height;
+
+    // Decoded frames (GIF / image sequence), tightly packed RGBA8
+    std::vector<unsigned char> m_frames;
+    std::vector<int> m_delays;
+    std::vector<DirtyRect> m_frameDirty;    // Change from the previous frame (wrapping)
+    int m_frame;
+    float m_frameTime;
+    bool m_playing;
+
+    uint64_t m_revision;
+    size_t m_lastUploadBytes;
+};
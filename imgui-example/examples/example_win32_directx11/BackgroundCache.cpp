@@ -0,0 +1,209 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "BackgroundCache.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t CacheAlignment = 16;
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Size of one row of texels or 4x4 blocks for a mip of the given width
+static uint32_t GetRowPitch(BackgroundCacheFormat format, uint32_t width)
+{
+    uint32_t blocksWide = (width + 3) / 4;
+    switch (format)
+    {
+    case BackgroundCacheFormat_BC1: return blocksWide * 8;
+    case BackgroundCacheFormat_BC7: return blocksWide * 16;
+    default:                        return width * 4;
+    }
+}
+
+static uint32_t GetRowCount(BackgroundCacheFormat format, uint32_t height)
+{
+    return format == BackgroundCacheFormat_RGBA8 ? height : (height + 3) / 4;
+}
+
+BackgroundCacheFile::BackgroundCacheFile()
+{
+    m_header = nullptr;
+}
+
+bool BackgroundCacheFile::Open(const char* path, uint64_t sourceHash, uint64_t sourceSize)
+{
+    Close();
+    if (!m_file.Open(path))
+        return false;
+
+    // Too short for a header, nothing in it may be read
+    uint64_t fileSize = m_file.Size();
+    if (fileSize < sizeof(BackgroundCacheHeader))
+    {
+        m_file.Close();
+        return false;
+    }
+
+    const BackgroundCacheHeader* header = (const BackgroundCacheHeader*)m_file.Data();
+    bool valid = header->magic == BackgroundCacheMagic &&
+        header->version == BackgroundCacheVersion &&
+        header->format < BackgroundCacheFormat_COUNT &&
+        header->sourceHash == sourceHash &&
+        header->sourceSize == sourceSize &&
+        header->width > 0 && header->height > 0 &&
+        header->mipCount > 0 && header->mipCount <= BackgroundCacheMaxMips &&
+        (int)header->mipCount <= GetBackgroundMipCount(header->width, header->height);
+
+    // Every mip must have the dimensions and pitch we would have written, and lie inside the file.
+    // Offset plus size may wrap around, the end is checked against what is left after the offset.
+    BackgroundCacheFormat format = (BackgroundCacheFormat)header->format;
+    for (uint32_t i = 0; valid && i < header->mipCount; i++)
+    {
+        const BackgroundCacheMip& mip = header->mips[i];
+        uint32_t width = header->width >> i ? header->width >> i : 1;
+        uint32_t height = header->height >> i ? header->height >> i : 1;
+        valid = mip.width == width && mip.height == height &&
+            mip.rowPitch == GetRowPitch(format, width) &&
+            mip.size == (uint64_t)mip.rowPitch * GetRowCount(format, height) &&
+            mip.offset % CacheAlignment == 0 &&
+            mip.offset >= sizeof(BackgroundCacheHeader) &&
+            mip.offset <= fileSize && mip.size <= fileSize - mip.offset;
+    }
+
+    if (!valid)
+    {
+        m_file.Close();
+        return false;
+    }
+    m_header = header;
+    return true;
+}
+
+void BackgroundCacheFile::Close()
+{
+    m_file.Close();
+    m_header = nullptr;
+}
+
+uint64_t HashBackgroundSource(const void* data, size_t size)
+{
+    // FNV-1a, plenty for telling two versions of a wallpaper apart
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string GetBackgroundCachePath(const char* sourcePath)
+{
+    return std::string(sourcePath) + ".lgbc";
+}
+
+int GetBackgroundMipCount(int width, int height)
+{
+    int count = 1;
+    while ((width > 1 || height > 1) && count < BackgroundCacheMaxMips)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        count++;
+    }
+    return count;
+}
+
+void BuildBackgroundMipChain(const unsigned char* rgba, int width, int height, BackgroundMipChain* chain)
+{
+    int mipCount = GetBackgroundMipCount(width, height);
+    chain->format = BackgroundCacheFormat_RGBA8;
+    chain->width = width;
+    chain->height = height;
+    chain->mips.resize(mipCount);
+
+    uint64_t offset = 0;
+    for (int i = 0; i < mipCount; i++)
+    {
+        BackgroundCacheMip& mip = chain->mips[i];
+        mip.width = width >> i ? width >> i : 1;
+        mip.height = height >> i ? height >> i : 1;
+        mip.rowPitch = mip.width * 4;
+        mip.size = mip.rowPitch * mip.height;
+        mip.offset = offset;
+        offset = AlignUp(offset + mip.size, CacheAlignment);
+    }
+    chain->pixels.resize((size_t)offset);
+    memcpy(chain->pixels.data(), rgba, chain->mips[0].size);
+
+    // 2x2 box filter from the previous level; odd edges reuse the last row/column
+    for (int i = 1; i < mipCount; i++)
+    {
+        const BackgroundCacheMip& src = chain->mips[i - 1];
+        const BackgroundCacheMip& dst = chain->mips[i];
+        const unsigned char* srcPixels = chain->pixels.data() + src.offset;
+        unsigned char* dstPixels = chain->pixels.data() + dst.offset;
+        for (uint32_t y = 0; y < dst.height; y++)
+        {
+            const unsigned char* row0 = srcPixels + (size_t)(y * 2) * src.rowPitch;
+            const unsigned char* row1 = srcPixels + (size_t)(y * 2 + 1 < src.height ? y * 2 + 1 : y * 2) * src.rowPitch;
+            unsigned char* out = dstPixels + (size_t)y * dst.rowPitch;
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                uint32_t x0 = x * 2 * 4;
+                uint32_t x1 = (x * 2 + 1 < src.width ? x * 2 + 1 : x * 2) * 4;
+                for (int c = 0; c < 4; c++)
+                    out[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+bool WriteBackgroundCache(const char* path, const BackgroundMipChain& chain, uint64_t sourceHash, uint64_t sourceSize)
+{
+    if (chain.mips.empty() || chain.mips.size() > BackgroundCacheMaxMips)
+        return false;
+
+    BackgroundCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BackgroundCacheMagic;
+    header.version = BackgroundCacheVersion;
+    header.format = chain.format;
+    header.mipCount = (uint32_t)chain.mips.size();
+    header.width = chain.width;
+    header.height = chain.height;
+    header.sourceSize = sourceSize;
+    header.sourceHash = sourceHash;
+
+    // Payload keeps its in-memory layout, shifted past the header
+    uint64_t payloadOffset = AlignUp(sizeof(header), CacheAlignment);
+    for (size_t i = 0; i < chain.mips.size(); i++)
+    {
+        header.mips[i] = chain.mips[i];
+        header.mips[i].offset += payloadOffset;
+    }
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE* f = fopen(tempPath.c_str(), "wb");
+    if (!f)
+        return false;
+
+    static const unsigned char padding[CacheAlignment] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(padding, 1, (size_t)(payloadOffset - sizeof(header)), f) == payloadOffset - sizeof(header) &&
+        fwrite(chain.pixels.data(), 1, chain.pixels.size(), f) == chain.pixels.size();
+    ok = (fclose(f) == 0) && ok;
+
+    // rename() does not replace an existing file on Windows
+    if (ok)
+    {
+        remove(path);
+        ok = rename(tempPath.c_str(), path) == 0;
+    }
+    if (!ok)
+        remove(tempPath.c_str());
+    return ok;
+}
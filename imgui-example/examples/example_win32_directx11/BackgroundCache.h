@@ -0,0 +1,88 @@
+#pragma once
+#include "MappedFile.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Pre-baked background cache (.lgbc): the decoded image plus its full mip
+// chain, stored next to the source file so later launches can map it and
+// hand the mips to the GPU without decoding anything.
+//
+// Layout (little endian): BackgroundCacheHeader, then every mip level at a
+// 16-byte aligned offset. The header records the size and a 64-bit hash of
+// the source file, a cache whose source changed is rejected on open.
+
+enum BackgroundCacheFormat
+{
+    BackgroundCacheFormat_RGBA8 = 0,
+    BackgroundCacheFormat_BC1 = 1,      // 8 bytes per 4x4 block
+    BackgroundCacheFormat_BC7 = 2,      // 16 bytes per 4x4 block
+    BackgroundCacheFormat_COUNT
+};
+
+enum
+{
+    BackgroundCacheMagic = 0x4342474C,  // "LGBC"
+    BackgroundCacheVersion = 1,
+    BackgroundCacheMaxMips = 16,
+};
+
+struct BackgroundCacheMip
+{
+    uint64_t offset;        // From the start of the file (or of the pixel buffer in memory)
+    uint32_t size;
+    uint32_t rowPitch;      // Bytes per row of texels, or per row of 4x4 blocks
+    uint32_t width;
+    uint32_t height;
+};
+
+struct BackgroundCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t mipCount;
+    uint32_t width;
+    uint32_t height;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    BackgroundCacheMip mips[BackgroundCacheMaxMips];
+};
+
+// Decoded background with its mip chain, mip offsets are relative to pixels
+struct BackgroundMipChain
+{
+    BackgroundCacheFormat format;
+    int width;
+    int height;
+    std::vector<BackgroundCacheMip> mips;
+    std::vector<unsigned char> pixels;
+};
+
+// Validated, memory-mapped cache file
+class BackgroundCacheFile
+{
+public:
+    BackgroundCacheFile();
+
+    // Fails if the file is missing, malformed, or was baked from a different source
+    bool Open(const char* path, uint64_t sourceHash, uint64_t sourceSize);
+    void Close();
+
+    const BackgroundCacheHeader& Header() const { return *m_header; }
+    const unsigned char* Base() const { return m_file.Data(); }
+
+private:
+    MappedFile m_file;
+    const BackgroundCacheHeader* m_header;
+};
+
+uint64_t HashBackgroundSource(const void* data, size_t size);
+std::string GetBackgroundCachePath(const char* sourcePath);
+int GetBackgroundMipCount(int width, int height);
+
+// Box-filters a full mip chain out of tightly packed RGBA8 pixels
+void BuildBackgroundMipChain(const unsigned char* rgba, int width, int height, BackgroundMipChain* chain);
+
+// Writes through a temporary file so a crash never leaves a truncated cache behind
+bool WriteBackgroundCache(const char* path, const BackgroundMipChain& chain, uint64_t sourceHash, uint64_t sourceSize);
@@ -0,0 +1,531 @@
+#include "BlockCompress.h"
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCKCOMPRESS_SSE2
+#include <emmintrin.h>
+#endif
+
+static const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static int Clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Picks the nearest palette entry (squared RGBA distance) for each of the 16 pixels
+// and returns the summed error. paletteSize is 4 or 16.
+static uint32_t SelectIndices(const unsigned char* pixels, const int (*palette)[4], int paletteSize, unsigned char* indices)
+{
+    uint32_t total = 0;
+#ifdef BLOCKCOMPRESS_SSE2
+    // Palette as interleaved 16-bit (r,g) and (b,a) pairs, 4 entries per register.
+    // madd(d, d) then gives dr^2+dg^2 per entry; the entry index is packed into the
+    // low 4 bits of the error so a single min finds both.
+    __m128i palRG[4], palBA[4], lane[4];
+    int groups = paletteSize / 4;
+    for (int j = 0; j < groups; j++)
+    {
+        const int* p0 = palette[j * 4 + 0];
+        const int* p1 = palette[j * 4 + 1];
+        const int* p2 = palette[j * 4 + 2];
+        const int* p3 = palette[j * 4 + 3];
+        palRG[j] = _mm_setr_epi16((short)p0[0], (short)p0[1], (short)p1[0], (short)p1[1], (short)p2[0], (short)p2[1], (short)p3[0], (short)p3[1]);
+        palBA[j] = _mm_setr_epi16((short)p0[2], (short)p0[3], (short)p1[2], (short)p1[3], (short)p2[2], (short)p2[3], (short)p3[2], (short)p3[3]);
+        lane[j] = _mm_setr_epi32(j * 4 + 0, j * 4 + 1, j * 4 + 2, j * 4 + 3);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        const unsigned char* p = pixels + i * 4;
+        __m128i pixRG = _mm_set1_epi32(p[0] | (p[1] << 16));
+        __m128i pixBA = _mm_set1_epi32(p[2] | (p[3] << 16));
+        __m128i best = _mm_set1_epi32(0x7fffffff);
+        for (int j = 0; j < groups; j++)
+        {
+            __m128i dRG = _mm_sub_epi16(palRG[j], pixRG);
+            __m128i dBA = _mm_sub_epi16(palBA[j], pixBA);
+            __m128i err = _mm_add_epi32(_mm_madd_epi16(dRG, dRG), _mm_madd_epi16(dBA, dBA));
+            __m128i key = _mm_or_si128(_mm_slli_epi32(err, 4), lane[j]);
+            __m128i less = _mm_cmplt_epi32(key, best);
+            best = _mm_or_si128(_mm_and_si128(less, key), _mm_andnot_si128(less, best));
+        }
+        // Horizontal min of the 4 lanes
+        for (int shift = 0; shift < 2; shift++)
+        {
+            __m128i other = shift == 0 ? _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)) : _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128i less = _mm_cmplt_epi32(other, best);
+            best = _mm_or_si128(_mm_and_si128(less, other), _mm_andnot_si128(less, best));
+        }
+        int key = _mm_cvtsi128_si32(best);
+        indices[i] = (unsigned char)(key & 15);
+        total += (uint32_t)key >> 4;
+    }
+#else
+    for (int i = 0; i < 16; i++)
+    {
+        const unsigned char* p = pixels + i * 4;
+        int bestError = 0x7fffffff, bestIndex = 0;
+        for (int j = 0; j < paletteSize; j++)
+        {
+            int dr = palette[j][0] - p[0], dg = palette[j][1] - p[1], db = palette[j][2] - p[2], da = palette[j][3] - p[3];
+            int err = dr * dr + dg * dg + db * db + da * da;
+            if (err < bestError)
+            {
+                bestError = err;
+                bestIndex = j;
+            }
+        }
+        indices[i] = (unsigned char)bestIndex;
+        total += (uint32_t)bestError;
+    }
+#endif
+    return total;
+}
+
+// Endpoints at the extremes of the pixels' projection on their principal axis
+static void FitEndpointsPCA(const unsigned char* pixels, int channels, float* e0, float* e1)
+{
+    float mean[4] = {};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < channels; c++)
+            mean[c] += pixels[i * 4 + c];
+    for (int c = 0; c < channels; c++)
+        mean[c] /= 16.0f;
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; i++)
+        for (int a = 0; a < channels; a++)
+            for (int b = a; b < channels; b++)
+                cov[a][b] += (pixels[i * 4 + a] - mean[a]) * (pixels[i * 4 + b] - mean[b]);
+    for (int a = 0; a < channels; a++)
+        for (int b = 0; b < a; b++)
+            cov[a][b] = cov[b][a];
+
+    // Power iteration, seeded with the covariance row of the widest channel
+    int widest = 0;
+    for (int c = 1; c < channels; c++)
+        if (cov[c][c] > cov[widest][widest])
+            widest = c;
+    float axis[4] = {};
+    for (int c = 0; c < channels; c++)
+        axis[c] = cov[widest][c];
+    for (int iter = 0; iter < 8; iter++)
+    {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < channels; a++)
+        {
+            for (int b = 0; b < channels; b++)
+                next[a] += cov[a][b] * axis[b];
+            length = fmaxf(length, fabsf(next[a]));
+        }
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < channels; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float minT = 0.0f, maxT = 0.0f;
+    float axisLength2 = 0.0f;
+    for (int c = 0; c < channels; c++)
+        axisLength2 += axis[c] * axis[c];
+    if (axisLength2 > 1e-12f)
+    {
+        minT = 1e30f;
+        maxT = -1e30f;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++)
+                t += (pixels[i * 4 + c] - mean[c]) * axis[c];
+            t /= axisLength2;
+            minT = fminf(minT, t);
+            maxT = fmaxf(maxT, t);
+        }
+    }
+    for (int c = 0; c < channels; c++)
+    {
+        e0[c] = mean[c] + axis[c] * maxT;
+        e1[c] = mean[c] + axis[c] * minT;
+    }
+}
+
+// Least-squares endpoints for fixed indices: minimizes sum |w0_i*e0 + w1_i*e1 - p_i|^2
+static bool RefineEndpoints(const unsigned char* pixels, const unsigned char* indices, const float* weights, int channels, float* e0, float* e1)
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ap[4] = {}, bp[4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float w1 = weights[indices[i]];
+        float w0 = 1.0f - w1;
+        aa += w0 * w0;
+        ab += w0 * w1;
+        bb += w1 * w1;
+        for (int c = 0; c < channels; c++)
+        {
+            ap[c] += w0 * pixels[i * 4 + c];
+            bp[c] += w1 * pixels[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+        return false;
+    for (int c = 0; c < channels; c++)
+    {
+        e0[c] = fminf(255.0f, fmaxf(0.0f, (ap[c] * bb - bp[c] * ab) / det));
+        e1[c] = fminf(255.0f, fmaxf(0.0f, (bp[c] * aa - ap[c] * ab) / det));
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// BC1
+//-----------------------------------------------------------------------------
+
+static int Pack565(const float* color)
+{
+    int r = Clamp((int)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = Clamp((int)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = Clamp((int)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (r << 11) | (g << 5) | b;
+}
+
+static void Unpack565(int c, int* out)
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+    out[3] = 0;
+}
+
+// Palette in index order for the 4-color mode (c0 > c1)
+static void BuildPaletteBC1(int c0, int c1, int (*palette)[4])
+{
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+    palette[2][3] = palette[3][3] = 0;
+}
+
+// Encodes endpoints into 4-color mode and returns the block error
+static uint32_t EncodeBC1(const unsigned char* pixels, int c0, int c1, unsigned char* out)
+{
+    unsigned char indices[16];
+    uint32_t error;
+    if (c0 == c1)
+    {
+        // Flat block: every index 0 decodes to c0 in either mode
+        int palette[4][4];
+        BuildPaletteBC1(c0, c1, palette);
+        error = 0;
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                error += (uint32_t)((pixels[i * 4 + c] - palette[0][c]) * (pixels[i * 4 + c] - palette[0][c]));
+        memset(indices, 0, sizeof(indices));
+    }
+    else
+    {
+        if (c0 < c1)
+        {
+            int t = c0;
+            c0 = c1;
+            c1 = t;
+        }
+        int palette[4][4];
+        BuildPaletteBC1(c0, c1, palette);
+        error = SelectIndices(pixels, palette, 4, indices);
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; i++)
+        bits |= (uint32_t)indices[i] << (i * 2);
+    out[0] = (unsigned char)(c0 & 0xff);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xff);
+    out[3] = (unsigned char)(c1 >> 8);
+    memcpy(out + 4, &bits, 4);
+    return error;
+}
+
+void CompressBlockBC1(const unsigned char* pixels, unsigned char* out)
+{
+    // Alpha is ignored, backgrounds are opaque
+    unsigned char rgb[64];
+    for (int i = 0; i < 16; i++)
+    {
+        rgb[i * 4 + 0] = pixels[i * 4 + 0];
+        rgb[i * 4 + 1] = pixels[i * 4 + 1];
+        rgb[i * 4 + 2] = pixels[i * 4 + 2];
+        rgb[i * 4 + 3] = 0;
+    }
+
+    float e0[4], e1[4];
+    FitEndpointsPCA(rgb, 3, e0, e1);
+    uint32_t bestError = EncodeBC1(rgb, Pack565(e0), Pack565(e1), out);
+
+    // One least-squares pass on the chosen indices, kept only if it helps
+    static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    if (bestError > 0)
+    {
+        unsigned char indices[16];
+        uint32_t bits;
+        memcpy(&bits, out + 4, 4);
+        for (int i = 0; i < 16; i++)
+            indices[i] = (unsigned char)((bits >> (i * 2)) & 3);
+        if (RefineEndpoints(rgb, indices, weights, 3, e0, e1))
+        {
+            unsigned char candidate[8];
+            uint32_t error = EncodeBC1(rgb, Pack565(e0), Pack565(e1), candidate);
+            if (error < bestError)
+                memcpy(out, candidate, 8);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// BC7 mode 6
+//-----------------------------------------------------------------------------
+
+struct BC7Endpoints
+{
+    int q[2][4];    // 7-bit quantized RGBA
+    int p[2];       // p-bits
+};
+
+// Picks the 7-bit value and p-bit for each endpoint that best reproduces it
+static void QuantizeBC7(const float* e0, const float* e1, BC7Endpoints* ep)
+{
+    const float* e[2] = { e0, e1 };
+    for (int k = 0; k < 2; k++)
+    {
+        float bestError = 1e30f;
+        for (int p = 0; p < 2; p++)
+        {
+            int q[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++)
+            {
+                q[c] = Clamp((int)floorf((e[k][c] - p) * 0.5f + 0.5f), 0, 127);
+                float d = (float)((q[c] << 1) | p) - e[k][c];
+                error += d * d;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                ep->p[k] = p;
+                memcpy(ep->q[k], q, sizeof(q));
+            }
+        }
+    }
+}
+
+static uint32_t SelectIndicesBC7(const unsigned char* pixels, const BC7Endpoints& ep, unsigned char* indices)
+{
+    int a[4], b[4];
+    for (int c = 0; c < 4; c++)
+    {
+        a[c] = (ep.q[0][c] << 1) | ep.p[0];
+        b[c] = (ep.q[1][c] << 1) | ep.p[1];
+    }
+    int palette[16][4];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++)
+            palette[i][c] = ((64 - BC7Weights4[i]) * a[c] + BC7Weights4[i] * b[c] + 32) >> 6;
+    return SelectIndices(pixels, palette, 16, indices);
+}
+
+// Little-endian bit writer over the 128-bit block
+static void WriteBits(unsigned char* out, int* pos, uint32_t value, int count)
+{
+    for (int i = 0; i < count; i++, (*pos)++)
+        if (value & (1u << i))
+            out[*pos >> 3] |= (unsigned char)(1 << (*pos & 7));
+}
+
+static void EmitBC7Mode6(const BC7Endpoints& source, const unsigned char* sourceIndices, unsigned char* out)
+{
+    // The anchor (pixel 0) index is stored with an implicit 0 MSB, swap endpoints if needed
+    BC7Endpoints ep = source;
+    unsigned char indices[16];
+    memcpy(indices, sourceIndices, 16);
+    if (indices[0] & 8)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int t = ep.q[0][c];
+            ep.q[0][c] = ep.q[1][c];
+            ep.q[1][c] = t;
+        }
+        int t = ep.p[0];
+        ep.p[0] = ep.p[1];
+        ep.p[1] = t;
+        for (int i = 0; i < 16; i++)
+            indices[i] = (unsigned char)(15 - indices[i]);
+    }
+
+    memset(out, 0, 16);
+    int pos = 0;
+    WriteBits(out, &pos, 1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        WriteBits(out, &pos, ep.q[0][c], 7);
+        WriteBits(out, &pos, ep.q[1][c], 7);
+    }
+    WriteBits(out, &pos, ep.p[0], 1);
+    WriteBits(out, &pos, ep.p[1], 1);
+    WriteBits(out, &pos, indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        WriteBits(out, &pos, indices[i], 4);
+}
+
+void CompressBlockBC7(const unsigned char* pixels, unsigned char* out)
+{
+    float e0[4], e1[4];
+    FitEndpointsPCA(pixels, 4, e0, e1);
+
+    BC7Endpoints best;
+    unsigned char bestIndices[16];
+    QuantizeBC7(e0, e1, &best);
+    uint32_t bestError = SelectIndicesBC7(pixels, best, bestIndices);
+
+    float weights[16];
+    for (int i = 0; i < 16; i++)
+        weights[i] = BC7Weights4[i] / 64.0f;
+
+    for (int iter = 0; iter < 2 && bestError > 0; iter++)
+    {
+        if (!RefineEndpoints(pixels, bestIndices, weights, 4, e0, e1))
+            break;
+        BC7Endpoints ep;
+        unsigned char indices[16];
+        QuantizeBC7(e0, e1, &ep);
+        uint32_t error = SelectIndicesBC7(pixels, ep, indices);
+        if (error >= bestError)
+            break;
+        best = ep;
+        bestError = error;
+        memcpy(bestIndices, indices, 16);
+    }
+
+    EmitBC7Mode6(best, bestIndices, out);
+}
+
+//-----------------------------------------------------------------------------
+// Mip chains
+//-----------------------------------------------------------------------------
+
+void PadImageToBlockSize(const unsigned char* rgba, int width, int height, std::vector<unsigned char>* padded, int* paddedWidth, int* paddedHeight)
+{
+    *paddedWidth = (width + 3) & ~3;
+    *paddedHeight = (height + 3) & ~3;
+    padded->resize((size_t)*paddedWidth * *paddedHeight * 4);
+    for (int y = 0; y < *paddedHeight; y++)
+    {
+        const unsigned char* src = rgba + (size_t)(y < height ? y : height - 1) * width * 4;
+        unsigned char* dst = padded->data() + (size_t)y * *paddedWidth * 4;
+        memcpy(dst, src, (size_t)width * 4);
+        for (int x = width; x < *paddedWidth; x++)
+            memcpy(dst + x * 4, src + (width - 1) * 4, 4);
+    }
+}
+
+bool CompressBackgroundMipChain(const BackgroundMipChain& source, BackgroundCacheFormat format, BackgroundMipChain* compressed, int threadCount)
+{
+    if (source.format != BackgroundCacheFormat_RGBA8 || source.mips.empty() ||
+        (format != BackgroundCacheFormat_BC1 && format != BackgroundCacheFormat_BC7) ||
+        (source.width & 3) != 0 || (source.height & 3) != 0)
+        return false;
+
+    int blockBytes = format == BackgroundCacheFormat_BC1 ? 8 : 16;
+    compressed->format = format;
+    compressed->width = source.width;
+    compressed->height = source.height;
+    compressed->mips.resize(source.mips.size());
+
+    // Work items are rows of blocks across all mips, handed out through an atomic counter
+    struct BlockRow { int mip; uint32_t row; };
+    std::vector<BlockRow> rows;
+    uint64_t offset = 0;
+    for (size_t i = 0; i < source.mips.size(); i++)
+    {
+        BackgroundCacheMip& mip = compressed->mips[i];
+        mip.width = source.mips[i].width;
+        mip.height = source.mips[i].height;
+        mip.rowPitch = ((mip.width + 3) / 4) * blockBytes;
+        mip.size = mip.rowPitch * ((mip.height + 3) / 4);
+        mip.offset = offset;
+        offset = (offset + mip.size + 15) & ~15ULL;
+        for (uint32_t row = 0; row < (mip.height + 3) / 4; row++)
+            rows.push_back({ (int)i, row });
+    }
+    compressed->pixels.assign((size_t)offset, 0);
+
+    std::atomic<size_t> nextRow(0);
+    auto worker = [&]()
+    {
+        unsigned char block[64];
+        for (size_t r = nextRow++; r < rows.size(); r = nextRow++)
+        {
+            const BackgroundCacheMip& src = source.mips[rows[r].mip];
+            const BackgroundCacheMip& dst = compressed->mips[rows[r].mip];
+            const unsigned char* srcPixels = source.pixels.data() + src.offset;
+            unsigned char* out = compressed->pixels.data() + dst.offset + (size_t)rows[r].row * dst.rowPitch;
+            for (uint32_t bx = 0; bx < (dst.width + 3) / 4; bx++, out += blockBytes)
+            {
+                // Small mips (2x2, 1x1...) replicate their edge texels into the block
+                for (int y = 0; y < 4; y++)
+                {
+                    uint32_t sy = rows[r].row * 4 + y;
+                    sy = sy < src.height ? sy : src.height - 1;
+                    for (int x = 0; x < 4; x++)
+                    {
+                        uint32_t sx = bx * 4 + x;
+                        sx = sx < src.width ? sx : src.width - 1;
+                        memcpy(block + (y * 4 + x) * 4, srcPixels + (size_t)sy * src.rowPitch + sx * 4, 4);
+                    }
+                }
+                if (format == BackgroundCacheFormat_BC1)
+                    CompressBlockBC1(block, out);
+                else
+                    CompressBlockBC7(block, out);
+            }
+        }
+    };
+
+    if (threadCount <= 0)
+        threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0)
+        threadCount = 1;
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    return true;
+}
+
+bool BuildBackgroundMipChain(const unsigned char* rgba, int width, int height, BackgroundCacheFormat format, BackgroundMipChain* chain, int threadCount)
+{
+    if (format == BackgroundCacheFormat_RGBA8)
+    {
+        BuildBackgroundMipChain(rgba, width, height, chain);
+        return true;
+    }
+
+    std::vector<unsigned char> padded;
+    int paddedWidth, paddedHeight;
+    PadImageToBlockSize(rgba, width, height, &padded, &paddedWidth, &paddedHeight);
+    BackgroundMipChain source;
+    BuildBackgroundMipChain(padded.data(), paddedWidth, paddedHeight, &source);
+    return CompressBackgroundMipChain(source, format, chain, threadCount);
+}
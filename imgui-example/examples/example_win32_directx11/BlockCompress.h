@@ -0,0 +1,23 @@
+#pragma once
+#include "BackgroundCache.h"
+
+// CPU block compression for background textures.
+// - BC1: 4 bpp, principal-axis endpoints with one least-squares refinement. Fast.
+// - BC7: 8 bpp, mode 6 only (single subset, 7.7.7.7 + p-bit endpoints, 4-bit indices),
+//   two least-squares refinements and per-endpoint p-bit search. Quality.
+// Index selection uses SSE2 where available, blocks are spread over worker threads.
+
+// Encode one 4x4 block of RGBA8 pixels (row-major, 64 bytes)
+void CompressBlockBC1(const unsigned char* pixels, unsigned char* out);
+void CompressBlockBC7(const unsigned char* pixels, unsigned char* out);
+
+// BC textures need a top level that is a multiple of 4, edges are replicated
+void PadImageToBlockSize(const unsigned char* rgba, int width, int height, std::vector<unsigned char>* padded, int* paddedWidth, int* paddedHeight);
+
+// Encodes every mip of an RGBA8 chain into a BC1 or BC7 chain with the same dimensions.
+// threadCount <= 0 uses every hardware thread.
+bool CompressBackgroundMipChain(const BackgroundMipChain& source, BackgroundCacheFormat format, BackgroundMipChain* compressed, int threadCount = 0);
+
+// Decoded RGBA8 pixels to a ready-to-upload chain in the requested format, padding
+// the top level to whole blocks for BC1/BC7
+bool BuildBackgroundMipChain(const unsigned char* rgba, int width, int height, BackgroundCacheFormat format, BackgroundMipChain* chain, int threadCount = 0);
@@ -0,0 +1,100 @@
+#include "ConstantRing.h"
+#include <string.h>
+
+ConstantRing::ConstantRing()
+{
+    m_buffer = nullptr;
+    m_noOverwrite = false;
+    m_position = 0;
+    m_batchStart = 0;
+    m_generation = 0;
+    m_discard = true;
+    m_maps = 0;
+    m_allocations = 0;
+}
+
+ConstantRing::~ConstantRing()
+{
+    Release();
+}
+
+bool ConstantRing::Create(ID3D11Device* device)
+{
+    Release();
+
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) || !options.ConstantBufferOffsetting)
+        return false;
+    m_noOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != FALSE;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = Size;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateBuffer(&desc, nullptr, &m_buffer)))
+        return false;
+    m_batch.reserve(MaxBatchSize);
+    m_position = 0;
+    m_batchStart = 0;
+    m_generation++;
+    m_discard = true;
+    return true;
+}
+
+void ConstantRing::Release()
+{
+    if (m_buffer) m_buffer->Release();
+    m_buffer = nullptr;
+}
+
+void ConstantRing::BeginBatch()
+{
+    m_batch.clear();
+    if (!m_noOverwrite || m_position + MaxBatchSize > Size)
+    {
+        m_position = 0;
+        m_generation++;
+        m_discard = true;
+    }
+    m_batchStart = m_position;
+}
+
+void ConstantRing::Allocate(const void* data, UINT size, ConstantRange& range)
+{
+    UINT alignedSize = (size + Alignment - 1) & ~(UINT)(Alignment - 1);
+    if (m_batch.size() + alignedSize > MaxBatchSize)
+        return;
+    size_t offset = m_batch.size();
+    m_batch.resize(offset + alignedSize, 0);
+    memcpy(m_batch.data() + offset, data, size);
+
+    range.buffer = m_buffer;
+    range.firstConstant = m_position / 16;
+    range.numConstants = alignedSize / 16;
+    range.generation = m_generation;
+    m_position += alignedSize;
+    m_allocations++;
+}
+
+void ConstantRing::Flush(ID3D11DeviceContext* context)
+{
+    if (m_batch.empty())
+        return;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(context->Map(m_buffer, 0, m_discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped)))
+    {
+        memcpy((unsigned char*)mapped.pData + m_batchStart, m_batch.data(), m_batch.size());
+        context->Unmap(m_buffer, 0);
+        m_maps++;
+    }
+    m_discard = false;
+    m_batchStart = m_position;
+    m_batch.clear();
+}
+
+void ConstantRing::ResetStats()
+{
+    m_maps = 0;
+    m_allocations = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <d3d11_1.h>
+#include <vector>
+
+// Per-frame constants in one dynamic buffer, bound by range (*SetConstantBuffers1).
+//
+// Passes write their constants in batches: BeginBatch(), Allocate() for every range that
+// changed, Flush() before the draws, one Map/Unmap for the whole batch. New ranges are
+// appended with NO_OVERWRITE, so what earlier draws read stays intact, and a range that did
+// not change keeps being bound where it was written. Once the buffer is full the next batch
+// starts over at the front with a DISCARD map, which makes every older range stale
+// (IsCurrent()) and has its owner write it again.
+//
+// Needs Direct3D 11.1 constant buffer offsets. Where constant buffers can't be mapped with
+// NO_OVERWRITE every batch starts over, ranges then only live until the next batch.
+
+// A pass's constants inside the ring, in the 16-byte constants *SetConstantBuffers1 takes
+struct ConstantRange
+{
+    ID3D11Buffer* buffer;   // Null until allocated
+    UINT firstConstant;
+    UINT numConstants;
+    UINT generation;        // Ring wrap it was written in
+};
+
+class ConstantRing
+{
+public:
+    enum
+    {
+        Size = 64 * 1024,
+        Alignment = 256,        // Offsets and sizes are multiples of 16 constants
+        MaxBatchSize = 4096,    // Bytes a batch may allocate
+    };
+
+    ConstantRing();
+    ~ConstantRing();
+
+    bool Create(ID3D11Device* device);
+    void Release();
+
+    void BeginBatch();
+    // Copies size bytes into the batch and points range at where Flush() writes them, past
+    // MaxBatchSize bytes in a batch the range is left as it was
+    void Allocate(const void* data, UINT size, ConstantRange& range);
+    void Flush(ID3D11DeviceContext* context);
+    bool IsCurrent(const ConstantRange& range) const { return range.buffer && range.generation == m_generation; }
+
+    // Map/Unmap pairs and ranges written since the last ResetStats()
+    int GetMaps() const { return m_maps; }
+    int GetAllocations() const { return m_allocations; }
+    void ResetStats();
+
+private:
+    ID3D11Buffer* m_buffer;
+    bool m_noOverwrite;
+    UINT m_position;        // Next free byte
+    UINT m_batchStart;      // First byte of the batch, not written to the buffer yet
+    UINT m_generation;
+    bool m_discard;         // The next map starts a fresh buffer
+    std::vector<unsigned char> m_batch;
+    int m_maps;
+    int m_allocations;
+};
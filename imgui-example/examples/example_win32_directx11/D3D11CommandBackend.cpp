@@ -0,0 +1,147 @@
+#include "D3D11CommandBackend.h"
+#include "FrameProfiler.h"
+#include <string.h>
+
+D3D11CommandBackend::D3D11CommandBackend()
+{
+    m_context = nullptr;
+    m_profiler = nullptr;
+}
+
+void D3D11CommandBackend::Initialize(ID3D11DeviceContext1* context, FrameProfiler* profiler)
+{
+    m_context = context;
+    m_profiler = profiler;
+}
+
+void D3D11CommandBackend::ApplyTargets(int count, const GlassHandle* targets)
+{
+    ID3D11RenderTargetView* views[GlassMaxTargets];
+    for (int i = 0; i < count; i++)
+        views[i] = (ID3D11RenderTargetView*)targets[i];
+    m_context->OMSetRenderTargets(count, views, nullptr);
+}
+
+void D3D11CommandBackend::ApplyClear(GlassHandle target, const float color[4])
+{
+    m_context->ClearRenderTargetView((ID3D11RenderTargetView*)target, color);
+}
+
+void D3D11CommandBackend::ApplyViewport(float width, float height)
+{
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = width;
+    viewport.Height = height;
+    viewport.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &viewport);
+}
+
+void D3D11CommandBackend::ApplyScissor(const float rect[4])
+{
+    D3D11_RECT scissor = { (LONG)rect[0], (LONG)rect[1], (LONG)rect[2], (LONG)rect[3] };
+    m_context->RSSetScissorRects(1, &scissor);
+}
+
+void D3D11CommandBackend::ApplyInputLayout(GlassHandle inputLayout)
+{
+    m_context->IASetInputLayout((ID3D11InputLayout*)inputLayout);
+}
+
+void D3D11CommandBackend::ApplyVertexShader(GlassHandle shader)
+{
+    m_context->VSSetShader((ID3D11VertexShader*)shader, nullptr, 0);
+}
+
+void D3D11CommandBackend::ApplyPixelShader(GlassHandle shader)
+{
+    m_context->PSSetShader((ID3D11PixelShader*)shader, nullptr, 0);
+}
+
+void D3D11CommandBackend::ApplyBlendState(GlassHandle state)
+{
+    m_context->OMSetBlendState((ID3D11BlendState*)state, nullptr, 0xFFFFFFFF);
+}
+
+void D3D11CommandBackend::ApplyDepthStencilState(GlassHandle state)
+{
+    m_context->OMSetDepthStencilState((ID3D11DepthStencilState*)state, 0);
+}
+
+void D3D11CommandBackend::ApplyRasterizerState(GlassHandle state)
+{
+    m_context->RSSetState((ID3D11RasterizerState*)state);
+}
+
+void D3D11CommandBackend::ApplyTexture(int slot, GlassHandle texture)
+{
+    ID3D11ShaderResourceView* view = (ID3D11ShaderResourceView*)texture;
+    m_context->PSSetShaderResources(slot, 1, &view);
+}
+
+void D3D11CommandBackend::ApplySampler(int slot, GlassHandle sampler)
+{
+    ID3D11SamplerState* state = (ID3D11SamplerState*)sampler;
+    m_context->PSSetSamplers(slot, 1, &state);
+}
+
+void D3D11CommandBackend::ApplyConstants(GlassShaderStage stage, int slot, GlassHandle buffer)
+{
+    ID3D11Buffer* constants = (ID3D11Buffer*)buffer;
+    if (stage == GlassStage_Vertex)
+        m_context->VSSetConstantBuffers(slot, 1, &constants);
+    else
+        m_context->PSSetConstantBuffers(slot, 1, &constants);
+}
+
+void D3D11CommandBackend::ApplyConstantRange(GlassShaderStage stage, int slot, GlassHandle range)
+{
+    const ConstantRange* constants = (const ConstantRange*)range;
+    if (stage == GlassStage_Vertex)
+        m_context->VSSetConstantBuffers1(slot, 1, &constants->buffer, &constants->firstConstant, &constants->numConstants);
+    else
+        m_context->PSSetConstantBuffers1(slot, 1, &constants->buffer, &constants->firstConstant, &constants->numConstants);
+}
+
+void D3D11CommandBackend::ApplyUpload(GlassHandle buffer, const void* data, size_t size)
+{
+    ID3D11Buffer* constants = (ID3D11Buffer*)buffer;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(constants, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        return;
+    memcpy(mapped.pData, data, size);
+    m_context->Unmap(constants, 0);
+}
+
+void D3D11CommandBackend::ApplyGeometry(GlassHandle vertexBuffer, int stride, GlassHandle indexBuffer)
+{
+    ID3D11Buffer* vertices = (ID3D11Buffer*)vertexBuffer;
+    UINT vertexStride = (UINT)stride;
+    UINT offset = 0;
+    m_context->IASetVertexBuffers(0, 1, &vertices, &vertexStride, &offset);
+    m_context->IASetIndexBuffer((ID3D11Buffer*)indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D11CommandBackend::ApplyDraw(int vertexCount)
+{
+    m_context->Draw(vertexCount, 0);
+}
+
+void D3D11CommandBackend::ApplyDrawIndexed(int indexCount)
+{
+    m_context->DrawIndexed(indexCount, 0, 0);
+}
+
+void D3D11CommandBackend::ApplyBeginScope(const char* name)
+{
+    m_scopes.push_back(m_profiler ? m_profiler->BeginScope(m_context, name) : -1);
+}
+
+void D3D11CommandBackend::ApplyEndScope()
+{
+    if (m_scopes.empty())
+        return;
+    if (m_profiler)
+        m_profiler->EndScope(m_context, m_scopes.back());
+    m_scopes.pop_back();
+}
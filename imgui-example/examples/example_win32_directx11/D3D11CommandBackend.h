@@ -0,0 +1,45 @@
+#pragma once
+#include <d3d11_1.h>
+#include <vector>
+#include "ConstantRing.h"
+#include "GlassCommandList.h"
+
+class FrameProfiler;
+
+// GlassCommandBackend for an immediate context: handles are the ID3D11* objects and constant
+// ranges are ConstantRange, textures and constants bind to the pixel shader (constants to the
+// vertex shader too when asked), geometry is a triangle list. Scopes go to the profiler.
+class D3D11CommandBackend : public GlassCommandBackend
+{
+public:
+    D3D11CommandBackend();
+
+    void Initialize(ID3D11DeviceContext1* context, FrameProfiler* profiler);
+
+protected:
+    void ApplyTargets(int count, const GlassHandle* targets) override;
+    void ApplyClear(GlassHandle target, const float color[4]) override;
+    void ApplyViewport(float width, float height) override;
+    void ApplyScissor(const float rect[4]) override;
+    void ApplyInputLayout(GlassHandle inputLayout) override;
+    void ApplyVertexShader(GlassHandle shader) override;
+    void ApplyPixelShader(GlassHandle shader) override;
+    void ApplyBlendState(GlassHandle state) override;
+    void ApplyDepthStencilState(GlassHandle state) override;
+    void ApplyRasterizerState(GlassHandle state) override;
+    void ApplyTexture(int slot, GlassHandle texture) override;
+    void ApplySampler(int slot, GlassHandle sampler) override;
+    void ApplyConstants(GlassShaderStage stage, int slot, GlassHandle buffer) override;
+    void ApplyConstantRange(GlassShaderStage stage, int slot, GlassHandle range) override;
+    void ApplyUpload(GlassHandle buffer, const void* data, size_t size) override;
+    void ApplyGeometry(GlassHandle vertexBuffer, int stride, GlassHandle indexBuffer) override;
+    void ApplyDraw(int vertexCount) override;
+    void ApplyDrawIndexed(int indexCount) override;
+    void ApplyBeginScope(const char* name) override;
+    void ApplyEndScope() override;
+
+private:
+    ID3D11DeviceContext1* m_context;
+    FrameProfiler* m_profiler;
+    std::vector<int> m_scopes;      // Open profiler scopes
+};
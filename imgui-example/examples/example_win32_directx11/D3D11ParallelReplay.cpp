@@ -0,0 +1,188 @@
+#include "D3D11ParallelReplay.h"
+#include <string.h>
+
+D3D11ParallelReplay::D3D11ParallelReplay()
+{
+    for (int i = 0; i < MaxThreads; i++)
+    {
+        m_recorders[i].context = nullptr;
+        m_recorders[i].commands = nullptr;
+    }
+    m_threadCount = 0;
+    m_driverCommandLists = false;
+    m_job = 0;
+    m_pending = 0;
+    m_quit = false;
+}
+
+D3D11ParallelReplay::~D3D11ParallelReplay()
+{
+    Release();
+}
+
+bool D3D11ParallelReplay::Create(ID3D11Device* device, int threadCount)
+{
+    Release();
+    threadCount = threadCount < 1 ? 1 : threadCount > MaxThreads ? MaxThreads : threadCount;
+
+    D3D11_FEATURE_DATA_THREADING threading = {};
+    m_driverCommandLists = SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))) &&
+        threading.DriverCommandLists;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        Recorder& recorder = m_recorders[i];
+        ID3D11DeviceContext* deferred = nullptr;
+        if (FAILED(device->CreateDeferredContext(0, &deferred)))
+        {
+            Release();
+            return false;
+        }
+        HRESULT hr = deferred->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&recorder.context);
+        deferred->Release();
+        if (FAILED(hr))
+        {
+            recorder.context = nullptr;
+            Release();
+            return false;
+        }
+        recorder.backend.Initialize(recorder.context, nullptr);
+    }
+
+    m_threadCount = threadCount;
+    for (int i = 1; i < threadCount; i++)
+        m_workers.emplace_back(&D3D11ParallelReplay::WorkerMain, this, i, m_job);
+    return true;
+}
+
+void D3D11ParallelReplay::Release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_workers.size(); i++)
+        m_workers[i].join();
+    m_workers.clear();
+    m_quit = false;
+
+    for (int i = 0; i < MaxThreads; i++)
+    {
+        Recorder& recorder = m_recorders[i];
+        if (recorder.commands) recorder.commands->Release();
+        if (recorder.context) recorder.context->Release();
+        recorder.commands = nullptr;
+        recorder.context = nullptr;
+        recorder.runs.clear();
+    }
+    m_threadCount = 0;
+}
+
+void D3D11ParallelReplay::Replay(ID3D11DeviceContext* context, const GlassCommandList* const* lists, int listCount)
+{
+    if (m_threadCount == 0)
+        return;
+
+    // Every pass as a run of its own first
+    m_runs.clear();
+    size_t total = 0;
+    for (int l = 0; l < listCount; l++)
+    {
+        size_t size = lists[l]->GetCommands().size();
+        lists[l]->GetPasses(m_passes);
+        for (size_t p = 0; p < m_passes.size(); p++)
+        {
+            Run run = { lists[l], m_passes[p], p + 1 < m_passes.size() ? m_passes[p + 1] : size };
+            m_runs.push_back(run);
+        }
+        total += size;
+    }
+
+    // Then in order to the recorders, the next one once this one has its share. Passes of
+    // the same list that end up together replay as one.
+    for (int i = 0; i < m_threadCount; i++)
+        m_recorders[i].runs.clear();
+    int index = 0;
+    size_t dealt = 0;
+    for (size_t i = 0; i < m_runs.size(); i++)
+    {
+        const Run& run = m_runs[i];
+        while (index + 1 < m_threadCount && dealt >= total * (index + 1) / m_threadCount)
+            index++;
+        std::vector<Run>& runs = m_recorders[index].runs;
+        if (!runs.empty() && runs.back().list == run.list && runs.back().end == run.begin)
+            runs.back().end = run.end;
+        else
+            runs.push_back(run);
+        dealt += run.end - run.begin;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = m_threadCount - 1;
+        m_job++;
+    }
+    m_wake.notify_all();
+    Record(m_recorders[0]);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    for (int i = 0; i < m_threadCount; i++)
+    {
+        Recorder& recorder = m_recorders[i];
+        if (!recorder.commands)
+            continue;
+        context->ExecuteCommandList(recorder.commands, FALSE);
+        recorder.commands->Release();
+        recorder.commands = nullptr;
+    }
+}
+
+void D3D11ParallelReplay::Record(Recorder& recorder)
+{
+    if (recorder.runs.empty())
+        return;
+    recorder.backend.ForgetUploads();
+    for (size_t i = 0; i < recorder.runs.size(); i++)
+        recorder.backend.Replay(*recorder.runs[i].list, recorder.runs[i].begin, recorder.runs[i].end);
+    if (FAILED(recorder.context->FinishCommandList(FALSE, &recorder.commands)))
+        recorder.commands = nullptr;
+}
+
+void D3D11ParallelReplay::WorkerMain(int index, unsigned int job)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_quit || m_job != job; });
+            if (m_quit)
+                return;
+            job = m_job;
+        }
+        Record(m_recorders[index]);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_finished.notify_one();
+    }
+}
+
+GlassReplayStats D3D11ParallelReplay::GetStats() const
+{
+    GlassReplayStats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; i < m_threadCount; i++)
+        stats.Add(m_recorders[i].backend.GetStats());
+    return stats;
+}
+
+void D3D11ParallelReplay::ResetStats()
+{
+    for (int i = 0; i < MaxThreads; i++)
+        m_recorders[i].backend.ResetStats();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <d3d11_1.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "D3D11CommandBackend.h"
+
+// Replays command lists on several threads through deferred contexts.
+//
+// The passes of the lists (GlassCommandList::GetPasses()) are dealt out in order to the
+// recorders, a contiguous run each of about the same number of commands. Every recorder
+// replays its run into its own deferred context and finishes it into a D3D11 command list,
+// the calling thread records the first run itself. The command lists then execute on the
+// immediate context in recorder order, so the GPU gets the passes as a serial replay would
+// submit them.
+//
+// Deferred contexts start from cleared state and executing a command list clears the
+// immediate context's state, whatever draws next binds everything. Recorders don't profile,
+// the caller scopes the whole replay. Each replay writes every constant upload in its run:
+// a recorder can't know what the others wrote into a buffer since its last replay. A deferred
+// context only reads the dynamic buffers it mapped itself, so every pass of the lists must
+// write the constants it binds, and none may bind ranges mapped on another context (such as
+// a ConstantRing's): UpdateConstantsFrom() copies per-frame constants into a buffer instead.
+class D3D11ParallelReplay
+{
+public:
+    enum { MaxThreads = 8 };
+
+    D3D11ParallelReplay();
+    ~D3D11ParallelReplay();
+
+    // threadCount recorders, the calling thread being the first of them
+    bool Create(ID3D11Device* device, int threadCount);
+    void Release();
+    int GetThreadCount() const { return m_threadCount; }
+    bool HasDriverCommandLists() const { return m_driverCommandLists; }    // Otherwise the runtime emulates them
+
+    void Replay(ID3D11DeviceContext* context, const GlassCommandList* const* lists, int listCount);
+
+    // Summed over the recorders
+    GlassReplayStats GetStats() const;
+    void ResetStats();
+
+private:
+    // Commands [begin, end) of a list, whole passes
+    struct Run
+    {
+        const GlassCommandList* list;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Recorder
+    {
+        ID3D11DeviceContext1* context;      // Deferred
+        D3D11CommandBackend backend;
+        std::vector<Run> runs;
+        ID3D11CommandList* commands;        // Finished, until executed
+    };
+
+    D3D11ParallelReplay(const D3D11ParallelReplay&);
+    D3D11ParallelReplay& operator=(const D3D11ParallelReplay&);
+
+    void Record(Recorder& recorder);
+    void WorkerMain(int index, unsigned int job);
+
+    Recorder m_recorders[MaxThreads];
+    int m_threadCount;
+    bool m_driverCommandLists;
+    std::vector<Run> m_runs;
+    std::vector<size_t> m_passes;
+
+    std::vector<std::thread> m_workers;     // Recorders 1 and up
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    unsigned int m_job;                     // Bumped for every replay
+    int m_pending;                          // Workers still recording this job
+    bool m_quit;
+};
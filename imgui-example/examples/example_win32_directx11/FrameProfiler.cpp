@@ -0,0 +1,391 @@
+#include "FrameProfiler.h"
+#include "imgui.h"
+#include <algorithm>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+static int64_t GetCpuTicks()
+{
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+}
+
+FrameProfiler::FrameProfiler()
+{
+    for (int i = 0; i < FrameLatency; i++)
+    {
+        FrameSlot& slot = m_slots[i];
+        slot.disjoint = nullptr;
+        for (int j = 0; j < MaxScopes * 2; j++)
+            slot.timestamps[j] = nullptr;
+        slot.scopeCount = 0;
+        slot.frame = 0;
+        slot.cpuBegin = 0;
+        slot.pending = false;
+    }
+    m_slot = 0;
+    m_inFrame = false;
+    m_frameScope = -1;
+    m_frame = 0;
+    m_enabled = true;
+    m_created = false;
+    m_eventHead = 0;
+    m_droppedFrames = 0;
+    m_selectedPass = 0;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_cpuFrequency = frequency.QuadPart;
+    m_cpuOrigin = GetCpuTicks();
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    Release();
+}
+
+bool FrameProfiler::Create(ID3D11Device* device)
+{
+    Release();
+
+    D3D11_QUERY_DESC disjointDesc = {};
+    disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+    D3D11_QUERY_DESC timestampDesc = {};
+    timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+    for (int i = 0; i < FrameLatency; i++)
+    {
+        FrameSlot& slot = m_slots[i];
+        if (FAILED(device->CreateQuery(&disjointDesc, &slot.disjoint)))
+        {
+            Release();
+            return false;
+        }
+        for (int j = 0; j < MaxScopes * 2; j++)
+        {
+            if (FAILED(device->CreateQuery(&timestampDesc, &slot.timestamps[j])))
+            {
+                Release();
+                return false;
+            }
+        }
+    }
+    m_events.reserve(MaxEvents);
+    m_created = true;
+    return true;
+}
+
+void FrameProfiler::Release()
+{
+    for (int i = 0; i < FrameLatency; i++)
+    {
+        FrameSlot& slot = m_slots[i];
+        if (slot.disjoint) slot.disjoint->Release();
+        slot.disjoint = nullptr;
+        for (int j = 0; j < MaxScopes * 2; j++)
+        {
+            if (slot.timestamps[j]) slot.timestamps[j]->Release();
+            slot.timestamps[j] = nullptr;
+        }
+        slot.pending = false;
+    }
+    m_inFrame = false;
+    m_created = false;
+}
+
+void FrameProfiler::BeginFrame(ID3D11DeviceContext* context)
+{
+    if (!m_created || !m_enabled || m_inFrame)
+        return;
+
+    // The slot's previous frame is FrameLatency frames old, give up on it if the GPU still hasn't answered
+    FrameSlot& slot = m_slots[m_slot];
+    if (slot.pending && !Collect(context, slot))
+    {
+        slot.pending = false;
+        m_droppedFrames++;
+    }
+
+    slot.scopeCount = 0;
+    slot.frame = m_frame;
+    slot.cpuBegin = GetCpuTicks();
+    context->Begin(slot.disjoint);
+    m_inFrame = true;
+    m_frameScope = BeginScope(context, "Frame");
+}
+
+void FrameProfiler::EndFrame(ID3D11DeviceContext* context)
+{
+    if (!m_inFrame)
+        return;
+
+    FrameSlot& slot = m_slots[m_slot];
+    EndScope(context, m_frameScope);
+    context->End(slot.disjoint);
+    slot.pending = true;
+    m_inFrame = false;
+    m_slot = (m_slot + 1) % FrameLatency;
+    m_frame++;
+
+    // Read back whatever finished, oldest first
+    for (int i = 0; i < FrameLatency; i++)
+    {
+        FrameSlot& oldest = m_slots[(m_slot + i) % FrameLatency];
+        if (!oldest.pending)
+            continue;
+        if (!Collect(context, oldest))
+            break;
+    }
+}
+
+void FrameProfiler::Flush(ID3D11DeviceContext* context)
+{
+    context->Flush();
+    for (int i = 0; i < FrameLatency; i++)
+    {
+        FrameSlot& oldest = m_slots[(m_slot + i) % FrameLatency];
+        while (oldest.pending && !Collect(context, oldest))
+            ;
+    }
+}
+
+void FrameProfiler::ResetHistory()
+{
+    for (Pass& pass : m_passes)
+    {
+        pass.count = 0;
+        pass.head = 0;
+    }
+    m_droppedFrames = 0;
+}
+
+int FrameProfiler::BeginScope(ID3D11DeviceContext* context, const char* name)
+{
+    FrameSlot& slot = m_slots[m_slot];
+    if (!m_inFrame || slot.scopeCount >= MaxScopes)
+        return -1;
+
+    int index = slot.scopeCount++;
+    Scope& scope = slot.scopes[index];
+    scope.pass = FindOrAddPass(name);
+    scope.cpuBegin = GetCpuTicks();
+    scope.cpuEnd = scope.cpuBegin;
+    context->End(slot.timestamps[index * 2]);
+    return index;
+}
+
+void FrameProfiler::EndScope(ID3D11DeviceContext* context, int scope)
+{
+    FrameSlot& slot = m_slots[m_slot];
+    if (!m_inFrame || scope < 0 || scope >= slot.scopeCount)
+        return;
+
+    context->End(slot.timestamps[scope * 2 + 1]);
+    slot.scopes[scope].cpuEnd = GetCpuTicks();
+}
+
+int FrameProfiler::FindOrAddPass(const char* name)
+{
+    for (int i = 0; i < (int)m_passes.size(); i++)
+        if (strcmp(m_passes[i].name.c_str(), name) == 0)
+            return i;
+
+    Pass pass;
+    pass.name = name;
+    pass.count = 0;
+    pass.head = 0;
+    pass.frameCpuMs = 0.0f;
+    pass.frameGpuMs = 0.0f;
+    pass.inFrame = false;
+    m_passes.push_back(pass);
+    return (int)m_passes.size() - 1;
+}
+
+bool FrameProfiler::Collect(ID3D11DeviceContext* context, FrameSlot& slot)
+{
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    if (context->GetData(slot.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+        return false;
+
+    UINT64 timestamps[MaxScopes * 2];
+    for (int i = 0; i < slot.scopeCount * 2; i++)
+        if (context->GetData(slot.timestamps[i], &timestamps[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            return false;
+
+    for (Pass& pass : m_passes)
+    {
+        pass.frameCpuMs = 0.0f;
+        pass.frameGpuMs = 0.0f;
+        pass.inFrame = false;
+    }
+
+    bool gpuValid = !disjoint.Disjoint && disjoint.Frequency > 0;
+    double frameStartUs = ToUs(slot.cpuBegin);
+    for (int i = 0; i < slot.scopeCount; i++)
+    {
+        const Scope& scope = slot.scopes[i];
+        float cpuMs = (float)((double)(scope.cpuEnd - scope.cpuBegin) * 1000.0 / (double)m_cpuFrequency);
+        float gpuMs = -1.0f;
+        double gpuStartUs = frameStartUs;
+        if (gpuValid)
+        {
+            gpuMs = (float)((double)(timestamps[i * 2 + 1] - timestamps[i * 2]) * 1000.0 / (double)disjoint.Frequency);
+            gpuStartUs += (double)(timestamps[i * 2] - timestamps[0]) * 1000000.0 / (double)disjoint.Frequency;
+        }
+
+        Pass& pass = m_passes[scope.pass];
+        pass.frameCpuMs += cpuMs;
+        pass.frameGpuMs += gpuMs > 0.0f ? gpuMs : 0.0f;
+        pass.inFrame = true;
+
+        ProfileEvent event;
+        event.pass = scope.pass;
+        event.frame = slot.frame;
+        event.cpuStartUs = ToUs(scope.cpuBegin);
+        event.cpuMs = cpuMs;
+        event.gpuStartUs = gpuStartUs;
+        event.gpuMs = gpuMs;
+        if (m_events.size() < MaxEvents)
+            m_events.push_back(event);
+        else
+            m_events[m_eventHead] = event;
+        m_eventHead = (m_eventHead + 1) % MaxEvents;
+    }
+
+    for (Pass& pass : m_passes)
+    {
+        if (!pass.inFrame)
+            continue;
+        pass.cpuHistory[pass.head] = pass.frameCpuMs;
+        pass.gpuHistory[pass.head] = gpuValid ? pass.frameGpuMs : -1.0f;
+        pass.head = (pass.head + 1) % HistorySize;
+        if (pass.count < HistorySize)
+            pass.count++;
+    }
+
+    slot.pending = false;
+    return true;
+}
+
+float FrameProfiler::GetPercentile(int pass, bool gpu, float percentile) const
+{
+    const Pass& p = m_passes[pass];
+    const float* history = gpu ? p.gpuHistory : p.cpuHistory;
+    float samples[HistorySize];
+    int count = 0;
+    for (int i = 0; i < p.count; i++)
+        if (history[i] >= 0.0f)
+            samples[count++] = history[i];
+    if (count == 0)
+        return 0.0f;
+
+    int rank = (int)(percentile / 100.0f * (count - 1) + 0.5f);
+    std::nth_element(samples, samples + rank, samples + count);
+    return samples[rank];
+}
+
+void FrameProfiler::DrawPanel()
+{
+    ImGui::Checkbox("Enabled", &m_enabled);
+    if (!m_created)
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(no timestamp queries, GPU times unavailable)");
+    }
+    else
+    {
+        ImGui::SameLine();
+        ImGui::Text("Frames dropped: %d", m_droppedFrames);
+    }
+
+    // Milliseconds over the last HistorySize frames, a pass's time is summed over the frame
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("Passes", 7, flags))
+    {
+        ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("CPU p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("GPU p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < (int)m_passes.size(); i++)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(m_passes[i].name.c_str(), i == m_selectedPass, ImGuiSelectableFlags_SpanAllColumns))
+                m_selectedPass = i;
+            for (int gpu = 0; gpu < 2; gpu++)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", GetPercentile(i, gpu != 0, 50.0f));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", GetPercentile(i, gpu != 0, 95.0f));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", GetPercentile(i, gpu != 0, 99.0f));
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    if (m_selectedPass < (int)m_passes.size())
+    {
+        const Pass& pass = m_passes[m_selectedPass];
+        char label[128];
+        snprintf(label, sizeof(label), "%s GPU ms", pass.name.c_str());
+        int offset = pass.count == HistorySize ? pass.head : 0;
+        ImGui::PlotHistogram("##History", pass.gpuHistory, pass.count, offset, label, 0.0f, FLT_MAX, ImVec2(0, 60));
+    }
+
+    if (ImGui::Button("Export CSV"))
+        m_exportStatus = ExportCsv("profile.csv") ? "Wrote profile.csv" : "Failed to write profile.csv";
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace"))
+        m_exportStatus = ExportChromeTrace("profile_trace.json") ? "Wrote profile_trace.json" : "Failed to write profile_trace.json";
+    if (!m_exportStatus.empty())
+        ImGui::Text("%s", m_exportStatus.c_str());
+}
+
+bool FrameProfiler::ExportCsv(const char* path) const
+{
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "frame,pass,cpu_start_us,cpu_ms,gpu_start_us,gpu_ms\n");
+    size_t first = m_events.size() < MaxEvents ? 0 : m_eventHead;
+    for (size_t i = 0; i < m_events.size(); i++)
+    {
+        const ProfileEvent& e = m_events[(first + i) % m_events.size()];
+        fprintf(f, "%llu,%s,%.1f,%.4f,%.1f,%.4f\n", (unsigned long long)e.frame, m_passes[e.pass].name.c_str(),
+            e.cpuStartUs, e.cpuMs, e.gpuStartUs, e.gpuMs);
+    }
+    return fclose(f) == 0;
+}
+
+// Trace Event Format, complete ("X") events on a CPU and a GPU thread of one process
+bool FrameProfiler::ExportChromeTrace(const char* path) const
+{
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    size_t first = m_events.size() < MaxEvents ? 0 : m_eventHead;
+    for (size_t i = 0; i < m_events.size(); i++)
+    {
+        const ProfileEvent& e = m_events[(first + i) % m_events.size()];
+        const char* name = m_passes[e.pass].name.c_str();     // Pass names are plain text, no escaping needed
+        fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%llu}}",
+            name, e.cpuStartUs, e.cpuMs * 1000.0f, (unsigned long long)e.frame);
+        if (e.gpuMs >= 0.0f)
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%llu}}",
+                name, e.gpuStartUs, e.gpuMs * 1000.0f, (unsigned long long)e.frame);
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
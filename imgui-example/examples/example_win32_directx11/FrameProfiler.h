@@ -0,0 +1,129 @@
+#pragma once
+#include <d3d11.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Per-pass CPU and GPU timings.
+//
+// Scopes are named passes ("Background", "Blur 0 H", "Glass", "ImGui"...); a pass that
+// runs several times in a frame (the blur of every scene snapshot) adds up into one
+// sample. GPU times come from D3D11 timestamp queries inside a disjoint query per frame,
+// read back FrameLatency frames later without stalling, CPU times from
+// QueryPerformanceCounter around the same calls (the cost of recording them).
+//
+// Every pass keeps its last HistorySize frame samples in a ring for the percentiles
+// and the histogram, single scopes go to an event ring for the CSV and trace exports.
+
+struct ProfileEvent
+{
+    int pass;
+    uint64_t frame;
+    double cpuStartUs;      // Since the profiler was created
+    float cpuMs;
+    double gpuStartUs;      // Frame start on the CPU timeline plus the GPU offset into the frame
+    float gpuMs;            // Negative when the GPU time was lost (disjoint frame)
+};
+
+class FrameProfiler
+{
+public:
+    enum
+    {
+        MaxScopes = 64,         // Per frame
+        FrameLatency = 4,       // Frames of queries in flight
+        HistorySize = 256,      // Samples per pass
+        MaxEvents = 8192,
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    bool Create(ID3D11Device* device);
+    void Release();
+
+    // BeginFrame() opens the "Frame" scope around everything until EndFrame()
+    void BeginFrame(ID3D11DeviceContext* context);
+    void EndFrame(ID3D11DeviceContext* context);
+
+    // Scopes nest, a scope over the per-frame limit or outside a frame returns -1 and is ignored
+    int BeginScope(ID3D11DeviceContext* context, const char* name);
+    void EndScope(ID3D11DeviceContext* context, int scope);
+
+    bool IsEnabled() const { return m_enabled; }
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+    // Waits for every frame still in flight and reads it back, then the history is complete
+    void Flush(ID3D11DeviceContext* context);
+    // Forgets the pass samples (not the passes or the exported events), e.g. between benchmark runs
+    void ResetHistory();
+
+    int GetPassCount() const { return (int)m_passes.size(); }
+    const char* GetPassName(int pass) const { return m_passes[pass].name.c_str(); }
+    int GetSampleCount(int pass) const { return m_passes[pass].count; }
+    float GetPercentile(int pass, bool gpu, float percentile) const;
+    int GetDroppedFrames() const { return m_droppedFrames; }
+
+    // Pass table with p50/p95/p99 and a histogram of the selected pass, inside the current window
+    void DrawPanel();
+
+    bool ExportCsv(const char* path) const;
+    bool ExportChromeTrace(const char* path) const;    // chrome://tracing / Perfetto, CPU and GPU tracks
+
+private:
+    struct Pass
+    {
+        std::string name;
+        float cpuHistory[HistorySize];
+        float gpuHistory[HistorySize];
+        int count;              // Valid samples, up to HistorySize
+        int head;               // Next sample written
+        float frameCpuMs;       // Accumulated while collecting one frame
+        float frameGpuMs;
+        bool inFrame;
+    };
+
+    struct Scope
+    {
+        int pass;
+        int64_t cpuBegin;
+        int64_t cpuEnd;
+    };
+
+    struct FrameSlot
+    {
+        ID3D11Query* disjoint;
+        ID3D11Query* timestamps[MaxScopes * 2];
+        Scope scopes[MaxScopes];
+        int scopeCount;
+        uint64_t frame;
+        int64_t cpuBegin;
+        bool pending;           // Ended, results not read yet
+    };
+
+    FrameProfiler(const FrameProfiler&);
+    FrameProfiler& operator=(const FrameProfiler&);
+
+    int FindOrAddPass(const char* name);
+    bool Collect(ID3D11DeviceContext* context, FrameSlot& slot);
+    double ToUs(int64_t ticks) const { return (double)(ticks - m_cpuOrigin) * 1000000.0 / (double)m_cpuFrequency; }
+
+private:
+    FrameSlot m_slots[FrameLatency];
+    int m_slot;
+    bool m_inFrame;
+    int m_frameScope;
+    uint64_t m_frame;
+    bool m_enabled;
+    bool m_created;
+
+    std::vector<Pass> m_passes;
+    std::vector<ProfileEvent> m_events;     // Ring of MaxEvents
+    size_t m_eventHead;
+    int m_droppedFrames;
+    int m_selectedPass;
+    std::string m_exportStatus;
+
+    int64_t m_cpuFrequency;
+    int64_t m_cpuOrigin;
+};
@@ -0,0 +1,387 @@
+#include "GlassCommandList.h"
+#include <string.h>
+
+void GlassCommandList::Clear()
+{
+    m_commands.clear();
+    m_pipelines.clear();
+    m_data.clear();
+}
+
+GlassCommand& GlassCommandList::Add(GlassCommandType type)
+{
+    GlassCommand command;
+    memset(&command, 0, sizeof(command));
+    command.type = type;
+    m_commands.push_back(command);
+    return m_commands.back();
+}
+
+size_t GlassCommandList::AddData(const void* data, size_t size)
+{
+    size_t offset = m_data.size();
+    m_data.resize(offset + size);
+    memcpy(m_data.data() + offset, data, size);
+    return offset;
+}
+
+void GlassCommandList::SetTargets(GlassHandle target0, GlassHandle target1)
+{
+    GlassCommand& command = Add(GlassCommand_SetTargets);
+    command.handles[0] = target0;
+    command.handles[1] = target1;
+    command.count = target1 ? 2 : 1;
+}
+
+void GlassCommandList::ClearTarget(GlassHandle target, const float color[4])
+{
+    GlassCommand& command = Add(GlassCommand_ClearTarget);
+    command.handles[0] = target;
+    memcpy(command.values, color, sizeof(command.values));
+}
+
+void GlassCommandList::SetViewport(float width, float height)
+{
+    GlassCommand& command = Add(GlassCommand_SetViewport);
+    command.values[0] = width;
+    command.values[1] = height;
+}
+
+void GlassCommandList::SetScissor(int left, int top, int right, int bottom)
+{
+    GlassCommand& command = Add(GlassCommand_SetScissor);
+    command.values[0] = (float)left;
+    command.values[1] = (float)top;
+    command.values[2] = (float)right;
+    command.values[3] = (float)bottom;
+}
+
+void GlassCommandList::SetPipeline(const GlassPipeline& pipeline)
+{
+    GlassCommand& command = Add(GlassCommand_SetPipeline);
+    command.index = (int)m_pipelines.size();
+    m_pipelines.push_back(pipeline);
+}
+
+void GlassCommandList::BindTexture(int slot, GlassHandle texture)
+{
+    GlassCommand& command = Add(GlassCommand_BindTexture);
+    command.slot = slot;
+    command.handles[0] = texture;
+}
+
+void GlassCommandList::BindSampler(int slot, GlassHandle sampler)
+{
+    GlassCommand& command = Add(GlassCommand_BindSampler);
+    command.slot = slot;
+    command.handles[0] = sampler;
+}
+
+void GlassCommandList::BindConstants(int stages, int slot, GlassHandle buffer)
+{
+    GlassCommand& command = Add(GlassCommand_BindConstants);
+    command.stages = stages;
+    command.slot = slot;
+    command.handles[0] = buffer;
+}
+
+void GlassCommandList::BindConstantRange(int stages, int slot, GlassHandle range)
+{
+    GlassCommand& command = Add(GlassCommand_BindConstantRange);
+    command.stages = stages;
+    command.slot = slot;
+    command.handles[0] = range;
+}
+
+void GlassCommandList::UpdateConstants(GlassHandle buffer, const void* data, size_t size)
+{
+    size_t offset = AddData(data, size);
+    GlassCommand& command = Add(GlassCommand_UpdateConstants);
+    command.handles[0] = buffer;
+    command.dataOffset = offset;
+    command.dataSize = size;
+}
+
+void GlassCommandList::UpdateConstantsFrom(GlassHandle buffer, const void* source, size_t size)
+{
+    GlassCommand& command = Add(GlassCommand_UpdateConstantsFrom);
+    command.handles[0] = buffer;
+    command.handles[1] = source;
+    command.dataSize = size;
+}
+
+void GlassCommandList::SetGeometry(GlassHandle vertexBuffer, int stride, GlassHandle indexBuffer)
+{
+    GlassCommand& command = Add(GlassCommand_SetGeometry);
+    command.handles[0] = vertexBuffer;
+    command.handles[1] = indexBuffer;
+    command.count = stride;
+}
+
+void GlassCommandList::Draw(int vertexCount)
+{
+    GlassCommand& command = Add(GlassCommand_Draw);
+    command.count = vertexCount;
+}
+
+void GlassCommandList::DrawIndexed(int indexCount)
+{
+    GlassCommand& command = Add(GlassCommand_DrawIndexed);
+    command.count = indexCount;
+}
+
+void GlassCommandList::BeginScope(const char* name)
+{
+    size_t offset = AddData(name, strlen(name) + 1);
+    GlassCommand& command = Add(GlassCommand_BeginScope);
+    command.dataOffset = offset;
+    command.dataSize = strlen(name) + 1;
+}
+
+void GlassCommandList::EndScope()
+{
+    Add(GlassCommand_EndScope);
+}
+
+void GlassCommandList::GetPasses(std::vector<size_t>& starts) const
+{
+    starts.clear();
+    if (m_commands.empty())
+        return;
+    starts.push_back(0);
+    int depth = 0;
+    bool scoped = false;    // The current pass has opened its scope
+    for (size_t i = 0; i < m_commands.size(); i++)
+    {
+        if (m_commands[i].type == GlassCommand_BeginScope)
+        {
+            if (depth == 0 && scoped)
+                starts.push_back(i);
+            depth++;
+            scoped = true;
+        }
+        else if (m_commands[i].type == GlassCommand_EndScope && depth > 0)
+        {
+            depth--;
+        }
+    }
+}
+
+void GlassReplayStats::Add(const GlassReplayStats& other)
+{
+    replays += other.replays;
+    commands += other.commands;
+    stateChanges += other.stateChanges;
+    redundant += other.redundant;
+    uploads += other.uploads;
+    uploadSkips += other.uploadSkips;
+    inputBytes += other.inputBytes;
+}
+
+GlassCommandBackend::GlassCommandBackend()
+{
+    ForgetState();
+    ResetStats();
+}
+
+void GlassCommandBackend::ResetStats()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void GlassCommandBackend::ForgetState()
+{
+    memset(m_targets, 0, sizeof(m_targets));
+    m_targetCount = -1;
+    m_viewportKnown = false;
+    m_viewport[0] = m_viewport[1] = 0.0f;
+    m_scissorKnown = false;
+    memset(m_scissor, 0, sizeof(m_scissor));
+    Bound* bounds[] = { &m_inputLayout, &m_vertexShader, &m_pixelShader, &m_blendState, &m_depthStencilState,
+        &m_rasterizerState, &m_vertexBuffer, &m_indexBuffer };
+    for (Bound* bound : bounds)
+        bound->known = false;
+    memset(m_textures, 0, sizeof(m_textures));
+    memset(m_samplers, 0, sizeof(m_samplers));
+    memset(m_vertexConstants, 0, sizeof(m_vertexConstants));
+    memset(m_pixelConstants, 0, sizeof(m_pixelConstants));
+    m_stride = 0;
+}
+
+// Records the new binding, false when it is already bound
+bool GlassCommandBackend::Change(Bound& bound, GlassHandle handle)
+{
+    if (bound.known && bound.handle == handle)
+    {
+        m_stats.redundant++;
+        return false;
+    }
+    bound.known = true;
+    bound.handle = handle;
+    m_stats.stateChanges++;
+    return true;
+}
+
+void GlassCommandBackend::Replay(const GlassCommandList& list)
+{
+    Replay(list, 0, list.GetCommands().size());
+}
+
+void GlassCommandBackend::Replay(const GlassCommandList& list, size_t begin, size_t end)
+{
+    ForgetState();
+    m_stats.replays++;
+    const std::vector<GlassCommand>& commands = list.GetCommands();
+    for (size_t i = begin; i < end && i < commands.size(); i++)
+    {
+        const GlassCommand& command = commands[i];
+        m_stats.commands++;
+        switch (command.type)
+        {
+        case GlassCommand_SetTargets:
+        {
+            bool changed = command.count != m_targetCount;
+            for (int t = 0; t < command.count; t++)
+                changed |= !m_targets[t].known || m_targets[t].handle != command.handles[t];
+            if (!changed)
+            {
+                m_stats.redundant++;
+                break;
+            }
+            m_targetCount = command.count;
+            for (int t = 0; t < GlassMaxTargets; t++)
+            {
+                m_targets[t].known = t < command.count;
+                m_targets[t].handle = t < command.count ? command.handles[t] : nullptr;
+            }
+            m_stats.stateChanges++;
+            ApplyTargets(command.count, command.handles);
+
+            // The API unbinds textures that alias a new target, forget them all
+            memset(m_textures, 0, sizeof(m_textures));
+            break;
+        }
+        case GlassCommand_ClearTarget:
+            ApplyClear(command.handles[0], command.values);
+            break;
+        case GlassCommand_SetViewport:
+            if (m_viewportKnown && m_viewport[0] == command.values[0] && m_viewport[1] == command.values[1])
+            {
+                m_stats.redundant++;
+                break;
+            }
+            m_viewportKnown = true;
+            m_viewport[0] = command.values[0];
+            m_viewport[1] = command.values[1];
+            m_stats.stateChanges++;
+            ApplyViewport(command.values[0], command.values[1]);
+            break;
+        case GlassCommand_SetScissor:
+            if (m_scissorKnown && memcmp(m_scissor, command.values, sizeof(m_scissor)) == 0)
+            {
+                m_stats.redundant++;
+                break;
+            }
+            m_scissorKnown = true;
+            memcpy(m_scissor, command.values, sizeof(m_scissor));
+            m_stats.stateChanges++;
+            ApplyScissor(command.values);
+            break;
+        case GlassCommand_SetPipeline:
+        {
+            const GlassPipeline& pipeline = list.GetPipeline(command);
+            if (Change(m_inputLayout, pipeline.inputLayout))
+                ApplyInputLayout(pipeline.inputLayout);
+            if (Change(m_vertexShader, pipeline.vertexShader))
+                ApplyVertexShader(pipeline.vertexShader);
+            if (Change(m_pixelShader, pipeline.pixelShader))
+                ApplyPixelShader(pipeline.pixelShader);
+            if (Change(m_blendState, pipeline.blendState))
+                ApplyBlendState(pipeline.blendState);
+            if (Change(m_depthStencilState, pipeline.depthStencilState))
+                ApplyDepthStencilState(pipeline.depthStencilState);
+            if (Change(m_rasterizerState, pipeline.rasterizerState))
+                ApplyRasterizerState(pipeline.rasterizerState);
+            break;
+        }
+        case GlassCommand_BindTexture:
+            if (command.slot < MaxSlots && Change(m_textures[command.slot], command.handles[0]))
+                ApplyTexture(command.slot, command.handles[0]);
+            break;
+        case GlassCommand_BindSampler:
+            if (command.slot < MaxSlots && Change(m_samplers[command.slot], command.handles[0]))
+                ApplySampler(command.slot, command.handles[0]);
+            break;
+        case GlassCommand_BindConstants:
+            if (command.slot >= MaxSlots)
+                break;
+            if ((command.stages & GlassStage_Vertex) && Change(m_vertexConstants[command.slot], command.handles[0]))
+                ApplyConstants(GlassStage_Vertex, command.slot, command.handles[0]);
+            if ((command.stages & GlassStage_Pixel) && Change(m_pixelConstants[command.slot], command.handles[0]))
+                ApplyConstants(GlassStage_Pixel, command.slot, command.handles[0]);
+            break;
+        case GlassCommand_BindConstantRange:
+            // Ranges move between replays, not within one: the range is what stays bound
+            if (command.slot >= MaxSlots)
+                break;
+            if ((command.stages & GlassStage_Vertex) && Change(m_vertexConstants[command.slot], command.handles[0]))
+                ApplyConstantRange(GlassStage_Vertex, command.slot, command.handles[0]);
+            if ((command.stages & GlassStage_Pixel) && Change(m_pixelConstants[command.slot], command.handles[0]))
+                ApplyConstantRange(GlassStage_Pixel, command.slot, command.handles[0]);
+            break;
+        case GlassCommand_UpdateConstants:
+        case GlassCommand_UpdateConstantsFrom:
+        {
+            const void* data = command.type == GlassCommand_UpdateConstants ? list.GetData(command) : command.handles[1];
+            Upload* upload = nullptr;
+            for (Upload& u : m_uploads)
+                if (u.buffer == command.handles[0])
+                    upload = &u;
+            if (upload && upload->contents.size() == command.dataSize && memcmp(upload->contents.data(), data, command.dataSize) == 0)
+            {
+                m_stats.uploadSkips++;
+                break;
+            }
+            if (!upload)
+            {
+                m_uploads.push_back(Upload());
+                upload = &m_uploads.back();
+                upload->buffer = command.handles[0];
+            }
+            upload->contents.assign((const unsigned char*)data, (const unsigned char*)data + command.dataSize);
+            m_stats.uploads++;
+            ApplyUpload(command.handles[0], data, command.dataSize);
+            break;
+        }
+        case GlassCommand_SetGeometry:
+            if (m_vertexBuffer.known && m_indexBuffer.known && m_vertexBuffer.handle == command.handles[0] &&
+                m_indexBuffer.handle == command.handles[1] && m_stride == command.count)
+            {
+                m_stats.redundant++;
+                break;
+            }
+            m_vertexBuffer.known = m_indexBuffer.known = true;
+            m_vertexBuffer.handle = command.handles[0];
+            m_indexBuffer.handle = command.handles[1];
+            m_stride = command.count;
+            m_stats.stateChanges++;
+            ApplyGeometry(command.handles[0], command.count, command.handles[1]);
+            break;
+        case GlassCommand_Draw:
+            // Vertex-less draws (a fullscreen triangle from the vertex id) fetch nothing
+            m_stats.inputBytes += m_vertexBuffer.known && m_vertexBuffer.handle ? command.count * m_stride : 0;
+            ApplyDraw(command.count);
+            break;
+        case GlassCommand_DrawIndexed:
+            m_stats.inputBytes += command.count * (m_stride + (int)sizeof(GlassIndex));
+            ApplyDrawIndexed(command.count);
+            break;
+        case GlassCommand_BeginScope:
+            ApplyBeginScope((const char*)list.GetData(command));
+            break;
+        case GlassCommand_EndScope:
+            ApplyEndScope();
+            break;
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+// Recorded render commands, replayed by a GlassCommandBackend.
+//
+// The glass pipeline records its fixed passes (background, blur, glass) once and replays
+// them every frame, re-recording only when its configuration changes. Resources are opaque
+// handles only the backend knows how to bind (ID3D11* for D3D11CommandBackend), so the list
+// itself never touches a graphics API. Constant buffer contents are copied into the list, or
+// for constants that change every frame read when replayed from memory that outlives it.
+//
+// Every top-level scope is a pass that binds everything it draws with, so a backend may
+// replay the passes of a list apart, on several threads (D3D11ParallelReplay). Commands
+// before a list's first scope belong to it, commands after a scope to the pass before.
+
+typedef const void* GlassHandle;
+typedef unsigned short GlassIndex;  // Index buffers hold 16-bit indices
+
+enum { GlassMaxTargets = 2 };
+
+// Everything a draw binds as a whole besides resources: shaders and fixed function state
+struct GlassPipeline
+{
+    GlassHandle inputLayout;
+    GlassHandle vertexShader;
+    GlassHandle pixelShader;
+    GlassHandle blendState;         // Null: no blending
+    GlassHandle depthStencilState;
+    GlassHandle rasterizerState;
+};
+
+enum GlassCommandType
+{
+    GlassCommand_SetTargets,        // handles: up to GlassMaxTargets, count
+    GlassCommand_ClearTarget,       // handles[0], values: color
+    GlassCommand_SetViewport,       // values[0..1]: width, height
+    GlassCommand_SetScissor,        // values: left, top, right, bottom pixels, for pipelines that clip
+    GlassCommand_SetPipeline,       // index into the list's pipelines
+    GlassCommand_BindTexture,       // Pixel shader slot, handles[0] (null unbinds)
+    GlassCommand_BindSampler,       // Pixel shader slot, handles[0]
+    GlassCommand_BindConstants,     // stages, slot, handles[0]
+    GlassCommand_BindConstantRange, // stages, slot, handles[0]: a range the backend resolves when replayed
+    GlassCommand_UpdateConstants,   // handles[0], payload in the list's data
+    GlassCommand_UpdateConstantsFrom, // handles[0], handles[1]: dataSize bytes read when replayed
+    GlassCommand_SetGeometry,       // handles: vertex and index buffer, count: vertex stride
+    GlassCommand_Draw,              // count: vertices, without an index buffer
+    GlassCommand_DrawIndexed,       // count: indices
+    GlassCommand_BeginScope,        // Profiler scope, name in the list's data
+    GlassCommand_EndScope,
+};
+
+enum GlassShaderStage
+{
+    GlassStage_Vertex = 1 << 0,
+    GlassStage_Pixel = 1 << 1,
+};
+
+struct GlassCommand
+{
+    GlassCommandType type;
+    int slot;                       // Texture, sampler or constant slot
+    int count;                      // Targets, stride, vertices or indices, see above
+    int stages;                     // GlassShaderStage bits
+    int index;                      // Pipeline
+    GlassHandle handles[GlassMaxTargets];
+    float values[4];
+    size_t dataOffset;              // Constants payload or scope name
+    size_t dataSize;
+};
+
+class GlassCommandList
+{
+public:
+    void Clear();
+    bool IsEmpty() const { return m_commands.empty(); }
+
+    void SetTargets(GlassHandle target0, GlassHandle target1 = nullptr);
+    void ClearTarget(GlassHandle target, const float color[4]);
+    void SetViewport(float width, float height);
+    void SetScissor(int left, int top, int right, int bottom);
+    void SetPipeline(const GlassPipeline& pipeline);
+    void BindTexture(int slot, GlassHandle texture);
+    void BindSampler(int slot, GlassHandle sampler);
+    void BindConstants(int stages, int slot, GlassHandle buffer);
+    void BindConstantRange(int stages, int slot, GlassHandle range);
+    void UpdateConstants(GlassHandle buffer, const void* data, size_t size);
+    void UpdateConstantsFrom(GlassHandle buffer, const void* source, size_t size);
+    void SetGeometry(GlassHandle vertexBuffer, int stride, GlassHandle indexBuffer);
+    void Draw(int vertexCount);
+    void DrawIndexed(int indexCount);
+    void BeginScope(const char* name);
+    void EndScope();
+
+    // Index of the first command of every pass, see above
+    void GetPasses(std::vector<size_t>& starts) const;
+
+    const std::vector<GlassCommand>& GetCommands() const { return m_commands; }
+    const GlassPipeline& GetPipeline(const GlassCommand& command) const { return m_pipelines[command.index]; }
+    const void* GetData(const GlassCommand& command) const { return m_data.data() + command.dataOffset; }
+
+private:
+    GlassCommand& Add(GlassCommandType type);
+    size_t AddData(const void* data, size_t size);
+
+    std::vector<GlassCommand> m_commands;
+    std::vector<GlassPipeline> m_pipelines;
+    std::vector<unsigned char> m_data;
+};
+
+struct GlassReplayStats
+{
+    int replays;
+    int commands;
+    int stateChanges;       // Issued to the backend
+    int redundant;          // Skipped, the state was already bound
+    int uploads;
+    int uploadSkips;        // Constants already holding the same contents
+    int inputBytes;         // Vertex and index data input assembly fetches, no vertex reuse assumed
+
+    void Add(const GlassReplayStats& other);
+};
+
+// Replays command lists into an API. Bound state is tracked from command to command and
+// whatever would not change it is skipped. A replay starts from unknown state since other
+// code binds things between replays; constant buffer contents are only written by lists
+// and are remembered across replays, until ForgetUploads() when another backend may have
+// written them.
+class GlassCommandBackend
+{
+public:
+    GlassCommandBackend();
+    virtual ~GlassCommandBackend() {}
+
+    void Replay(const GlassCommandList& list);
+    // Commands [begin, end), starting at a pass
+    void Replay(const GlassCommandList& list, size_t begin, size_t end);
+    void ForgetUploads() { m_uploads.clear(); }
+
+    const GlassReplayStats& GetStats() const { return m_stats; }
+    void ResetStats();
+
+protected:
+    virtual void ApplyTargets(int count, const GlassHandle* targets) = 0;
+    virtual void ApplyClear(GlassHandle target, const float color[4]) = 0;
+    virtual void ApplyViewport(float width, float height) = 0;
+    virtual void ApplyScissor(const float rect[4]) = 0;
+    virtual void ApplyInputLayout(GlassHandle inputLayout) = 0;
+    virtual void ApplyVertexShader(GlassHandle shader) = 0;
+    virtual void ApplyPixelShader(GlassHandle shader) = 0;
+    virtual void ApplyBlendState(GlassHandle state) = 0;
+    virtual void ApplyDepthStencilState(GlassHandle state) = 0;
+    virtual void ApplyRasterizerState(GlassHandle state) = 0;
+    virtual void ApplyTexture(int slot, GlassHandle texture) = 0;
+    virtual void ApplySampler(int slot, GlassHandle sampler) = 0;
+    virtual void ApplyConstants(GlassShaderStage stage, int slot, GlassHandle buffer) = 0;
+    virtual void ApplyConstantRange(GlassShaderStage stage, int slot, GlassHandle range) = 0;
+    virtual void ApplyUpload(GlassHandle buffer, const void* data, size_t size) = 0;
+    virtual void ApplyGeometry(GlassHandle vertexBuffer, int stride, GlassHandle indexBuffer) = 0;
+    virtual void ApplyDraw(int vertexCount) = 0;
+    virtual void ApplyDrawIndexed(int indexCount) = 0;
+    virtual void ApplyBeginScope(const char* name) = 0;
+    virtual void ApplyEndScope() = 0;
+
+private:
+    enum { MaxSlots = 16 };
+
+    // A handle as last bound, unknown until the replay binds it
+    struct Bound
+    {
+        bool known;
+        GlassHandle handle;
+    };
+
+    struct Upload
+    {
+        GlassHandle buffer;
+        std::vector<unsigned char> contents;
+    };
+
+    bool Change(Bound& bound, GlassHandle handle);
+    void ForgetState();
+
+    Bound m_targets[GlassMaxTargets];
+    int m_targetCount;
+    bool m_viewportKnown;
+    float m_viewport[2];
+    bool m_scissorKnown;
+    float m_scissor[4];
+    Bound m_inputLayout;
+    Bound m_vertexShader;
+    Bound m_pixelShader;
+    Bound m_blendState;
+    Bound m_depthStencilState;
+    Bound m_rasterizerState;
+    Bound m_textures[MaxSlots];
+    Bound m_samplers[MaxSlots];
+    Bound m_vertexConstants[MaxSlots];
+    Bound m_pixelConstants[MaxSlots];
+    Bound m_vertexBuffer;
+    Bound m_indexBuffer;
+    int m_stride;
+    std::vector<Upload> m_uploads;
+    GlassReplayStats m_stats;
+};
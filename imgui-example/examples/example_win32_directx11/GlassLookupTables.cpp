@@ -0,0 +1,224 @@
+#include "GlassLookupTables.h"
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+void BuildGlowLUT(float* lut, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        // Texel center back to a direction on the |x| + |y| = 1 diamond
+        float t = (i + 0.5f) / size * 4.0f;
+        if (t >= 3.0f)
+            t -= 4.0f;
+        float x, y;
+        if (t < 1.0f)
+        {
+            y = t;
+            x = 1.0f - fabsf(t);
+        }
+        else
+        {
+            y = 2.0f - t;
+            x = -(1.0f - fabsf(y));
+        }
+        lut[i] = sinf(atan2f(y, x) - 0.5f);
+    }
+}
+
+// Void-and-cluster (Ulichney 1993) on a torus: ranks are handed out by repeatedly
+// filling the largest void or removing the tightest cluster of a Gaussian-filtered
+// binary pattern, energies are updated incrementally
+struct BlueNoiseBuilder
+{
+    int size;
+    std::vector<float> kernel;      // Gaussian by toroidal offset
+    std::vector<float> energy;
+    std::vector<unsigned char> pattern;
+
+    void Init(int n)
+    {
+        size = n;
+        kernel.resize(n * n);
+        const float sigma = 1.5f;
+        for (int y = 0; y < n; y++)
+        {
+            for (int x = 0; x < n; x++)
+            {
+                int dx = x < n / 2 ? x : n - x;
+                int dy = y < n / 2 ? y : n - y;
+                kernel[y * n + x] = expf(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+            }
+        }
+        energy.assign(n * n, 0.0f);
+        pattern.assign(n * n, 0);
+    }
+
+    void Splat(int index, float sign)
+    {
+        int px = index % size, py = index / size;
+        for (int y = 0; y < size; y++)
+        {
+            const float* k = &kernel[((y - py + size) % size) * size];
+            float* e = &energy[y * size];
+            for (int x = 0; x < size; x++)
+                e[x] += sign * k[(x - px + size) % size];
+        }
+    }
+
+    void Set(int index, unsigned char value)
+    {
+        if (pattern[index] == value)
+            return;
+        pattern[index] = value;
+        Splat(index, value ? 1.0f : -1.0f);
+    }
+
+    // Highest energy among pixels equal to value (tightest cluster of ones), or lowest (largest void of zeros)
+    int Find(unsigned char value, bool highest) const
+    {
+        int best = -1;
+        for (int i = 0; i < size * size; i++)
+        {
+            if (pattern[i] != value)
+                continue;
+            if (best < 0 || (highest ? energy[i] > energy[best] : energy[i] < energy[best]))
+                best = i;
+        }
+        return best;
+    }
+};
+
+void BuildBlueNoise(unsigned char* noise, int size)
+{
+    int count = size * size;
+    std::vector<int> rank(count, 0);
+    BlueNoiseBuilder b;
+    b.Init(size);
+
+    // Initial pattern: 10% random ones (fixed seed), relaxed until the tightest
+    // cluster and the largest void meet
+    uint32_t seed = 0x9E3779B9u;
+    int ones = count / 10;
+    for (int placed = 0; placed < ones; )
+    {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        int index = (int)(seed % (uint32_t)count);
+        if (!b.pattern[index])
+        {
+            b.Set(index, 1);
+            placed++;
+        }
+    }
+    for (;;)
+    {
+        int cluster = b.Find(1, true);
+        b.Set(cluster, 0);
+        int hole = b.Find(0, false);
+        b.Set(hole, 1);
+        if (hole == cluster)
+            break;
+    }
+    std::vector<unsigned char> initial = b.pattern;
+    std::vector<float> initialEnergy = b.energy;
+
+    // Phase 1: ranks below the initial count, removing clusters
+    for (int r = ones - 1; r >= 0; r--)
+    {
+        int cluster = b.Find(1, true);
+        b.Set(cluster, 0);
+        rank[cluster] = r;
+    }
+
+    // Phase 2: up to half full, filling voids
+    b.pattern = initial;
+    b.energy = initialEnergy;
+    for (int r = ones; r < count / 2; r++)
+    {
+        int hole = b.Find(0, false);
+        b.Set(hole, 1);
+        rank[hole] = r;
+    }
+
+    // Phase 3: the rest. The zeros are the minority now, their tightest cluster is
+    // the zero with the lowest energy, i.e. still the largest void of the ones.
+    for (int r = count / 2; r < count; r++)
+    {
+        int hole = b.Find(0, false);
+        b.Set(hole, 1);
+        rank[hole] = r;
+    }
+
+    for (int i = 0; i < count; i++)
+        noise[i] = (unsigned char)((rank[i] * 256) / count);
+}
+
+float RefractionScaleExact(float a, float b, float c, float d, float power, float x)
+{
+    float refraction = 1.0f - b * powf(c * 2.718281828f, -d * x - a);
+    return refraction > 0.0f ? powf(refraction, power) : 0.0f;
+}
+
+float RefractionScaleFolded(const RefractionFit& fit, float power, float x)
+{
+    float refraction = 1.0f - fit.weight * exp2f(fit.slope * x);
+    return refraction > 0.0f ? powf(refraction, power) : 0.0f;
+}
+
+float RefractionScaleCubic(const RefractionFit& fit, float x)
+{
+    float t = exp2f(fit.slope * x);
+    return ((fit.cubic[3] * t + fit.cubic[2]) * t + fit.cubic[1]) * t + fit.cubic[0];
+}
+
+void FitRefraction(float a, float b, float c, float d, float power, RefractionFit& fit)
+{
+    const double e = 2.718281828459045;
+    const double pi = 3.141592653589793;
+    double logBase = log2(fmax(c * e, 1e-30));
+    double weight = b * exp2(-a * logBase);
+    fit.slope = (float)(-d * logBase);
+    fit.weight = (float)weight;
+    fit.cubicValid = fit.slope <= 0.0f;
+
+    // Newton's divided differences over the nodes, then expanded into powers of t
+    double nodes[4], values[4];
+    for (int k = 0; k < 4; k++)
+    {
+        nodes[k] = (1.0 - cos(pi * k / 3.0)) * 0.5;
+        double refraction = 1.0 - weight * nodes[k];
+        values[k] = refraction > 0.0 ? pow(refraction, (double)power) : 0.0;
+    }
+    for (int j = 1; j < 4; j++)
+    {
+        for (int k = 3; k >= j; k--)
+            values[k] = (values[k] - values[k - 1]) / (nodes[k] - nodes[k - j]);
+    }
+    double byT[4] = { values[3], 0.0, 0.0, 0.0 };
+    for (int k = 2; k >= 0; k--)
+    {
+        for (int i = 3; i > 0; i--)
+            byT[i] = byT[i - 1] - nodes[k] * byT[i];
+        byT[0] = values[k] - nodes[k] * byT[0];
+    }
+    for (int i = 0; i < 4; i++)
+        fit.cubic[i] = (float)byT[i];
+
+    // Relative past a scale of 1, a pole's huge scales are off by as much. NaN counts as the
+    // largest error.
+    const int samples = 1024;
+    double foldedError = 0.0, cubicError = 0.0;
+    for (int i = 0; i < samples; i++)
+    {
+        double x = fit.slope < 0.0f ? log2((i + 1.0) / samples) / fit.slope : 8.0 * i / (samples - 1);
+        double refraction = 1.0 - b * pow(c * e, -d * x - a);
+        double exact = refraction > 0.0 ? pow(refraction, (double)power) : 0.0;
+        double range = fmax(exact, 1.0);
+        double error = fabs(RefractionScaleFolded(fit, power, (float)x) - exact) / range;
+        foldedError = error > foldedError || error != error ? error : foldedError;
+        error = fabs(RefractionScaleCubic(fit, (float)x) - exact) / range;
+        cubicError = error > cubicError || error != error ? error : cubicError;
+    }
+    fit.foldedError = (float)foldedError;
+    fit.cubicError = fit.cubicValid ? (float)cubicError : INFINITY;
+}
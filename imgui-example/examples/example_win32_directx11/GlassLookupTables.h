@@ -0,0 +1,43 @@
+#pragma once
+
+// CPU-built lookup tables that replace per-pixel transcendentals in LiquidGlassPS.hlsl.
+
+// Glow() = sin(atan2(v.y, v.x) - 0.5) indexed by the "diamond angle" of v,
+// t = v.y / (|v.x| + |v.y|) for v.x >= 0 and 2 - that otherwise, wrapped to [0, 4)
+// and stored over [0, 1). The shader gets it with one divide instead of atan2 + sin.
+enum { GlowLUTSize = 256 };
+void BuildGlowLUT(float* lut, int size);
+
+// Tileable blue noise (void-and-cluster), size*size ranks spread over 0..255.
+// Replaces the sin/frac hash, whose output is visibly correlated across the screen.
+enum { BlueNoiseSize = 64 };
+void BuildBlueNoise(unsigned char* noise, int size);
+
+// Refraction scale pow(1 - b * (c*e)^(-d*x - a), power) at distance x >= 0 inside the edge,
+// the factor the shader scales the refracted sample's offset by. Folded once per parameter
+// change: (c*e)^(-d*x - a) = (c*e)^-a * exp2(slope * x), so b * that is weight * t with
+// t = exp2(slope * x). The shader then needs one exp2 for the refraction where the formula
+// as written costs a pow, and may replace the scale's pow by a cubic in t: t spans (0, 1]
+// over all x >= 0 when slope <= 0, the cubic interpolates the scale at the Chebyshev-Lobatto
+// nodes there, exact at the edge (t = 1) and deep inside (t = 0).
+// Errors are the largest difference to the scale evaluated in double, relative where it
+// exceeds 1, over 1024 t (the x they come from) or x in 0..8 when slope > 0. Where the
+// refraction stays positive (weight < 1, slope <= 0) the folded form is within 2e-5, the cubic
+// within 1e-3 at the default refraction (about 6e-4) and 2e-3 for 1 - weight >= 0.25 and powers
+// 0..3. Past that the cubic's grows fast as 1 - weight nears 0, where the scale has a pole or
+// kink. refraction_fit_test.cpp checks these bounds.
+struct RefractionFit
+{
+    float slope;            // -d * log2(c*e)
+    float weight;           // b * (c*e)^-a
+    float cubic[4];         // Scale by powers of t, lowest first
+    bool cubicValid;        // slope <= 0, t unbounded otherwise
+    float foldedError;      // Float rounding of the folded form
+    float cubicError;       // Infinite when !cubicValid
+};
+void FitRefraction(float a, float b, float c, float d, float power, RefractionFit& fit);
+
+// The shader's evaluations in float, a non-positive refraction scales by 0
+float RefractionScaleExact(float a, float b, float c, float d, float power, float x);
+float RefractionScaleFolded(const RefractionFit& fit, float power, float x);
+float RefractionScaleCubic(const RefractionFit& fit, float x);
@@ -0,0 +1,153 @@
+#include "GlassPresets.h"
+#include "MappedFile.h"
+#include "imgui.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+struct GlassPresetField
+{
+    const char* name;
+    size_t offset;
+};
+
+static const GlassPresetField GlassPresetFields[] =
+{
+    { "powerFactor", offsetof(GlassPreset, shader.u_powerFactor) },
+    { "a", offsetof(GlassPreset, shader.u_a) },
+    { "b", offsetof(GlassPreset, shader.u_b) },
+    { "c", offsetof(GlassPreset, shader.u_c) },
+    { "d", offsetof(GlassPreset, shader.u_d) },
+    { "fPower", offsetof(GlassPreset, shader.u_fPower) },
+    { "noise", offsetof(GlassPreset, shader.u_noise) },
+    { "glowWeight", offsetof(GlassPreset, shader.u_glowWeight) },
+    { "glowBias", offsetof(GlassPreset, shader.u_glowBias) },
+    { "glowEdge0", offsetof(GlassPreset, shader.u_glowEdge0) },
+    { "glowEdge1", offsetof(GlassPreset, shader.u_glowEdge1) },
+    { "dispersion", offsetof(GlassPreset, shader.u_dispersion) },
+    { "dispersionBand", offsetof(GlassPreset, shader.u_dispersionBand) },
+    { "specular", offsetof(GlassPreset, shader.u_specular) },
+    { "shininess", offsetof(GlassPreset, shader.u_shininess) },
+    { "fresnel", offsetof(GlassPreset, shader.u_fresnel) },
+    { "lightDir.x", offsetof(GlassPreset, shader.u_lightDir.x) },
+    { "lightDir.y", offsetof(GlassPreset, shader.u_lightDir.y) },
+    { "lightDir.z", offsetof(GlassPreset, shader.u_lightDir.z) },
+    { "bevel", offsetof(GlassPreset, shader.u_bevel) },
+    { "exact", offsetof(GlassPreset, shader.u_exact) },
+    { "blurRadius", offsetof(GlassPreset, blurRadius) },
+    { "blurIterations", offsetof(GlassPreset, blurIterations) },
+    { "blurDownscale", offsetof(GlassPreset, blurDownscale) },
+    { "width", offsetof(GlassPreset, width) },
+    { "height", offsetof(GlassPreset, height) },
+    { "shape", offsetof(GlassPreset, shape) },
+    { "cornerRadii.x", offsetof(GlassPreset, cornerRadii.x) },
+    { "cornerRadii.y", offsetof(GlassPreset, cornerRadii.y) },
+    { "cornerRadii.z", offsetof(GlassPreset, cornerRadii.z) },
+    { "cornerRadii.w", offsetof(GlassPreset, cornerRadii.w) },
+};
+
+static float* GetPresetField(GlassPreset& preset, size_t offset)
+{
+    return (float*)((char*)&preset + offset);
+}
+
+static const float* GetPresetField(const GlassPreset& preset, size_t offset)
+{
+    return (const float*)((const char*)&preset + offset);
+}
+
+void WriteGlassPresetText(ImGuiTextBuffer* buf, const char* typeName, const char* name, const GlassPreset& preset)
+{
+    buf->appendf("[%s][%s]\n", typeName, name);
+    for (const GlassPresetField& field : GlassPresetFields)
+        buf->appendf("%s=%g\n", field.name, *GetPresetField(preset, field.offset));
+    buf->append("\n");
+}
+
+bool ReadGlassPresetLine(GlassPreset& preset, const char* line)
+{
+    const char* equals = strchr(line, '=');
+    if (!equals)
+        return false;
+    size_t nameLength = (size_t)(equals - line);
+    for (const GlassPresetField& field : GlassPresetFields)
+    {
+        if (strlen(field.name) != nameLength || strncmp(field.name, line, nameLength) != 0)
+            continue;
+        char* end;
+        float value = strtof(equals + 1, &end);
+        if (end == equals + 1)
+            return false;
+        *GetPresetField(preset, field.offset) = value;
+        return true;
+    }
+    return false;
+}
+
+void LerpGlassPreset(const GlassPreset& a, const GlassPreset& b, float t, GlassPreset& out)
+{
+    static_assert(sizeof(GlassPreset) % sizeof(float) == 0, "GlassPreset must only hold floats");
+    const float* fa = (const float*)&a;
+    const float* fb = (const float*)&b;
+    float* fo = (float*)&out;
+    for (size_t i = 0; i < sizeof(GlassPreset) / sizeof(float); i++)
+        fo[i] = fa[i] + (fb[i] - fa[i]) * t;
+
+    out.shader.u_exact = t < 0.5f ? a.shader.u_exact : b.shader.u_exact;
+    out.shape = t < 0.5f ? a.shape : b.shape;
+    XMFLOAT3& l = out.shader.u_lightDir;
+    float length = sqrtf(l.x * l.x + l.y * l.y + l.z * l.z);
+    l = length > 0.0001f ? XMFLOAT3(l.x / length, l.y / length, l.z / length) : XMFLOAT3(0.0f, 0.0f, 1.0f);
+}
+
+bool WriteGlassPresetFile(const char* path, const std::vector<GlassPresetEntry>& presets)
+{
+    GlassPresetFileHeader header;
+    header.magic = GlassPresetMagic;
+    header.version = GlassPresetVersion;
+    header.count = (uint32_t)presets.size();
+    header.recordSize = sizeof(GlassPresetEntry);
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE* f = fopen(tempPath.c_str(), "wb");
+    if (!f)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(presets.data(), sizeof(GlassPresetEntry), presets.size(), f) == presets.size();
+    ok = (fclose(f) == 0) && ok;
+
+    // rename() does not replace an existing file on Windows
+    if (ok)
+    {
+        remove(path);
+        ok = rename(tempPath.c_str(), path) == 0;
+    }
+    if (!ok)
+        remove(tempPath.c_str());
+    return ok;
+}
+
+bool ReadGlassPresetFile(const char* path, std::vector<GlassPresetEntry>& presets)
+{
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(GlassPresetFileHeader))
+        return false;
+
+    GlassPresetFileHeader header;
+    memcpy(&header, file.Data(), sizeof(header));
+    if (header.magic != GlassPresetMagic || header.version != GlassPresetVersion ||
+        header.recordSize != sizeof(GlassPresetEntry) ||
+        file.Size() != sizeof(header) + (size_t)header.count * sizeof(GlassPresetEntry))
+        return false;
+
+    presets.resize(header.count);
+    if (header.count > 0)
+        memcpy(presets.data(), file.Data() + sizeof(header), (size_t)header.count * sizeof(GlassPresetEntry));
+    for (GlassPresetEntry& entry : presets)
+        entry.name[GlassPresetNameSize - 1] = 0;
+    return true;
+}
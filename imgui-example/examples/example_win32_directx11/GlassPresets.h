@@ -0,0 +1,39 @@
+#pragma once
+#include "LiquidGlass.h"
+#include <stdint.h>
+#include <vector>
+
+// Preset storage formats.
+//
+// Text: one "field=value" line per GlassPreset field under an ini entry, written and
+// read by LiquidGlass's ImGui settings handler. Field names match the timeline tracks,
+// unknown lines are ignored and missing fields keep their current value.
+//
+// Binary (.lgps, little endian): GlassPresetFileHeader, then count GlassPresetEntry
+// records exactly as they are laid out in memory, so loading is one validated copy.
+// Any change to GlassPreset or ShaderParams changes the record layout: bump the version.
+// Older files are rejected rather than converted, the text presets carry over as missing
+// fields keep their current value.
+
+enum
+{
+    GlassPresetMagic = 0x53504C47,      // "GLPS"
+    GlassPresetVersion = 2,             // 2: ShaderParams grew, the panel shape was added
+};
+
+struct GlassPresetFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t recordSize;    // sizeof(GlassPresetEntry), rejects files from a different layout
+};
+
+void WriteGlassPresetText(ImGuiTextBuffer* buf, const char* typeName, const char* name, const GlassPreset& preset);
+bool ReadGlassPresetLine(GlassPreset& preset, const char* line);
+
+// Field by field blend, t = 0 gives a. Mode switches (exact, shape) snap at t = 0.5, the light direction is renormalized.
+void LerpGlassPreset(const GlassPreset& a, const GlassPreset& b, float t, GlassPreset& out);
+
+bool WriteGlassPresetFile(const char* path, const std::vector<GlassPresetEntry>& presets);
+bool ReadGlassPresetFile(const char* path, std::vector<GlassPresetEntry>& presets);
@@ -0,0 +1,251 @@
+#include "GlassShapes.h"
+#include <math.h>
+#include <float.h>
+
+static const float SdfEpsilon = 0.00001f;
+
+const char* const GlassShapeNames[GlassShape_COUNT] = { "Superellipse", "Circle", "Rounded Rect", "Capsule" };
+
+static float Sign(float x)
+{
+    return x < 0.0f ? -1.0f : x > 0.0f ? 1.0f : 0.0f;
+}
+
+float SuperellipseSdf(float x, float y, float n, float* gradientX, float* gradientY)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float numerator = powf(ax, n) + powf(ay, n) - 1.0f;
+    float denX = powf(ax, 2.0f * n - 2.0f);
+    float denY = powf(ay, 2.0f * n - 2.0f);
+    float denominator = n * sqrtf(denX + denY) + SdfEpsilon;
+    if (gradientX)
+        *gradientX = n * sqrtf(denX) * Sign(x) / denominator;
+    if (gradientY)
+        *gradientY = n * sqrtf(denY) * Sign(y) / denominator;
+    return numerator / denominator;
+}
+
+float GlassShapeSdf(GlassShapeType shape, float x, float y, float sizeX, float sizeY, const float* cornerRadii,
+    float n, float* gradientX, float* gradientY)
+{
+    if (shape == GlassShape_Superellipse)
+        return SuperellipseSdf(x, y, n, gradientX, gradientY);
+
+    float halfX = sizeX / fminf(sizeX, sizeY);
+    float halfY = sizeY / fminf(sizeX, sizeY);
+    float qx = x * halfX, qy = y * halfY;
+    float d, gx, gy;
+    if (shape == GlassShape_RoundedRect)
+    {
+        float r = qy > 0.0f ? (qx > 0.0f ? cornerRadii[2] : cornerRadii[3]) : (qx > 0.0f ? cornerRadii[1] : cornerRadii[0]);
+        float ox = fabsf(qx) - halfX + r, oy = fabsf(qy) - halfY + r;
+        float outsideX = fmaxf(ox, 0.0f), outsideY = fmaxf(oy, 0.0f);
+        float outsideLength = sqrtf(outsideX * outsideX + outsideY * outsideY);
+        if (outsideLength > 0.0f)
+        {
+            gx = outsideX / outsideLength * Sign(qx);
+            gy = outsideY / outsideLength * Sign(qy);
+        }
+        else
+        {
+            gx = ox > oy ? Sign(qx) : 0.0f;
+            gy = ox > oy ? 0.0f : Sign(qy);
+        }
+        d = fminf(fmaxf(ox, oy), 0.0f) + outsideLength - r;
+    }
+    else
+    {
+        // Circle: a point; capsule: a segment along the long axis. Radius 1 around it.
+        float segmentX = shape == GlassShape_Capsule ? halfX - 1.0f : 0.0f;
+        float segmentY = shape == GlassShape_Capsule ? halfY - 1.0f : 0.0f;
+        float vx = qx - fminf(fmaxf(qx, -segmentX), segmentX);
+        float vy = qy - fminf(fmaxf(qy, -segmentY), segmentY);
+        float length = sqrtf(vx * vx + vy * vy);
+        if (length > 0.0f)
+        {
+            gx = vx / length;
+            gy = vy / length;
+        }
+        else
+        {
+            // On the capsule's segment, straight across it
+            gx = halfX >= halfY ? 0.0f : Sign(qx);
+            gy = halfX >= halfY ? Sign(qy) : 0.0f;
+        }
+        d = length - 1.0f;
+    }
+    if (gradientX)
+        *gradientX = gx;
+    if (gradientY)
+        *gradientY = gy;
+    return d;
+}
+
+// Smallest distance on the edge of the shape's bounds grown by reach - 1 half sizes
+static float GetBoundsDistance(float n, float reach)
+{
+    const int samples = 32;
+    float d = FLT_MAX;
+    for (int i = 0; i <= samples; i++)
+        d = fminf(d, SuperellipseSdf(reach, reach * i / samples, n, nullptr, nullptr));
+    return d;
+}
+
+// How far past its half size (in half sizes) a shape still comes within distance k.
+// The superellipse distance is only a first order estimate that falls behind the real
+// one away from the edge, worst towards the corners, so search rather than trust k.
+static float GetInfluenceReach(float n, float k)
+{
+    if (k <= 0.0f)
+        return 0.0f;
+    float lo = 0.0f, hi = k;
+    for (int i = 0; i < 32 && GetBoundsDistance(n, 1.0f + hi) < k; i++)
+    {
+        lo = hi;
+        hi *= 2.0f;
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        float mid = (lo + hi) * 0.5f;
+        if (GetBoundsDistance(n, 1.0f + mid) < k)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return hi;
+}
+
+void BinMergeShapes(const MergeShape* shapes, int count, float power, float mergeRadius,
+    int screenWidth, int screenHeight, MergeBins& bins)
+{
+    bins.tilesX = (screenWidth + MergeTileSize - 1) / MergeTileSize;
+    bins.tilesY = (screenHeight + MergeTileSize - 1) / MergeTileSize;
+    int tileCount = bins.tilesX * bins.tilesY;
+    bins.ranges.assign(tileCount * 2, 0);
+    bins.shapes.clear();
+    bins.boundsMin[0] = bins.boundsMin[1] = FLT_MAX;
+    bins.boundsMax[0] = bins.boundsMax[1] = -FLT_MAX;
+    bins.occupiedTiles = 0;
+
+    // Tile rectangle of every shape, empty (x0 > x1) when off screen
+    int rects[MaxMergeShapes][4];
+    count = count < MaxMergeShapes ? count : MaxMergeShapes;
+    for (int i = 0; i < count; i++)
+    {
+        const MergeShape& shape = shapes[i];
+        float centerX = (shape.midPoint[0] * 0.5f + 0.5f) * screenWidth;
+        float centerY = (0.5f - shape.midPoint[1] * 0.5f) * screenHeight;
+        float halfX = shape.quadScale[0] * 0.5f * screenWidth;
+        float halfY = shape.quadScale[1] * 0.5f * screenHeight;
+
+        // Twice the merge radius: a shape also pulls on the blend of its neighbours out in the
+        // gap, which then reaches back inside. The closed form shapes are exact distances, the
+        // superellipse's has to be searched. One pixel of slack for the pixel centers.
+        float growX = 2.0f * mergeRadius, growY = 2.0f * mergeRadius;
+        if (shape.shape == GlassShape_Superellipse)
+        {
+            float reach = GetInfluenceReach(power, shape.pixelScale > 0.0f ? 2.0f * mergeRadius / shape.pixelScale : 0.0f);
+            growX = halfX * reach;
+            growY = halfY * reach;
+        }
+        float minX = fmaxf(centerX - halfX - growX - 1.0f, 0.0f);
+        float minY = fmaxf(centerY - halfY - growY - 1.0f, 0.0f);
+        float maxX = fminf(centerX + halfX + growX + 1.0f, (float)screenWidth);
+        float maxY = fminf(centerY + halfY + growY + 1.0f, (float)screenHeight);
+        int* rect = rects[i];
+        if (maxX <= minX || maxY <= minY)
+        {
+            rect[0] = rect[1] = 1;
+            rect[2] = rect[3] = 0;
+            continue;
+        }
+        rect[0] = (int)(minX / MergeTileSize);
+        rect[1] = (int)(minY / MergeTileSize);
+        rect[2] = (int)(maxX / MergeTileSize);
+        rect[3] = (int)(maxY / MergeTileSize);
+        rect[2] = rect[2] < bins.tilesX - 1 ? rect[2] : bins.tilesX - 1;
+        rect[3] = rect[3] < bins.tilesY - 1 ? rect[3] : bins.tilesY - 1;
+        bins.boundsMin[0] = fminf(bins.boundsMin[0], minX);
+        bins.boundsMin[1] = fminf(bins.boundsMin[1], minY);
+        bins.boundsMax[0] = fmaxf(bins.boundsMax[0], maxX);
+        bins.boundsMax[1] = fmaxf(bins.boundsMax[1], maxY);
+    }
+
+    // Count, prefix sum, then fill in shape order so every tile blends in the same order
+    for (int i = 0; i < count; i++)
+        for (int ty = rects[i][1]; ty <= rects[i][3]; ty++)
+            for (int tx = rects[i][0]; tx <= rects[i][2]; tx++)
+                bins.ranges[(ty * bins.tilesX + tx) * 2 + 1]++;
+    unsigned int offset = 0;
+    for (int t = 0; t < tileCount; t++)
+    {
+        bins.ranges[t * 2] = offset;
+        offset += bins.ranges[t * 2 + 1];
+        if (bins.ranges[t * 2 + 1])
+            bins.occupiedTiles++;
+        bins.ranges[t * 2 + 1] = 0;
+    }
+    bins.shapes.resize(offset);
+    for (int i = 0; i < count; i++)
+    {
+        for (int ty = rects[i][1]; ty <= rects[i][3]; ty++)
+        {
+            for (int tx = rects[i][0]; tx <= rects[i][2]; tx++)
+            {
+                unsigned int* range = &bins.ranges[(ty * bins.tilesX + tx) * 2];
+                bins.shapes[range[0] + range[1]++] = (unsigned int)i;
+            }
+        }
+    }
+}
+
+float EvaluateMergedSdf(const MergeShape* shapes, const unsigned int* indices, int count, float power,
+    float mergeRadius, float x, float y, int screenWidth, int screenHeight)
+{
+    float ndcX = x / screenWidth * 2.0f - 1.0f;
+    float ndcY = 1.0f - y / screenHeight * 2.0f;
+    float k = fmaxf(mergeRadius, SdfEpsilon);
+    float d = FLT_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        const MergeShape& shape = shapes[indices[i]];
+        float px = (ndcX - shape.midPoint[0]) / shape.quadScale[0];
+        float py = -(ndcY - shape.midPoint[1]) / shape.quadScale[1];
+        float shapeD = GlassShapeSdf((GlassShapeType)shape.shape, px, py, shape.halfSize[0], shape.halfSize[1],
+            shape.cornerRadii, power, nullptr, nullptr) * shape.pixelScale;
+        if (i == 0)
+        {
+            d = shapeD;
+            continue;
+        }
+        float h = fminf(fmaxf(0.5f + 0.5f * (shapeD - d) / k, 0.0f), 1.0f);
+        d = shapeD + (d - shapeD) * h - k * h * (1.0f - h);
+    }
+    return d;
+}
+
+float ValidateMergeBins(const MergeShape* shapes, int count, const MergeBins& bins, float power,
+    float mergeRadius, int screenWidth, int screenHeight, int step)
+{
+    unsigned int all[MaxMergeShapes];
+    count = count < MaxMergeShapes ? count : MaxMergeShapes;
+    for (int i = 0; i < count; i++)
+        all[i] = (unsigned int)i;
+
+    // Deep inside, the superellipse distance runs to millions and only its float rounding differs
+    float band = 2.0f * mergeRadius + 8.0f;
+    float maxError = 0.0f;
+    for (int y = step / 2; y < screenHeight; y += step)
+    {
+        for (int x = step / 2; x < screenWidth; x += step)
+        {
+            const unsigned int* range = &bins.ranges[((y / MergeTileSize) * bins.tilesX + x / MergeTileSize) * 2];
+            float px = x + 0.5f, py = y + 0.5f;
+            float binned = EvaluateMergedSdf(shapes, bins.shapes.data() + range[0], (int)range[1], power, mergeRadius, px, py, screenWidth, screenHeight);
+            float reference = EvaluateMergedSdf(shapes, all, count, power, mergeRadius, px, py, screenWidth, screenHeight);
+            if ((binned < 0.0f || reference < 0.0f) && fabsf(reference) < band)
+                maxError = fmaxf(maxError, fabsf(binned - reference));
+        }
+    }
+    return maxError;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+
+// CPU side of the glass shapes in LiquidGlassPS.hlsl: the same distance functions, and the
+// tile bins of the smooth union ("liquid merge") of several panels.
+
+// Panel outline, GLASS_SHAPE_* in the shader. The shader is compiled once per shape for the
+// main panel, the liquid merge branches on it per panel.
+enum GlassShapeType
+{
+    GlassShape_Superellipse,    // Generic, pow() per pixel; stretched with the panel
+    GlassShape_Circle,          // Closed forms below: in units of the shorter half side,
+    GlassShape_RoundedRect,     // exact distances whatever the panel's aspect
+    GlassShape_Capsule,
+    GlassShape_COUNT
+};
+
+extern const char* const GlassShapeNames[GlassShape_COUNT];
+
+// sdSuperellipse() with r = 1: approximate signed distance in units of the half size,
+// gradient is the outward normal (either pointer may be null)
+float SuperellipseSdf(float x, float y, float n, float* gradientX, float* gradientY);
+
+// sdGlassShape(): distance at (x, y) in -1..1 over the panel (y down) for a panel of the given
+// size (any unit, only the aspect matters), in units of its shorter half side. Corner radii
+// (top-left, top-right, bottom-right, bottom-left) are in the same unit, rounded rect only.
+float GlassShapeSdf(GlassShapeType shape, float x, float y, float sizeX, float sizeY, const float* cornerRadii,
+    float n, float* gradientX, float* gradientY);
+
+// Liquid merge: every pixel blends the distances of the panels binned into its tile with a
+// polynomial smooth-min, and shades the blended shape once. A panel is binned into the tiles
+// its bounds reach, grown by as far as it can still pull on the union; smooth-min returns the
+// nearer shape unchanged past the merge radius, so what the bins drop is below a pixel.
+enum
+{
+    MergeTileSize = 32,     // Pixels, MERGE_TILE_SIZE in the shader
+    MaxMergeShapes = 16,
+};
+
+// StructuredBuffer<MergeShape> layout
+struct MergeShape
+{
+    float midPoint[2];      // NDC, y up
+    float quadScale[2];     // NDC half extent
+    float pixelScale;       // Pixels per distance unit: the shorter half side
+    unsigned int shape;     // GlassShapeType
+    float halfSize[2];      // Pixels
+    float cornerRadii[4];   // As in GlassShapeSdf()
+};
+
+struct MergeBins
+{
+    int tilesX;
+    int tilesY;
+    std::vector<unsigned int> ranges;   // Per tile: first entry in shapes, count
+    std::vector<unsigned int> shapes;   // Shape indices, ascending within a tile
+    float boundsMin[2];                 // Pixels covered by any bin, empty when max < min
+    float boundsMax[2];
+    int occupiedTiles;
+};
+
+void BinMergeShapes(const MergeShape* shapes, int count, float power, float mergeRadius,
+    int screenWidth, int screenHeight, MergeBins& bins);
+
+// Merged distance at a pixel (y down) in pixels, over the listed shapes in order; the shader's loop
+float EvaluateMergedSdf(const MergeShape* shapes, const unsigned int* indices, int count, float power,
+    float mergeRadius, float x, float y, int screenWidth, int screenHeight);
+
+// Largest difference in pixels between the binned distance and the one over every shape, inside
+// and near the edge, sampled every step pixels. Hundredths of a pixel when the bins hold.
+float ValidateMergeBins(const MergeShape* shapes, int count, const MergeBins& bins, float power,
+    float mergeRadius, int screenWidth, int screenHeight, int step);
@@ -1,9 +1,20 @@
 #include "LiquidGlass.h"
+#include "BlockCompress.h"
+#include "GlassLookupTables.h"
+#include "GlassPresets.h"
+#include "MappedFile.h"
 #include "imgui.h"
+#include "imgui_internal.h"
 #include <d3dcompiler.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
 
 #pragma comment(lib, "d3dcompiler.lib")
 
+// imgui.ini entries of the last destroyed LiquidGlass, see Cleanup()
+static ImGuiTextBuffer s_detachedSettings;
+
 // STB Image - define before including
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -13,18 +24,31 @@ LiquidGlass::LiquidGlass()
     // Initialize all pointers to nullptr
     m_device = nullptr;
     m_context = nullptr;
+    m_context1 = nullptr;
     m_liquidGlassVS = nullptr;
-    m_liquidGlassPS = nullptr;
+    for (int i = 0; i < GlassShape_COUNT; i++)
+        m_liquidGlassPS[i] = nullptr;
     m_blurVS = nullptr;
     m_blurPS = nullptr;
     m_simpleTexturePS = nullptr;
     m_inputLayout = nullptr;
-    m_blurInputLayout = nullptr;
     m_vertexBuffer = nullptr;
     m_indexBuffer = nullptr;
-    m_transformBuffer = nullptr;
-    m_shaderParamsBuffer = nullptr;
+    for (int i = 0; i < GlassMode_COUNT; i++)
+        m_modeBuffers[i] = nullptr;
     m_blurParamsBuffer = nullptr;
+    m_blurVerticalParamsBuffer = nullptr;
+    m_deferredTransformBuffer = nullptr;
+    m_deferredShaderParamsBuffer = nullptr;
+    memset(&m_transformRange, 0, sizeof(m_transformRange));
+    memset(&m_shaderParamsRange, 0, sizeof(m_shaderParamsRange));
+    memset(&m_windowTransformRange, 0, sizeof(m_windowTransformRange));
+    memset(&m_mergeTransformRange, 0, sizeof(m_mergeTransformRange));
+    memset(&m_mergeParamsRange, 0, sizeof(m_mergeParamsRange));
+    m_directMaps = 0;
+    m_lastFrameMaps = 0;
+    m_mergeShapeBuffer = nullptr;
+    m_mergeShapeSRV = nullptr;
     m_backgroundRT = nullptr;
     m_backgroundRTV = nullptr;
     m_backgroundSRV = nullptr;
@@ -34,19 +58,84 @@ LiquidGlass::LiquidGlass()
     m_blurFinalRT = nullptr;
     m_blurFinalRTV = nullptr;
     m_blurFinalSRV = nullptr;
+    m_sceneSnapshotRT = nullptr;
+    m_sceneSnapshotSRV = nullptr;
+    m_sceneBlurRT = nullptr;
+    m_sceneBlurRTV = nullptr;
+    m_sceneBlurSRV = nullptr;
+    m_interiorRT = nullptr;
+    m_interiorRTV = nullptr;
+    m_interiorSRV = nullptr;
+    m_interiorWidth = 1;
+    m_interiorHeight = 1;
+    for (int i = 0; i < 2; i++)
+    {
+        m_historyRT[i] = nullptr;
+        m_historyRTV[i] = nullptr;
+        m_historySRV[i] = nullptr;
+    }
+    m_mergeTileBuffer = nullptr;
+    m_mergeTileSRV = nullptr;
+    m_mergeTileShapeBuffer = nullptr;
+    m_mergeTileShapeSRV = nullptr;
+    m_glowLUT = nullptr;
+    m_blueNoise = nullptr;
     m_linearSampler = nullptr;
+    m_wrapSampler = nullptr;
     m_rasterizerState = nullptr;
+    m_scissorRasterizerState = nullptr;
     m_blendState = nullptr;
     m_depthStencilState = nullptr;
     m_currentBackgroundId = 0;
+    m_backgroundRevision = 0;
+    m_blurCacheKey = BlurCacheKey();
+    m_blurCacheValid = false;
+    m_blurCacheHits = 0;
+    m_blurCacheMisses = 0;
+    m_blurRegionOfInterest = true;
+    memset(m_blurRegion, 0, sizeof(m_blurRegion));
+    memset(m_sceneBlurRegion, 0, sizeof(m_sceneBlurRegion));
+    m_blurArea = 0.0f;
+    m_sceneBlurArea = 0.0f;
+    for (int i = 0; i < IM_ARRAYSIZE(m_reachKey); i++)
+        m_reachKey[i] = -1.0f;
+    m_reach = 1.0f;
+    m_glassWindows = true;
+    m_glassSeesGlass = true;
+    m_sceneSnapshotFrame = -1;
+    m_frameGlassWindowsFrame = -1;
+    m_glassStats = GlassFrameStats();
+    m_lastGlassStats = GlassFrameStats();
+    m_liquidMerge = false;
+    m_mergeRadius = 60.0f;
+    GlassPanel panel;
+    panel.position = XMFLOAT2(1.1f, 0.3f);
+    panel.size = XMFLOAT2(0.4f, 0.4f);
+    panel.shape = GlassShape_Circle;
+    panel.cornerRadii = XMFLOAT4(0.5f, 0.5f, 0.5f, 0.5f);
+    m_mergePanels.push_back(panel);
+    panel.position = XMFLOAT2(-0.9f, -0.4f);
+    panel.size = XMFLOAT2(0.6f, 0.3f);
+    panel.shape = GlassShape_Capsule;
+    m_mergePanels.push_back(panel);
+    memset(m_mergeShapes, 0, sizeof(m_mergeShapes));
+    m_mergeShapeCount = 0;
+    m_mergeBinsValid = false;
+    m_mergeBinsRadius = 0.0f;
+    m_mergeBinsPower = 0.0f;
+    m_mergeRebins = 0;
+    memset(&m_mergeParams, 0, sizeof(m_mergeParams));
+    memset(&m_mergeTransform, 0, sizeof(m_mergeTransform));
+    m_mergeValidationError = -1.0f;
     m_position = XMFLOAT3(0.0f, 0.0f, 0.0f);  // Center of screen
-    m_cameraPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);  // No camera offset
     m_velocityMultiplier = 1.0f;
     m_cameraVelocityMultiplier = 1.0f;
     m_velocity = 2.0f;
     m_cameraVelocity = 2.0f;
     m_width = 0.6f;
     m_height = 0.6f;
+    m_shape = GlassShape_Superellipse;
+    m_cornerRadii = XMFLOAT4(0.5f, 0.5f, 0.5f, 0.5f);
     m_blurIterations = 1;
     m_blurDownscaleFactor = 0.5f;
     m_mouseControl = false;
@@ -65,8 +154,74 @@ LiquidGlass::LiquidGlass()
     m_shaderParams.u_glowBias = 0.035f;
     m_shaderParams.u_glowEdge0 = 0.200f;
     m_shaderParams.u_glowEdge1 = -0.100f;
+    m_shaderParams.u_dispersion = 0.000f;
+    m_shaderParams.u_dispersionBand = 0.150f;
+    m_shaderParams.u_specular = 0.350f;
+    m_shaderParams.u_shininess = 48.0f;
+    m_shaderParams.u_fresnel = 0.150f;
+    m_shaderParams.u_lightDir = XMFLOAT3(-0.450f, 0.600f, 0.661f);
+    m_shaderParams.u_bevel = 0.250f;
+    m_shaderParams.u_exact = 0.0f;
+    for (int i = 0; i < IM_ARRAYSIZE(m_dispersionStatsKey); i++)
+        m_dispersionStatsKey[i] = -1.0f;
+    m_dispersionBandFraction = 0.0f;
+    m_dispersionInsideFraction = 0.0f;
+    m_shaderParams.u_interiorBand = 0.0f;
+    m_shaderParams.u_interiorMargin = 0.0f;
+    m_refractionMode = GlassRefraction_Folded;
+    for (int i = 0; i < IM_ARRAYSIZE(m_refractionKey); i++)
+        m_refractionKey[i] = -1.0f;
+    memset(&m_refractionFit, 0, sizeof(m_refractionFit));
+    m_shaderParams.u_refractionMode = (float)GlassRefraction_Exact;
+    m_shaderParams.u_refractionCubic = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+    m_shaderParams.u_refractionSlope = 0.0f;
+    m_shaderParams.u_refractionWeight = 0.0f;
+    m_shaderParams._pad = XMFLOAT2(0.0f, 0.0f);
+    m_shadingRate = 1;
+    m_interiorBand = 0.3f;
+    for (int i = 0; i < IM_ARRAYSIZE(m_shadingRateStatsKey); i++)
+        m_shadingRateStatsKey[i] = -1.0f;
+    m_shadingRateInterior = 0.0f;
+    m_shadingRateSaved = 0.0f;
+    m_temporalReuse = true;
+    m_historyTolerance = 1.0f;
+    m_historyKeyTolerance = 0.0f;
+    m_historyIndex = 0;
+    m_historyWritten = false;
+    memset(&m_historyKey, 0, sizeof(m_historyKey));
+    m_historyMidPoint = XMFLOAT2(0.0f, 0.0f);
+    m_midPoint = XMFLOAT2(0.0f, 0.0f);
+    m_historyStart = 0.0f;
+    m_historyReuseStart = 0.0f;
+    m_historyReuseRatio = 0.0f;
+    m_historyInvalidations = 0;
+    memset(&m_backgroundListKey, 0, sizeof(PassListKey));
+    m_backgroundListKey.targetRevision = -1;
+    m_blurListKey = m_backgroundListKey;
+    m_sceneBlurListKey = m_backgroundListKey;
+    m_glassListKey = m_backgroundListKey;
+    m_renderTargetRevision = 0;
+    m_passListRecords = 0;
+    memset(&m_lastReplayStats, 0, sizeof(m_lastReplayStats));
+    m_recordThreads = 0;
 
     m_blurParams.u_radius = 0.0f;
+
+    m_transformUploads = 0;
+    m_transformSkips = 0;
+    m_shaderParamsUploads = 0;
+    m_shaderParamsSkips = 0;
+    m_timelineTrack = 0;
+    m_timelineEasing = TimelineEasing_EaseInOut;
+    RegisterTimelineTracks();
+
+    CapturePreset(m_iniPreset);
+    m_iniPresetRead = false;
+    m_settingsHandler = false;
+    m_presetName[0] = 0;
+    m_presetBlendA = 0;
+    m_presetBlendB = 1;
+    m_presetBlend = 0.0f;
 }
 
 LiquidGlass::~LiquidGlass()
@@ -80,7 +235,13 @@ bool LiquidGlass::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
     m_context = context;
     m_screenWidth = screenWidth;
     m_screenHeight = screenHeight;
+    m_camera.SetViewport(screenWidth, screenHeight);
 
+    if (FAILED(m_context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_context1)) || !m_constantRing.Create(m_device))
+    {
+        MessageBoxW(nullptr, L"Needs Direct3D 11.1 constant buffer offsets!", L"LiquidGlass Error", MB_OK | MB_ICONERROR);
+        return false;
+    }
     if (!CreateShaders())
     {
         MessageBoxW(nullptr, L"Failed to create shaders! Check shaders/ folder.", L"LiquidGlass Error", MB_OK | MB_ICONERROR);
@@ -96,6 +257,11 @@ bool LiquidGlass::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
         MessageBoxW(nullptr, L"Failed to create render targets!", L"LiquidGlass Error", MB_OK | MB_ICONERROR);
         return false;
     }
+    if (!CreateLookupTextures())
+    {
+        MessageBoxW(nullptr, L"Failed to create lookup textures!", L"LiquidGlass Error", MB_OK | MB_ICONERROR);
+        return false;
+    }
 
     // Create sampler
     D3D11_SAMPLER_DESC samplerDesc = {};
@@ -108,11 +274,18 @@ bool LiquidGlass::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
     samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
     m_device->CreateSamplerState(&samplerDesc, &m_linearSampler);
 
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+    m_device->CreateSamplerState(&samplerDesc, &m_wrapSampler);
+
     // Create rasterizer state
     D3D11_RASTERIZER_DESC rastDesc = {};
     rastDesc.FillMode = D3D11_FILL_SOLID;
     rastDesc.CullMode = D3D11_CULL_NONE;  // Disable culling for debugging
     m_device->CreateRasterizerState(&rastDesc, &m_rasterizerState);
+    rastDesc.ScissorEnable = TRUE;
+    m_device->CreateRasterizerState(&rastDesc, &m_scissorRasterizerState);
 
     // Create blend state
     D3D11_BLEND_DESC blendDesc = {};
@@ -137,7 +310,10 @@ bool LiquidGlass::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
     Background bg;
     bg.name = "Default Background";
     bg.credits = "";
-    if (LoadTexture("pic.jpg", &bg.texture, &bg.width, &bg.height))
+    bg.path = "pic.jpg";
+    bg.format = BackgroundCacheFormat_BC7;
+    bg.animation = nullptr;
+    if (LoadTexture(bg.path.c_str(), bg.format, &bg.texture, &bg.width, &bg.height, &bg.memoryBytes))
     {
         m_backgrounds.push_back(bg);
         m_currentBackgroundId = 0;
@@ -148,24 +324,53 @@ bool LiquidGlass::Initialize(ID3D11Device* device, ID3D11DeviceContext* context,
         m_currentBackgroundId = -1;
     }
 
+    // Optional animated background, picked from the background list in the UI
+    LoadAnimatedBackground("background.gif", "Animated Background");
+
+    // imgui.ini is read on the first NewFrame(), after this
+    RegisterSettingsHandler();
+
+    // Without timestamp queries the profiler stays empty, not worth failing for
+    m_profiler.Create(m_device);
+    m_commandBackend.Initialize(m_context1, &m_profiler);
+
     return true;
 }
 
 void LiquidGlass::Cleanup()
 {
+    // The context outlives this object and saves imgui.ini once more on shutdown,
+    // leave it our last entries to write instead of a dangling pointer
+    ImGuiSettingsHandler* handler = m_settingsHandler && ImGui::GetCurrentContext() ? ImGui::FindSettingsHandler("LiquidGlass") : nullptr;
+    if (handler)
+    {
+        s_detachedSettings.clear();
+        SettingsHandler_WriteAll(ImGui::GetCurrentContext(), handler, &s_detachedSettings);
+        handler->UserData = nullptr;
+    }
+    m_settingsHandler = false;
+
     // Release all COM objects
     if (m_liquidGlassVS) m_liquidGlassVS->Release();
-    if (m_liquidGlassPS) m_liquidGlassPS->Release();
+    for (int i = 0; i < GlassShape_COUNT; i++)
+        if (m_liquidGlassPS[i]) m_liquidGlassPS[i]->Release();
     if (m_blurVS) m_blurVS->Release();
     if (m_blurPS) m_blurPS->Release();
     if (m_simpleTexturePS) m_simpleTexturePS->Release();
     if (m_inputLayout) m_inputLayout->Release();
-    if (m_blurInputLayout) m_blurInputLayout->Release();
     if (m_vertexBuffer) m_vertexBuffer->Release();
     if (m_indexBuffer) m_indexBuffer->Release();
-    if (m_transformBuffer) m_transformBuffer->Release();
-    if (m_shaderParamsBuffer) m_shaderParamsBuffer->Release();
+    for (int i = 0; i < GlassMode_COUNT; i++)
+        if (m_modeBuffers[i]) m_modeBuffers[i]->Release();
     if (m_blurParamsBuffer) m_blurParamsBuffer->Release();
+    if (m_blurVerticalParamsBuffer) m_blurVerticalParamsBuffer->Release();
+    if (m_deferredTransformBuffer) m_deferredTransformBuffer->Release();
+    if (m_deferredShaderParamsBuffer) m_deferredShaderParamsBuffer->Release();
+    m_constantRing.Release();
+    m_parallelReplay.Release();
+    if (m_context1) m_context1->Release();
+    if (m_mergeShapeBuffer) m_mergeShapeBuffer->Release();
+    if (m_mergeShapeSRV) m_mergeShapeSRV->Release();
     if (m_backgroundRT) m_backgroundRT->Release();
     if (m_backgroundRTV) m_backgroundRTV->Release();
     if (m_backgroundSRV) m_backgroundSRV->Release();
@@ -175,21 +380,233 @@ void LiquidGlass::Cleanup()
     if (m_blurFinalRT) m_blurFinalRT->Release();
     if (m_blurFinalRTV) m_blurFinalRTV->Release();
     if (m_blurFinalSRV) m_blurFinalSRV->Release();
+    if (m_sceneSnapshotRT) m_sceneSnapshotRT->Release();
+    if (m_sceneSnapshotSRV) m_sceneSnapshotSRV->Release();
+    if (m_sceneBlurRT) m_sceneBlurRT->Release();
+    if (m_sceneBlurRTV) m_sceneBlurRTV->Release();
+    if (m_sceneBlurSRV) m_sceneBlurSRV->Release();
+    if (m_interiorRT) m_interiorRT->Release();
+    if (m_interiorRTV) m_interiorRTV->Release();
+    if (m_interiorSRV) m_interiorSRV->Release();
+    for (int i = 0; i < 2; i++)
+    {
+        if (m_historyRT[i]) m_historyRT[i]->Release();
+        if (m_historyRTV[i]) m_historyRTV[i]->Release();
+        if (m_historySRV[i]) m_historySRV[i]->Release();
+    }
+    if (m_mergeTileBuffer) m_mergeTileBuffer->Release();
+    if (m_mergeTileSRV) m_mergeTileSRV->Release();
+    if (m_mergeTileShapeBuffer) m_mergeTileShapeBuffer->Release();
+    if (m_mergeTileShapeSRV) m_mergeTileShapeSRV->Release();
+    if (m_glowLUT) m_glowLUT->Release();
+    if (m_blueNoise) m_blueNoise->Release();
+    m_profiler.Release();
     if (m_linearSampler) m_linearSampler->Release();
+    if (m_wrapSampler) m_wrapSampler->Release();
     if (m_rasterizerState) m_rasterizerState->Release();
+    if (m_scissorRasterizerState) m_scissorRasterizerState->Release();
     if (m_blendState) m_blendState->Release();
     if (m_depthStencilState) m_depthStencilState->Release();
 
     for (auto& bg : m_backgrounds)
     {
         if (bg.texture) bg.texture->Release();
+        delete bg.animation;
+    }
+    m_backgrounds.clear();
+}
+
+void LiquidGlass::RegisterTimelineTracks()
+{
+    ShaderParams& p = m_shaderParams;
+    m_timeline.AddTrack("powerFactor", &p.u_powerFactor);
+    m_timeline.AddTrack("a", &p.u_a);
+    m_timeline.AddTrack("b", &p.u_b);
+    m_timeline.AddTrack("c", &p.u_c);
+    m_timeline.AddTrack("d", &p.u_d);
+    m_timeline.AddTrack("fPower", &p.u_fPower);
+    m_timeline.AddTrack("noise", &p.u_noise);
+    m_timeline.AddTrack("glowWeight", &p.u_glowWeight);
+    m_timeline.AddTrack("glowBias", &p.u_glowBias);
+    m_timeline.AddTrack("glowEdge0", &p.u_glowEdge0);
+    m_timeline.AddTrack("glowEdge1", &p.u_glowEdge1);
+    m_timeline.AddTrack("dispersion", &p.u_dispersion);
+    m_timeline.AddTrack("dispersionBand", &p.u_dispersionBand);
+    m_timeline.AddTrack("specular", &p.u_specular);
+    m_timeline.AddTrack("shininess", &p.u_shininess);
+    m_timeline.AddTrack("fresnel", &p.u_fresnel);
+    m_timeline.AddTrack("lightDir.x", &p.u_lightDir.x);
+    m_timeline.AddTrack("lightDir.y", &p.u_lightDir.y);
+    m_timeline.AddTrack("lightDir.z", &p.u_lightDir.z);
+    m_timeline.AddTrack("bevel", &p.u_bevel);
+    m_timeline.AddTrack("exact", &p.u_exact);
+    m_timeline.AddTrack("positionX", &m_position.x);
+    m_timeline.AddTrack("positionY", &m_position.y);
+    m_timeline.AddTrack("width", &m_width);
+    m_timeline.AddTrack("height", &m_height);
+    m_timeline.AddTrack("blurRadius", &m_blurParams.u_radius);
+}
+
+void LiquidGlass::CapturePreset(GlassPreset& preset) const
+{
+    preset.shader = m_shaderParams;
+    preset.blurRadius = m_blurParams.u_radius;
+    preset.blurIterations = (float)m_blurIterations;
+    preset.blurDownscale = m_blurDownscaleFactor;
+    preset.width = m_width;
+    preset.height = m_height;
+    preset.shape = (float)m_shape;
+    preset.cornerRadii = m_cornerRadii;
+}
+
+void LiquidGlass::ApplyPreset(const GlassPreset& preset)
+{
+    m_shaderParams = preset.shader;
+    m_blurParams.u_radius = preset.blurRadius;
+    m_blurIterations = (int)(preset.blurIterations + 0.5f);
+    m_blurDownscaleFactor = preset.blurDownscale;
+    m_width = preset.width;
+    m_height = preset.height;
+    int shape = (int)(preset.shape + 0.5f);
+    m_shape = (GlassShapeType)(shape < 0 ? 0 : shape >= GlassShape_COUNT ? GlassShape_COUNT - 1 : shape);
+    m_cornerRadii = preset.cornerRadii;
+}
+
+int LiquidGlass::FindPreset(const char* name) const
+{
+    for (int i = 0; i < (int)m_presets.size(); i++)
+        if (strcmp(m_presets[i].name, name) == 0)
+            return i;
+    return -1;
+}
+
+bool LiquidGlass::SavePreset(const char* name)
+{
+    // "Current" is the ini entry of the live values
+    if (!name[0] || strcmp(name, "Current") == 0)
+        return false;
+
+    int index = FindPreset(name);
+    if (index < 0)
+    {
+        GlassPresetEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        ImStrncpy(entry.name, name, GlassPresetNameSize);
+        m_presets.push_back(entry);
+        index = (int)m_presets.size() - 1;
     }
+    CapturePreset(m_presets[index].preset);
+    if (m_settingsHandler)
+        ImGui::MarkIniSettingsDirty();
+    return true;
+}
+
+bool LiquidGlass::LoadPreset(const char* name)
+{
+    int index = FindPreset(name);
+    if (index < 0)
+        return false;
+    ApplyPreset(m_presets[index].preset);
+    return true;
+}
+
+bool LiquidGlass::SavePresetFile(const char* path) const
+{
+    return WriteGlassPresetFile(path, m_presets);
+}
+
+bool LiquidGlass::LoadPresetFile(const char* path)
+{
+    std::vector<GlassPresetEntry> presets;
+    if (!ReadGlassPresetFile(path, presets))
+        return false;
+    m_presets.swap(presets);
+    if (m_settingsHandler)
+        ImGui::MarkIniSettingsDirty();
+    return true;
+}
+
+// [LiquidGlass][Current] holds the live values, every other [LiquidGlass][name] entry a named preset.
+// A handler without UserData belongs to a destroyed LiquidGlass and only writes back what it left.
+void LiquidGlass::RegisterSettingsHandler()
+{
+    ImGuiSettingsHandler handler;
+    handler.TypeName = "LiquidGlass";
+    handler.TypeHash = ImHashStr("LiquidGlass");
+    handler.ReadOpenFn = SettingsHandler_ReadOpen;
+    handler.ReadLineFn = SettingsHandler_ReadLine;
+    handler.ApplyAllFn = SettingsHandler_ApplyAll;
+    handler.WriteAllFn = SettingsHandler_WriteAll;
+    handler.UserData = this;
+    ImGui::AddSettingsHandler(&handler);
+    m_settingsHandler = true;
+}
+
+void* LiquidGlass::SettingsHandler_ReadOpen(ImGuiContext*, ImGuiSettingsHandler* handler, const char* name)
+{
+    // Fields missing from the file keep the values in use
+    LiquidGlass* glass = (LiquidGlass*)handler->UserData;
+    if (!glass)
+        return nullptr;
+    if (strcmp(name, "Current") == 0)
+    {
+        glass->CapturePreset(glass->m_iniPreset);
+        glass->m_iniPresetRead = true;
+        return &glass->m_iniPreset;
+    }
+
+    int index = glass->FindPreset(name);
+    if (index < 0)
+    {
+        GlassPresetEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        ImStrncpy(entry.name, name, GlassPresetNameSize);
+        glass->CapturePreset(entry.preset);
+        glass->m_presets.push_back(entry);
+        index = (int)glass->m_presets.size() - 1;
+    }
+
+    // Only used until the next entry is opened, before the vector can grow again
+    return &glass->m_presets[index].preset;
+}
+
+void LiquidGlass::SettingsHandler_ReadLine(ImGuiContext*, ImGuiSettingsHandler*, void* entry, const char* line)
+{
+    ReadGlassPresetLine(*(GlassPreset*)entry, line);
+}
+
+void LiquidGlass::SettingsHandler_ApplyAll(ImGuiContext*, ImGuiSettingsHandler* handler)
+{
+    LiquidGlass* glass = (LiquidGlass*)handler->UserData;
+    if (glass && glass->m_iniPresetRead)
+    {
+        glass->ApplyPreset(glass->m_iniPreset);
+        glass->m_iniPresetRead = false;
+    }
+}
+
+void LiquidGlass::SettingsHandler_WriteAll(ImGuiContext*, ImGuiSettingsHandler* handler, ImGuiTextBuffer* buf)
+{
+    LiquidGlass* glass = (LiquidGlass*)handler->UserData;
+    if (!glass)
+    {
+        buf->append(s_detachedSettings.begin(), s_detachedSettings.end());
+        return;
+    }
+    GlassPreset current;
+    glass->CapturePreset(current);
+    WriteGlassPresetText(buf, handler->TypeName, "Current", current);
+    for (const GlassPresetEntry& entry : glass->m_presets)
+        WriteGlassPresetText(buf, handler->TypeName, entry.name, entry.preset);
 }
 
 void LiquidGlass::Update(float deltaTime)
 {
     ImGuiIO& io = ImGui::GetIO();
 
+    // Keyframed parameters first, the keys below still move a paused or unkeyed panel
+    m_timeline.Update(deltaTime);
+
     // Handle object movement (WASD keys)
     if (!m_mouseControl)
     {
@@ -215,35 +632,68 @@ void LiquidGlass::Update(float deltaTime)
         m_velocityMultiplier = max(0.0f, min(1.0f, m_velocityMultiplier));
     }
 
-    // Handle camera movement (Arrow keys)
+    // Handle camera movement (Arrow keys), in screen halves per second at any zoom
     bool cameraKeyPressed = false;
+    float panX = 0.0f, panY = 0.0f;
     if (ImGui::IsKeyDown(ImGuiKey_UpArrow)) {
-        m_cameraPosition.y -= deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
+        panY -= deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
         cameraKeyPressed = true;
     }
     if (ImGui::IsKeyDown(ImGuiKey_DownArrow)) {
-        m_cameraPosition.y += deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
+        panY += deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
         cameraKeyPressed = true;
     }
     if (ImGui::IsKeyDown(ImGuiKey_RightArrow)) {
-        m_cameraPosition.x -= deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
+        panX -= deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
         cameraKeyPressed = true;
     }
     if (ImGui::IsKeyDown(ImGuiKey_LeftArrow)) {
-        m_cameraPosition.x += deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
+        panX += deltaTime * m_cameraVelocityMultiplier * m_cameraVelocity;
         cameraKeyPressed = true;
     }
+    XMFLOAT2 viewSize = m_camera.GetViewSize();
+    m_camera.Pan(panX * viewSize.x * 0.5f, panY * viewSize.y * 0.5f);
 
     m_cameraVelocityMultiplier += (cameraKeyPressed ? 1.0f : -3.0f) * deltaTime;
     m_cameraVelocityMultiplier = max(0.0f, min(1.0f, m_cameraVelocityMultiplier));
 
+    // Scroll zooms around the cursor, right drag pans, unless a window other than a
+    // backdrop (like main.cpp's fullscreen background) is under the mouse
+    ImGuiWindow* hovered = GImGui->HoveredWindow;
+    if (!hovered || (hovered->Flags & ImGuiWindowFlags_NoBringToFrontOnFocus))
+    {
+        if (io.MouseWheel != 0.0f)
+            m_camera.ZoomAt(powf(1.1f, io.MouseWheel), io.MousePos.x, io.MousePos.y);
+        if (ImGui::IsMouseDragging(ImGuiMouseButton_Right, 0.0f))
+            m_camera.PanPixels(io.MouseDelta.x, io.MouseDelta.y);
+    }
+
+    // Advance the animated background, a new frame bumps its revision and invalidates the blur cache
+    if (m_currentBackgroundId >= 0 && m_currentBackgroundId < (int)m_backgrounds.size())
+    {
+        Background& bg = m_backgrounds[m_currentBackgroundId];
+        if (bg.animation)
+            bg.animation->Update(m_context, deltaTime);
+    }
+
     // Mouse control
     if (m_mouseControl)
     {
-        float mouseX = (io.MousePos.x / m_screenWidth - 0.5f) * 15.0f;
-        float mouseY = -(io.MousePos.y / m_screenHeight - 0.5f) * 15.0f * m_screenHeight / m_screenWidth;
-        m_position.x = mouseX;
-        m_position.y = mouseY;
+        XMFLOAT2 mouse = m_camera.ScreenToWorld(io.MousePos.x, io.MousePos.y);
+        m_position.x = mouse.x;
+        m_position.y = mouse.y;
+    }
+
+    // Slider and timeline edits reach imgui.ini at the usual io.IniSavingRate
+    if (m_settingsHandler)
+    {
+        GlassPreset current;
+        CapturePreset(current);
+        if (memcmp(&current, &m_iniPreset, sizeof(GlassPreset)) != 0)
+        {
+            m_iniPreset = current;
+            ImGui::MarkIniSettingsDirty();
+        }
     }
 }
 
@@ -251,6 +701,7 @@ void LiquidGlass::OnResize(int width, int height)
 {
     m_screenWidth = width;
     m_screenHeight = height;
+    m_camera.SetViewport(width, height);
 
     // Release old render targets
     if (m_backgroundRT) m_backgroundRT->Release();
@@ -262,9 +713,31 @@ void LiquidGlass::OnResize(int width, int height)
     if (m_blurFinalRT) m_blurFinalRT->Release();
     if (m_blurFinalRTV) m_blurFinalRTV->Release();
     if (m_blurFinalSRV) m_blurFinalSRV->Release();
+    if (m_sceneSnapshotRT) m_sceneSnapshotRT->Release();
+    if (m_sceneSnapshotSRV) m_sceneSnapshotSRV->Release();
+    if (m_sceneBlurRT) m_sceneBlurRT->Release();
+    if (m_sceneBlurRTV) m_sceneBlurRTV->Release();
+    if (m_sceneBlurSRV) m_sceneBlurSRV->Release();
+    if (m_interiorRT) m_interiorRT->Release();
+    if (m_interiorRTV) m_interiorRTV->Release();
+    if (m_interiorSRV) m_interiorSRV->Release();
+    for (int i = 0; i < 2; i++)
+    {
+        if (m_historyRT[i]) m_historyRT[i]->Release();
+        if (m_historyRTV[i]) m_historyRTV[i]->Release();
+        if (m_historySRV[i]) m_historySRV[i]->Release();
+    }
+    if (m_mergeTileBuffer) m_mergeTileBuffer->Release();
+    if (m_mergeTileSRV) m_mergeTileSRV->Release();
+    if (m_mergeTileShapeBuffer) m_mergeTileShapeBuffer->Release();
+    if (m_mergeTileShapeSRV) m_mergeTileShapeSRV->Release();
 
     // Recreate render targets
     CreateRenderTargets(width, height);
+    m_renderTargetRevision++;
+    m_blurCacheValid = false;
+    m_mergeBinsValid = false;
+    m_historyWritten = false;
 }
 
 void LiquidGlass::RenderUI()
@@ -274,7 +747,7 @@ void LiquidGlass::RenderUI()
     ImGui::SetNextWindowSize(ImVec2(550, 680), ImGuiCond_FirstUseEver);
     
     // Begin window without close button to ensure it's always visible
-    if (!ImGui::Begin("Liquid Glass Settings", nullptr, ImGuiWindowFlags_None))
+    if (!BeginGlassWindow("Liquid Glass Settings", nullptr, ImGuiWindowFlags_None))
     {
         // Window is collapsed, but still need to end it
         ImGui::End();
@@ -285,9 +758,48 @@ void LiquidGlass::RenderUI()
     ImGui::Text("LOADED IMAGE:");
     if (m_currentBackgroundId >= 0 && m_currentBackgroundId < (int)m_backgrounds.size())
     {
+        if (m_backgrounds.size() > 1 && ImGui::BeginCombo("Background", m_backgrounds[m_currentBackgroundId].name.c_str()))
+        {
+            for (int i = 0; i < (int)m_backgrounds.size(); i++)
+                if (ImGui::Selectable(m_backgrounds[i].name.c_str(), i == m_currentBackgroundId))
+                    m_currentBackgroundId = i;
+            ImGui::EndCombo();
+        }
+
         Background& bg = m_backgrounds[m_currentBackgroundId];
-        ImGui::Image((void*)bg.texture, ImVec2(512, 288));
+        ImGui::Image((void*)GetBackgroundTexture(bg), ImVec2(512, 288));
         ImGui::Text("Size: %dx%d", bg.width, bg.height);
+
+        if (bg.animation)
+        {
+            bool playing = bg.animation->IsPlaying();
+            if (ImGui::Checkbox("Play", &playing))
+                bg.animation->SetPlaying(playing);
+            ImGui::SameLine();
+            ImGui::Text("Frame %d/%d", bg.animation->GetFrameIndex() + 1, bg.animation->GetFrameCount());
+            ImGui::Text("Frame upload: %.1f KB (%.0f%% of a full frame)", bg.animation->GetLastUploadBytes() / 1024.0f,
+                100.0f * bg.animation->GetLastUploadBytes() / ((size_t)bg.width * bg.height * 4));
+            ImGui::Text("GPU memory: %.1f MB (%d frame ring)", bg.memoryBytes / (1024.0f * 1024.0f), (int)AnimatedBackground::MaxRingSize);
+        }
+        else
+        {
+            // BC1 is quick to encode, BC7 keeps gradients clean; both are cached on disk after the first bake
+            const char* formats[] = { "RGBA8", "BC1 (fast)", "BC7 (quality)" };
+            int format = (int)bg.format;
+            if (ImGui::Combo("Texture Format", &format, formats, IM_ARRAYSIZE(formats)) && format != (int)bg.format)
+            {
+                if (!ReloadBackground(bg, (BackgroundCacheFormat)format))
+                    MessageBoxW(nullptr, L"Failed to reload background texture", L"Texture Load Warning", MB_OK | MB_ICONWARNING);
+            }
+            size_t rgbaBytes = 0;
+            for (int w = bg.width, h = bg.height; ; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1)
+            {
+                rgbaBytes += (size_t)w * h * 4;
+                if (w == 1 && h == 1) break;
+            }
+            ImGui::Text("GPU memory: %.1f MB (%.0f%% of RGBA8)", bg.memoryBytes / (1024.0f * 1024.0f), 100.0f * bg.memoryBytes / rgbaBytes);
+        }
+        ImGui::Text("Blur cache: %d hits, %d misses", m_blurCacheHits, m_blurCacheMisses);
     }
     else
     {
@@ -299,23 +811,93 @@ void LiquidGlass::RenderUI()
     ImGui::BulletText("WASD - Move glass object");
     ImGui::BulletText("Arrow Keys - Move camera");
     ImGui::BulletText("Mouse Scroll - Zoom");
+    ImGui::BulletText("Right Drag - Pan camera");
     
     ImGui::Separator();
     ImGui::Checkbox("Move with mouse", &m_mouseControl);
+    ImGui::Checkbox("Glass windows", &m_glassWindows);
+    if (m_glassWindows)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("Glass sees glass", &m_glassSeesGlass);
+        ImGui::Text("Glass windows: %d, scene snapshots: %d (%d blurs saved)", m_lastGlassStats.glassWindows,
+            m_lastGlassStats.snapshots, m_lastGlassStats.glassWindows - m_lastGlassStats.snapshots);
+    }
 
     ImGui::Separator();
     if (ImGui::CollapsingHeader("Shape", ImGuiTreeNodeFlags_DefaultOpen))
     {
-        ImGui::SliderFloat("Power", &m_shaderParams.u_powerFactor, 1.001f, 6.0f);
+        int shape = (int)m_shape;
+        if (ImGui::Combo("Shape", &shape, GlassShapeNames, GlassShape_COUNT))
+            m_shape = (GlassShapeType)shape;
+        if (m_shape == GlassShape_Superellipse)
+            ImGui::SliderFloat("Power", &m_shaderParams.u_powerFactor, 1.001f, 6.0f);
+        if (m_shape == GlassShape_RoundedRect)
+            ImGui::SliderFloat4("Corner radii", &m_cornerRadii.x, 0.0f, 1.0f);
         ImGui::SliderFloat("Width", &m_width, 0.0f, 10.0f);
         ImGui::SliderFloat("Height", &m_height, 0.0f, 10.0f);
     }
 
+    if (ImGui::CollapsingHeader("Liquid Merge"))
+    {
+        ImGui::Checkbox("Liquid merge", &m_liquidMerge);
+        ImGui::SliderFloat("Merge radius (px)", &m_mergeRadius, 0.0f, 200.0f);
+        int removed = -1;
+        for (int i = 0; i < (int)m_mergePanels.size(); i++)
+        {
+            ImGui::PushID(i);
+            ImGui::Text("Panel %d", i + 1);
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Remove"))
+                removed = i;
+            ImGui::DragFloat2("Position", &m_mergePanels[i].position.x, 0.01f);
+            ImGui::DragFloat2("Half size", &m_mergePanels[i].size.x, 0.01f, 0.01f, 10.0f);
+            int panelShape = (int)m_mergePanels[i].shape;
+            if (ImGui::Combo("Shape", &panelShape, GlassShapeNames, GlassShape_COUNT))
+                m_mergePanels[i].shape = (GlassShapeType)panelShape;
+            if (m_mergePanels[i].shape == GlassShape_RoundedRect)
+                ImGui::SliderFloat4("Corner radii", &m_mergePanels[i].cornerRadii.x, 0.0f, 1.0f);
+            ImGui::PopID();
+        }
+        if (removed >= 0)
+            m_mergePanels.erase(m_mergePanels.begin() + removed);
+        if ((int)m_mergePanels.size() + 1 < MaxMergeShapes && ImGui::Button("Add panel"))
+        {
+            GlassPanel panel;
+            panel.position = XMFLOAT2(m_position.x + m_width * 2.0f, m_position.y);
+            panel.size = XMFLOAT2(m_width, m_height);
+            panel.shape = m_shape;
+            panel.cornerRadii = m_cornerRadii;
+            m_mergePanels.push_back(panel);
+        }
+
+        if (m_liquidMerge && m_mergeBinsValid)
+        {
+            // Shape evaluations per pixel against blending every panel over the same quad
+            int tiles = m_mergeBins.tilesX * m_mergeBins.tilesY;
+            float binned = m_mergeBins.occupiedTiles ? (float)m_mergeBins.shapes.size() / m_mergeBins.occupiedTiles : 0.0f;
+            ImGui::Text("Tiles: %d of %d binned, %.2f panels per tile (of %d)", m_mergeBins.occupiedTiles, tiles, binned, m_mergeShapeCount);
+            ImGui::Text("Re-binned %d times", m_mergeRebins);
+            if (ImGui::Button("Validate bins (CPU)"))
+                m_mergeValidationError = ValidateMergeBins(m_mergeShapes, m_mergeShapeCount, m_mergeBins, m_mergeBinsPower,
+                    m_mergeBinsRadius, m_screenWidth, m_screenHeight, 2);
+            if (m_mergeValidationError >= 0.0f)
+            {
+                ImGui::SameLine();
+                ImGui::Text("binned vs all panels: max %.3f px", m_mergeValidationError);
+            }
+        }
+    }
+
     if (ImGui::CollapsingHeader("Blur & Noise", ImGuiTreeNodeFlags_DefaultOpen))
     {
         ImGui::SliderInt("Blur Iterations", &m_blurIterations, 0, 10);
         ImGui::SliderFloat("Blur Radius", &m_blurParams.u_radius, 0.0f, 10.0f);
         ImGui::SliderFloat("Blur Downscale", &m_blurDownscaleFactor, 0.1f, 1.0f);
+        ImGui::Checkbox("Blur only the sampled region", &m_blurRegionOfInterest);
+        ImGui::Text("Blurred: %.0f%% of the background, %.0f%% of the scene", m_blurArea * 100.0f, m_sceneBlurArea * 100.0f);
+        ImGui::TextDisabled("Background region: %dx%d of %dx%d texels", m_blurRegion[2] - m_blurRegion[0], m_blurRegion[3] - m_blurRegion[1],
+            (int)(m_screenWidth * m_blurDownscaleFactor), (int)(m_screenHeight * m_blurDownscaleFactor));
         ImGui::SliderFloat("Noise", &m_shaderParams.u_noise, 0.0f, 0.3f);
     }
 
@@ -327,6 +909,13 @@ void LiquidGlass::RenderUI()
         ImGui::SliderFloat("b", &m_shaderParams.u_b, 0.0f, 6.0f);
         ImGui::SliderFloat("c", &m_shaderParams.u_c, 0.0f, 6.0f);
         ImGui::SliderFloat("d", &m_shaderParams.u_d, 0.0f, 10.0f);
+        const char* refractionModes[] = { "Exact", "Folded exp2", "Cubic fit" };
+        int refractionMode = (int)m_refractionMode;
+        if (ImGui::Combo("Evaluation", &refractionMode, refractionModes, IM_ARRAYSIZE(refractionModes)))
+            m_refractionMode = (GlassRefractionMode)refractionMode;
+        ImGui::Text("Max scale error: %.1e", GetRefractionError());
+        if (m_refractionMode == GlassRefraction_Cubic && !m_refractionFit.cubicValid)
+            ImGui::TextDisabled("Cubic fit needs c*e >= 1, folded instead");
     }
 
     if (ImGui::CollapsingHeader("Glow", ImGuiTreeNodeFlags_DefaultOpen))
@@ -335,6 +924,232 @@ void LiquidGlass::RenderUI()
         ImGui::SliderFloat("Glow Bias", &m_shaderParams.u_glowBias, -1.0f, 1.0f);
         ImGui::SliderFloat("Glow Edge0", &m_shaderParams.u_glowEdge0, -1.0f, 1.0f);
         ImGui::SliderFloat("Glow Edge1", &m_shaderParams.u_glowEdge1, -1.0f, 1.0f);
+        bool exact = m_shaderParams.u_exact > 0.0f;
+        if (ImGui::Checkbox("Exact glow/noise (validation)", &exact))
+            m_shaderParams.u_exact = exact ? 1.0f : 0.0f;
+        ImGui::SetItemTooltip("atan2/sin glow and hashed noise per pixel instead of the %d texel glow LUT and %dx%d blue noise tile",
+            (int)GlowLUTSize, (int)BlueNoiseSize, (int)BlueNoiseSize);
+    }
+
+    if (ImGui::CollapsingHeader("Lighting", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        ImGui::SliderFloat("Specular", &m_shaderParams.u_specular, 0.0f, 2.0f);
+        ImGui::SliderFloat("Shininess", &m_shaderParams.u_shininess, 1.0f, 256.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Fresnel Rim", &m_shaderParams.u_fresnel, 0.0f, 1.0f);
+        ImGui::SliderFloat("Bevel", &m_shaderParams.u_bevel, 0.01f, 1.0f);
+        if (ImGui::SliderFloat3("Light Direction", &m_shaderParams.u_lightDir.x, -1.0f, 1.0f))
+        {
+            XMFLOAT3& l = m_shaderParams.u_lightDir;
+            float length = sqrtf(l.x * l.x + l.y * l.y + l.z * l.z);
+            if (length > 0.0001f)
+                l = XMFLOAT3(l.x / length, l.y / length, l.z / length);
+            else
+                l = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Dispersion"))
+    {
+        ImGui::SliderFloat("Strength", &m_shaderParams.u_dispersion, 0.0f, 2.0f);
+        ImGui::SliderFloat("Edge Band", &m_shaderParams.u_dispersionBand, 0.0f, 1.0f);
+
+        // Three fetches inside the band, one elsewhere
+        UpdateDispersionStats();
+        float fraction = m_shaderParams.u_dispersion > 0.0f ? m_dispersionBandFraction : 0.0f;
+        float pixelsPerUnit = m_camera.GetPixelsPerUnit();
+        float glassPixels = 4.0f * m_width * m_height * pixelsPerUnit * pixelsPerUnit * m_dispersionInsideFraction;
+        ImGui::Text("Band: %.1f%% of the glass, %.2f fetches/pixel", fraction * 100.0f, 1.0f + 2.0f * fraction);
+        ImGui::Text("Extra fetches at this size: %.0f (of %.0f pixels)", 2.0f * fraction * glassPixels, glassPixels);
+    }
+    
+    if (ImGui::CollapsingHeader("Variable Rate Shading"))
+    {
+        const char* rates[] = { "Full", "1/2", "1/4" };
+        int rateIndex = m_shadingRate >= 4 ? 2 : m_shadingRate - 1;
+        if (ImGui::Combo("Interior Rate", &rateIndex, rates, IM_ARRAYSIZE(rates)))
+            m_shadingRate = 1 << rateIndex;
+        ImGui::SliderFloat("Interior Band", &m_interiorBand, 0.0f, 1.0f);
+        ImGui::SetItemTooltip("Distance from the edge shaded at full rate: refraction, bevel and glow change fast there");
+        if (m_liquidMerge)
+        {
+            ImGui::TextDisabled("Main panel only, off while liquid merge is on");
+        }
+        else
+        {
+            UpdateShadingRateStats();
+            ImGui::Text("Upsampled: %.1f%% of the glass, shading saved: %.1f%%", m_shadingRateInterior * 100.0f, m_shadingRateSaved * 100.0f);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Temporal Reuse"))
+    {
+        ImGui::Checkbox("Reuse last frame's glass", &m_temporalReuse);
+        ImGui::SetItemTooltip("While only the panel moves, its interior shows the same background pixels as last frame");
+        ImGui::SliderFloat("Max Drift (px)", &m_historyTolerance, 0.1f, 4.0f);
+        ImGui::SetItemTooltip("How far the refracted sample may be from the pixel where the output is reused, reused pixels are off by twice that at most");
+        if (m_liquidMerge)
+            ImGui::TextDisabled("Main panel only, off while liquid merge is on");
+        else if (m_historyStart <= 0.0f)
+            ImGui::TextDisabled("The glow or refraction never settles inwards, nothing to reuse");
+        else
+            ImGui::Text("Reused: %.1f%% of the glass (past %.3f from the edge)", m_historyReuseRatio * 100.0f, m_historyStart);
+        ImGui::Text("Invalidations: %d", m_historyInvalidations);
+    }
+
+    if (ImGui::CollapsingHeader("Profiler"))
+    {
+        m_profiler.DrawPanel();
+        const GlassReplayStats& stats = m_lastReplayStats;
+        ImGui::Text("Command lists: %d replays, %d commands, %d re-records", stats.replays, stats.commands, m_passListRecords);
+        ImGui::Text("State changes: %d, redundant skipped: %d", stats.stateChanges, stats.redundant);
+        ImGui::Text("Constant uploads: %d, unchanged skipped: %d", stats.uploads, stats.uploadSkips);
+        ImGui::Text("Buffer maps: %d per frame", m_lastFrameMaps);
+        int recordThreads = m_recordThreads;
+        if (ImGui::SliderInt("Recording threads", &recordThreads, 0, D3D11ParallelReplay::MaxThreads))
+            SetRecordThreads(recordThreads);
+        if (m_recordThreads > 0)
+            ImGui::Text("Deferred contexts, command lists %s", m_parallelReplay.HasDriverCommandLists() ? "in the driver" : "emulated by the runtime");
+        else
+            ImGui::TextDisabled("Replayed on the immediate context");
+        ImGui::Text("Input assembly: %d bytes of vertices and indices", stats.inputBytes);
+    }
+
+    if (ImGui::CollapsingHeader("Camera"))
+    {
+        float zoom = m_camera.GetZoom();
+        if (ImGui::SliderFloat("Zoom", &zoom, OrthoCamera::MinZoom, OrthoCamera::MaxZoom, "%.2fx", ImGuiSliderFlags_Logarithmic))
+            m_camera.SetZoom(zoom);
+        const char* fits[] = { "Fit Width", "Fit Height", "Contain" };
+        int fit = (int)m_camera.GetFit();
+        if (ImGui::Combo("Viewport Fit", &fit, fits, IM_ARRAYSIZE(fits)))
+            m_camera.SetFit((CameraFit)fit);
+        if (ImGui::Button("Reset Camera"))
+            m_camera.Reset();
+        XMFLOAT2 position = m_camera.GetPosition();
+        XMFLOAT2 viewSize = m_camera.GetViewSize();
+        ImGui::Text("Center: %.2f, %.2f  View: %.2f x %.2f units", position.x, position.y, viewSize.x, viewSize.y);
+        ImGui::Text("Transform uploads: %d, skipped: %d", m_transformUploads, m_transformSkips);
+    }
+
+    if (ImGui::CollapsingHeader("Presets"))
+    {
+        ImGui::InputText("Name", m_presetName, IM_ARRAYSIZE(m_presetName));
+        ImGui::SameLine();
+        if (ImGui::Button("Save"))
+            SavePreset(m_presetName);
+
+        int remove = -1;
+        for (int i = 0; i < (int)m_presets.size(); i++)
+        {
+            ImGui::PushID(i);
+            if (ImGui::SmallButton("X"))
+                remove = i;
+            ImGui::SameLine();
+            if (ImGui::Selectable(m_presets[i].name))
+            {
+                ApplyPreset(m_presets[i].preset);
+                strcpy(m_presetName, m_presets[i].name);
+            }
+            ImGui::PopID();
+        }
+        if (remove >= 0)
+        {
+            m_presets.erase(m_presets.begin() + remove);
+            ImGui::MarkIniSettingsDirty();
+        }
+
+        // Blends the stored snapshots directly, nothing is parsed while dragging
+        if (m_presets.size() >= 2)
+        {
+            m_presetBlendA = min(m_presetBlendA, (int)m_presets.size() - 1);
+            m_presetBlendB = min(m_presetBlendB, (int)m_presets.size() - 1);
+            bool blendChanged = false;
+            int* blendPresets[2] = { &m_presetBlendA, &m_presetBlendB };
+            const char* blendLabels[2] = { "From", "To" };
+            for (int side = 0; side < 2; side++)
+            {
+                if (ImGui::BeginCombo(blendLabels[side], m_presets[*blendPresets[side]].name))
+                {
+                    for (int i = 0; i < (int)m_presets.size(); i++)
+                    {
+                        ImGui::PushID(i);
+                        if (ImGui::Selectable(m_presets[i].name, i == *blendPresets[side]))
+                        {
+                            *blendPresets[side] = i;
+                            blendChanged = true;
+                        }
+                        ImGui::PopID();
+                    }
+                    ImGui::EndCombo();
+                }
+            }
+            blendChanged |= ImGui::SliderFloat("Blend", &m_presetBlend, 0.0f, 1.0f);
+            if (blendChanged)
+            {
+                GlassPreset blended;
+                LerpGlassPreset(m_presets[m_presetBlendA].preset, m_presets[m_presetBlendB].preset, m_presetBlend, blended);
+                ApplyPreset(blended);
+            }
+        }
+
+        if (ImGui::Button("Save presets.lgps") && !SavePresetFile("presets.lgps"))
+            MessageBoxW(nullptr, L"Failed to write presets.lgps", L"Preset Warning", MB_OK | MB_ICONWARNING);
+        ImGui::SameLine();
+        if (ImGui::Button("Load presets.lgps") && !LoadPresetFile("presets.lgps"))
+            MessageBoxW(nullptr, L"Failed to read presets.lgps", L"Preset Warning", MB_OK | MB_ICONWARNING);
+        ImGui::Text("%d presets, %d bytes each in the binary file", (int)m_presets.size(), (int)sizeof(GlassPresetEntry));
+    }
+
+    if (ImGui::CollapsingHeader("Timeline"))
+    {
+        bool playing = m_timeline.IsPlaying();
+        if (ImGui::Checkbox("Play##Timeline", &playing))
+            m_timeline.SetPlaying(playing);
+        ImGui::SameLine();
+        bool looping = m_timeline.IsLooping();
+        if (ImGui::Checkbox("Loop", &looping))
+            m_timeline.SetLooping(looping);
+
+        float time = m_timeline.GetTime();
+        float duration = m_timeline.GetDuration();
+        if (ImGui::SliderFloat("Time", &time, 0.0f, max(duration, 1.0f), "%.2f s"))
+            m_timeline.SetTime(time);
+
+        // Keys the track's current value (set it with the sliders above) at the current time
+        if (ImGui::BeginCombo("Track", m_timeline.GetTrackName(m_timelineTrack)))
+        {
+            for (int i = 0; i < m_timeline.GetTrackCount(); i++)
+            {
+                char label[64];
+                snprintf(label, sizeof(label), "%s (%d keys)", m_timeline.GetTrackName(i), m_timeline.GetKeyCount(i));
+                if (ImGui::Selectable(label, i == m_timelineTrack))
+                    m_timelineTrack = i;
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::BeginCombo("Easing", GetTimelineEasingName((TimelineEasing)m_timelineEasing)))
+        {
+            for (int i = 0; i < TimelineEasing_COUNT; i++)
+                if (ImGui::Selectable(GetTimelineEasingName((TimelineEasing)i), i == m_timelineEasing))
+                    m_timelineEasing = i;
+            ImGui::EndCombo();
+        }
+        if (ImGui::Button("Key Track"))
+            m_timeline.SetKeyFromTarget(m_timelineTrack, time, (TimelineEasing)m_timelineEasing);
+        ImGui::SameLine();
+        if (ImGui::Button("Key All"))
+            for (int i = 0; i < m_timeline.GetTrackCount(); i++)
+                m_timeline.SetKeyFromTarget(i, time, (TimelineEasing)m_timelineEasing);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Track"))
+            m_timeline.ClearTrack(m_timelineTrack);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear All"))
+            m_timeline.Clear();
+
+        ImGui::Text("%d keys, %.2f s, %d values changed this frame", m_timeline.GetTotalKeyCount(), duration,
+            m_timeline.GetLastChangedCount());
+        ImGui::Text("Shader params uploads: %d, skipped: %d", m_shaderParamsUploads, m_shaderParamsSkips);
     }
     
     // DEBUG: Show textures
@@ -352,7 +1167,7 @@ void LiquidGlass::RenderUI()
         if (m_currentBackgroundId >= 0 && m_currentBackgroundId < (int)m_backgrounds.size())
         {
             Background& bg = m_backgrounds[m_currentBackgroundId];
-            ImGui::Image((void*)bg.texture, ImVec2(256, 144));
+            ImGui::Image((void*)GetBackgroundTexture(bg), ImVec2(256, 144));
             ImGui::Text("Size: %dx%d", bg.width, bg.height);
         }
     }
@@ -378,24 +1193,28 @@ bool LiquidGlass::CreateShaders()
     m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &m_liquidGlassVS);
 
     D3D11_INPUT_ELEMENT_DESC layout[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "BLENDINDICES", 0, DXGI_FORMAT_R32_UINT, 0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+        { "POSITION", 0, DXGI_FORMAT_R16G16_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, 4, D3D11_INPUT_PER_VERTEX_DATA, 0 }
     };
-    m_device->CreateInputLayout(layout, 4, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_inputLayout);
+    m_device->CreateInputLayout(layout, 2, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_inputLayout);
     vsBlob->Release();
 
-    // Compile Liquid Glass Pixel Shader
-    hr = D3DCompileFromFile(L"shaders/LiquidGlassPS.hlsl", nullptr, nullptr, "main", "ps_5_0",
-        D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &psBlob, &errorBlob);
-    if (FAILED(hr))
+    // Compile Liquid Glass Pixel Shader, a variant per main panel shape (GLASS_SHAPE)
+    for (int shape = 0; shape < GlassShape_COUNT; shape++)
     {
-        if (errorBlob) { OutputDebugStringA((char*)errorBlob->GetBufferPointer()); errorBlob->Release(); }
-        return false;
+        char shapeDefine[8];
+        snprintf(shapeDefine, sizeof(shapeDefine), "%d", shape);
+        D3D_SHADER_MACRO defines[] = { { "GLASS_SHAPE", shapeDefine }, { nullptr, nullptr } };
+        hr = D3DCompileFromFile(L"shaders/LiquidGlassPS.hlsl", defines, nullptr, "main", "ps_5_0",
+            D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &psBlob, &errorBlob);
+        if (FAILED(hr))
+        {
+            if (errorBlob) { OutputDebugStringA((char*)errorBlob->GetBufferPointer()); errorBlob->Release(); }
+            return false;
+        }
+        m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &m_liquidGlassPS[shape]);
+        psBlob->Release();
     }
-    m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &m_liquidGlassPS);
-    psBlob->Release();
 
     // Compile Blur Shaders
     hr = D3DCompileFromFile(L"shaders/BlurVS.hlsl", nullptr, nullptr, "main", "vs_5_0",
@@ -406,12 +1225,6 @@ bool LiquidGlass::CreateShaders()
         return false;
     }
     m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &m_blurVS);
-
-    D3D11_INPUT_ELEMENT_DESC blurLayout[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-    };
-    m_device->CreateInputLayout(blurLayout, 2, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_blurInputLayout);
     vsBlob->Release();
 
     hr = D3DCompileFromFile(L"shaders/BlurPS.hlsl", nullptr, nullptr, "main", "ps_5_0",
@@ -440,12 +1253,12 @@ bool LiquidGlass::CreateShaders()
 
 bool LiquidGlass::CreateBuffers()
 {
-    // Create quad vertices
+    // Create quad vertices, SNORM 32767 is 1.0 exactly
     Vertex quadVertices[] = {
-        { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 1 },
-        { XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 1 },
-        { XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT2(1.0f, 0.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 1 },
-        { XMFLOAT3(-1.0f, 1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 1 }
+        { { -32767, -32767 }, { 0, 65535 } },
+        { { 32767, -32767 }, { 65535, 65535 } },
+        { { 32767, 32767 }, { 65535, 0 } },
+        { { -32767, 32767 }, { 0, 0 } }
     };
 
     D3D11_BUFFER_DESC vbDesc = {};
@@ -457,7 +1270,7 @@ bool LiquidGlass::CreateBuffers()
     vbData.pSysMem = quadVertices;
     m_device->CreateBuffer(&vbDesc, &vbData, &m_vertexBuffer);
 
-    UINT indices[] = { 0, 1, 2, 2, 3, 0 };
+    GlassIndex indices[] = { 0, 1, 2, 2, 3, 0 };
     D3D11_BUFFER_DESC ibDesc = {};
     ibDesc.Usage = D3D11_USAGE_DEFAULT;
     ibDesc.ByteWidth = sizeof(indices);
@@ -467,20 +1280,47 @@ bool LiquidGlass::CreateBuffers()
     ibData.pSysMem = indices;
     m_device->CreateBuffer(&ibDesc, &ibData, &m_indexBuffer);
 
+    // One immutable buffer per glass mode, every draw binds the one it shades at b3
+    D3D11_BUFFER_DESC modeDesc = {};
+    modeDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    modeDesc.ByteWidth = sizeof(GlassPassParams);
+    modeDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    for (int i = 0; i < GlassMode_COUNT; i++)
+    {
+        GlassPassParams params = {};
+        params.u_mode = (UINT)i;
+        D3D11_SUBRESOURCE_DATA modeData = {};
+        modeData.pSysMem = &params;
+        m_device->CreateBuffer(&modeDesc, &modeData, &m_modeBuffers[i]);
+    }
+
     // Constant buffers
     D3D11_BUFFER_DESC cbDesc = {};
     cbDesc.Usage = D3D11_USAGE_DYNAMIC;
     cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
     cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-    cbDesc.ByteWidth = sizeof(TransformBuffer);
-    m_device->CreateBuffer(&cbDesc, nullptr, &m_transformBuffer);
-
-    cbDesc.ByteWidth = sizeof(ShaderParams);
-    m_device->CreateBuffer(&cbDesc, nullptr, &m_shaderParamsBuffer);
-
     cbDesc.ByteWidth = sizeof(BlurParams);
     m_device->CreateBuffer(&cbDesc, nullptr, &m_blurParamsBuffer);
+    m_device->CreateBuffer(&cbDesc, nullptr, &m_blurVerticalParamsBuffer);
+
+    // The ring's constants for glass passes recorded on deferred contexts
+    cbDesc.ByteWidth = sizeof(TransformBuffer);
+    m_device->CreateBuffer(&cbDesc, nullptr, &m_deferredTransformBuffer);
+    cbDesc.ByteWidth = sizeof(ShaderParams);
+    m_device->CreateBuffer(&cbDesc, nullptr, &m_deferredShaderParamsBuffer);
+
+    // Liquid merge shapes, rewritten when the panels move
+    D3D11_BUFFER_DESC sbDesc = {};
+    sbDesc.Usage = D3D11_USAGE_DYNAMIC;
+    sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    sbDesc.ByteWidth = sizeof(MergeShape) * MaxMergeShapes;
+    sbDesc.StructureByteStride = sizeof(MergeShape);
+    if (FAILED(m_device->CreateBuffer(&sbDesc, nullptr, &m_mergeShapeBuffer)) ||
+        FAILED(m_device->CreateShaderResourceView(m_mergeShapeBuffer, nullptr, &m_mergeShapeSRV)))
+        return false;
 
     return true;
 }
@@ -514,33 +1354,231 @@ bool LiquidGlass::CreateRenderTargets(int width, int height)
     m_device->CreateRenderTargetView(m_blurFinalRT, nullptr, &m_blurFinalRTV);
     m_device->CreateShaderResourceView(m_blurFinalRT, nullptr, &m_blurFinalSRV);
 
+    m_device->CreateTexture2D(&texDesc, nullptr, &m_sceneBlurRT);
+    m_device->CreateRenderTargetView(m_sceneBlurRT, nullptr, &m_sceneBlurRTV);
+    m_device->CreateShaderResourceView(m_sceneBlurRT, nullptr, &m_sceneBlurSRV);
+
+    // Variable rate interior: float, its alpha holds the glow factor (above 1)
+    m_interiorWidth = (width + 1) / 2;
+    m_interiorHeight = (height + 1) / 2;
+    texDesc.Width = m_interiorWidth;
+    texDesc.Height = m_interiorHeight;
+    texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    m_device->CreateTexture2D(&texDesc, nullptr, &m_interiorRT);
+    m_device->CreateRenderTargetView(m_interiorRT, nullptr, &m_interiorRTV);
+    m_device->CreateShaderResourceView(m_interiorRT, nullptr, &m_interiorSRV);
+    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    // Main panel output history, full size
+    texDesc.Width = width;
+    texDesc.Height = height;
+    for (int i = 0; i < 2; i++)
+    {
+        m_device->CreateTexture2D(&texDesc, nullptr, &m_historyRT[i]);
+        m_device->CreateRenderTargetView(m_historyRT[i], nullptr, &m_historyRTV[i]);
+        m_device->CreateShaderResourceView(m_historyRT[i], nullptr, &m_historySRV[i]);
+    }
+
+    // Copy target for the back buffer, same size and format as the swap chain
+    texDesc.Width = width;
+    texDesc.Height = height;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    m_device->CreateTexture2D(&texDesc, nullptr, &m_sceneSnapshotRT);
+    m_device->CreateShaderResourceView(m_sceneSnapshotRT, nullptr, &m_sceneSnapshotSRV);
+
+    // Liquid merge tile bins: a range per tile, and room for every shape in every tile
+    UINT tiles = ((width + MergeTileSize - 1) / MergeTileSize) * ((height + MergeTileSize - 1) / MergeTileSize);
+    D3D11_BUFFER_DESC sbDesc = {};
+    sbDesc.Usage = D3D11_USAGE_DYNAMIC;
+    sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    sbDesc.ByteWidth = tiles * sizeof(UINT) * 2;
+    sbDesc.StructureByteStride = sizeof(UINT) * 2;
+    m_device->CreateBuffer(&sbDesc, nullptr, &m_mergeTileBuffer);
+    m_device->CreateShaderResourceView(m_mergeTileBuffer, nullptr, &m_mergeTileSRV);
+    sbDesc.ByteWidth = tiles * sizeof(UINT) * MaxMergeShapes;
+    sbDesc.StructureByteStride = sizeof(UINT);
+    m_device->CreateBuffer(&sbDesc, nullptr, &m_mergeTileShapeBuffer);
+    m_device->CreateShaderResourceView(m_mergeTileShapeBuffer, nullptr, &m_mergeTileShapeSRV);
+
     return true;
 }
 
-bool LiquidGlass::LoadTexture(const char* filename, ID3D11ShaderResourceView** textureView, int* width, int* height)
+bool LiquidGlass::CreateLookupTextures()
+{
+    // Glow angular LUT, wrapped at the seam between the last and first texel
+    float glow[GlowLUTSize];
+    BuildGlowLUT(glow, GlowLUTSize);
+
+    D3D11_TEXTURE1D_DESC lutDesc = {};
+    lutDesc.Width = GlowLUTSize;
+    lutDesc.MipLevels = 1;
+    lutDesc.ArraySize = 1;
+    lutDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    lutDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    lutDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = glow;
+    initData.SysMemPitch = sizeof(glow);
+
+    ID3D11Texture1D* lutTexture = nullptr;
+    if (FAILED(m_device->CreateTexture1D(&lutDesc, &initData, &lutTexture)))
+        return false;
+    HRESULT hr = m_device->CreateShaderResourceView(lutTexture, nullptr, &m_glowLUT);
+    lutTexture->Release();
+    if (FAILED(hr))
+        return false;
+
+    // Blue noise tile, read with Load() so no sampler is involved
+    unsigned char noise[BlueNoiseSize * BlueNoiseSize];
+    BuildBlueNoise(noise, BlueNoiseSize);
+
+    D3D11_TEXTURE2D_DESC noiseDesc = {};
+    noiseDesc.Width = BlueNoiseSize;
+    noiseDesc.Height = BlueNoiseSize;
+    noiseDesc.MipLevels = 1;
+    noiseDesc.ArraySize = 1;
+    noiseDesc.Format = DXGI_FORMAT_R8_UNORM;
+    noiseDesc.SampleDesc.Count = 1;
+    noiseDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    noiseDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    initData.pSysMem = noise;
+    initData.SysMemPitch = BlueNoiseSize;
+
+    ID3D11Texture2D* noiseTexture = nullptr;
+    if (FAILED(m_device->CreateTexture2D(&noiseDesc, &initData, &noiseTexture)))
+        return false;
+    hr = m_device->CreateShaderResourceView(noiseTexture, nullptr, &m_blueNoise);
+    noiseTexture->Release();
+    return SUCCEEDED(hr);
+}
+
+bool LiquidGlass::LoadTexture(const char* filename, BackgroundCacheFormat format, ID3D11ShaderResourceView** textureView,
+    int* width, int* height, size_t* memoryBytes)
 {
+    MappedFile source;
+    if (!source.Open(filename)) return false;
+
+    // A valid pre-baked cache in the requested format is uploaded straight out of its mapping
+    uint64_t sourceHash = HashBackgroundSource(source.Data(), source.Size());
+    std::string cachePath = GetBackgroundCachePath(filename);
+    BackgroundCacheFile cache;
+    if (cache.Open(cachePath.c_str(), sourceHash, source.Size()) && cache.Header().format == (uint32_t)format)
+    {
+        const BackgroundCacheHeader& header = cache.Header();
+        *width = (int)header.width;
+        *height = (int)header.height;
+        *memoryBytes = 0;
+        for (uint32_t i = 0; i < header.mipCount; i++)
+            *memoryBytes += header.mips[i].size;
+        return CreateTextureFromMips((BackgroundCacheFormat)header.format, header.width, header.height,
+            header.mipCount, header.mips, cache.Base(), textureView);
+    }
+    cache.Close();
+
+    // First launch, the source changed or another format was asked for: decode,
+    // build (and compress) the mips and bake the cache for next time
+    if (source.Size() > (size_t)INT_MAX) return false;
     int channels;
-    unsigned char* data = stbi_load(filename, width, height, &channels, 4);
+    unsigned char* data = stbi_load_from_memory(source.Data(), (int)source.Size(), width, height, &channels, 4);
     if (!data) return false;
 
+    BackgroundMipChain chain;
+    bool built = BuildBackgroundMipChain(data, *width, *height, format, &chain);
+    stbi_image_free(data);
+    if (!built) return false;
+    WriteBackgroundCache(cachePath.c_str(), chain, sourceHash, source.Size());
+
+    *width = chain.width;
+    *height = chain.height;
+    *memoryBytes = 0;
+    for (size_t i = 0; i < chain.mips.size(); i++)
+        *memoryBytes += chain.mips[i].size;
+    return CreateTextureFromMips(chain.format, chain.width, chain.height,
+        (UINT)chain.mips.size(), chain.mips.data(), chain.pixels.data(), textureView);
+}
+
+bool LiquidGlass::ReloadBackground(Background& bg, BackgroundCacheFormat format)
+{
+    ID3D11ShaderResourceView* texture = nullptr;
+    int width, height;
+    size_t memoryBytes;
+    if (!LoadTexture(bg.path.c_str(), format, &texture, &width, &height, &memoryBytes))
+        return false;
+
+    if (bg.texture) bg.texture->Release();
+    bg.texture = texture;
+    bg.width = width;
+    bg.height = height;
+    bg.format = format;
+    bg.memoryBytes = memoryBytes;
+    m_backgroundRevision++;
+    return true;
+}
+
+bool LiquidGlass::LoadAnimatedBackground(const char* filename, const char* name)
+{
+    AnimatedBackground* animation = new AnimatedBackground();
+    if (!animation->LoadGif(m_device, filename))
+    {
+        delete animation;
+        return false;
+    }
+
+    Background bg;
+    bg.name = name;
+    bg.credits = "";
+    bg.path = filename;
+    bg.texture = nullptr;
+    bg.width = animation->GetWidth();
+    bg.height = animation->GetHeight();
+    bg.format = BackgroundCacheFormat_RGBA8;
+    bg.memoryBytes = animation->GetMemoryBytes();
+    bg.animation = animation;
+    m_backgrounds.push_back(bg);
+    if (m_currentBackgroundId < 0)
+        m_currentBackgroundId = (int)m_backgrounds.size() - 1;
+    return true;
+}
+
+ID3D11ShaderResourceView* LiquidGlass::GetBackgroundTexture(const Background& bg)
+{
+    return bg.animation ? bg.animation->GetFrame() : bg.texture;
+}
+
+ID3D11ShaderResourceView* LiquidGlass::GetCurrentBackgroundTexture() const
+{
+    if (m_currentBackgroundId < 0 || m_currentBackgroundId >= (int)m_backgrounds.size())
+        return nullptr;
+    return GetBackgroundTexture(m_backgrounds[m_currentBackgroundId]);
+}
+
+bool LiquidGlass::CreateTextureFromMips(BackgroundCacheFormat format, UINT width, UINT height, UINT mipCount,
+    const BackgroundCacheMip* mips, const unsigned char* base, ID3D11ShaderResourceView** textureView)
+{
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = *width;
-    texDesc.Height = *height;
-    texDesc.MipLevels = 1;
+    texDesc.Width = width;
+    texDesc.Height = height;
+    texDesc.MipLevels = mipCount;
     texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.Format = format == BackgroundCacheFormat_BC1 ? DXGI_FORMAT_BC1_UNORM :
+                     format == BackgroundCacheFormat_BC7 ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
     texDesc.SampleDesc.Count = 1;
-    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.Usage = D3D11_USAGE_IMMUTABLE;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem = data;
-    initData.SysMemPitch = *width * 4;
+    D3D11_SUBRESOURCE_DATA initData[BackgroundCacheMaxMips] = {};
+    for (UINT i = 0; i < mipCount; i++)
+    {
+        initData[i].pSysMem = base + mips[i].offset;
+        initData[i].SysMemPitch = mips[i].rowPitch;
+    }
 
     ID3D11Texture2D* texture = nullptr;
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, &initData, &texture);
-    stbi_image_free(data);
-
+    HRESULT hr = m_device->CreateTexture2D(&texDesc, initData, &texture);
     if (FAILED(hr)) return false;
 
     hr = m_device->CreateShaderResourceView(texture, nullptr, textureView);
@@ -549,156 +1587,771 @@ bool LiquidGlass::LoadTexture(const char* filename, ID3D11ShaderResourceView** t
     return SUCCEEDED(hr);
 }
 
+BlurCacheKey LiquidGlass::GetBlurCacheKey() const
+{
+    BlurCacheKey key;
+    key.backgroundId = m_currentBackgroundId;
+    key.backgroundRevision = m_backgroundRevision;
+    if (m_currentBackgroundId >= 0 && m_currentBackgroundId < (int)m_backgrounds.size() && m_backgrounds[m_currentBackgroundId].animation)
+        key.backgroundRevision += m_backgrounds[m_currentBackgroundId].animation->GetRevision();
+    key.iterations = m_blurIterations;
+    key.radius = m_blurParams.u_radius;
+    key.downscale = m_blurDownscaleFactor;
+    key.width = m_screenWidth;
+    key.height = m_screenHeight;
+    return key;
+}
+
+// Distance from the edge past which the main panel's output only depends on the screen pixel:
+// flat surface, no glow or dispersion, and the refracted sample within m_historyTolerance
+// pixels of the pixel itself, so a reused pixel is off by at most twice that. 0 when some term
+// never settles, a glow rising inwards or a refraction that does not converge to 1.
+float LiquidGlass::GetHistoryStart(XMFLOAT2 quadScale) const
+{
+    const ShaderParams& p = m_shaderParams;
+    float start = p.u_bevel;
+    if (p.u_dispersion > 0.0f)
+        start = max(start, p.u_dispersionBand);
+    if (p.u_glowWeight != 0.0f)
+    {
+        if (p.u_glowEdge0 <= p.u_glowEdge1)
+            return 0.0f;
+        start = max(start, p.u_glowEdge0);
+    }
+
+    // The sample is p * refraction^fPower, off by (1 - scale) * |p|. A point dist inside an
+    // exact shape is at most the half diagonal minus dist from the center (in shorter half
+    // sides); the superellipse's distance is only an estimate, take the whole half diagonal.
+    float halfX = quadScale.x * m_screenWidth * 0.5f;
+    float halfY = quadScale.y * m_screenHeight * 0.5f;
+    float pixelScale = max(min(halfX, halfY), 0.0001f);
+    float diagonal = sqrtf(halfX * halfX + halfY * halfY) / pixelScale;
+    const float maxDistance = 8.0f;
+    const int steps = 1024;
+    float settled = 0.0f;
+    for (int i = 0; i <= steps; i++)
+    {
+        float dist = maxDistance * i / steps;
+        float radius = m_shape == GlassShape_Superellipse ? diagonal : max(diagonal - dist, 0.0f);
+        float refraction = 1.0f - p.u_b * powf(p.u_c * 2.718281828f, -p.u_d * dist - p.u_a);
+        float scale = refraction > 0.0f ? powf(refraction, p.u_fPower) : 0.0f;
+        if (fabsf(1.0f - scale) * radius * pixelScale > m_historyTolerance)
+            settled = dist + maxDistance / steps;
+    }
+    if (settled > maxDistance)
+        return 0.0f;
+    return max(max(start, settled), 0.0001f);
+}
+
+// Largest factor the refraction scales p by anywhere up to maxDistance inside the edge, the
+// dispersed channels included, sampled like GetHistoryStart(). Glass then samples no farther
+// than that many half extents from its center, give or take the evaluation's error. Infinite
+// or NaN when the refraction blows up.
+float LiquidGlass::GetRefractionReach(float maxDistance)
+{
+    const ShaderParams& p = m_shaderParams;
+    float key[7] = { p.u_a, p.u_b, p.u_c, p.u_d, p.u_fPower, p.u_dispersion, ceilf(maxDistance) };
+    if (memcmp(key, m_reachKey, sizeof(key)) == 0)
+        return m_reach + GetRefractionError() * max(m_reach, 1.0f);
+    memcpy(m_reachKey, key, sizeof(key));
+
+    // DISPERSION_WAVELENGTH in the shader, the band's strongest dispersion
+    float powers[3] = { p.u_fPower, p.u_fPower, p.u_fPower };
+    if (p.u_dispersion > 0.0f)
+    {
+        powers[1] *= 1.0f + p.u_dispersion * (550.0f * 550.0f / (650.0f * 650.0f) - 1.0f);
+        powers[2] *= 1.0f + p.u_dispersion * (550.0f * 550.0f / (450.0f * 450.0f) - 1.0f);
+    }
+    const int steps = 1024;
+    float reach = 0.0f;
+    for (int i = 0; i <= steps; i++)
+    {
+        float dist = key[6] * i / steps;
+        float refraction = 1.0f - p.u_b * powf(p.u_c * 2.718281828f, -p.u_d * dist - p.u_a);
+        for (int c = 0; c < 3; c++)
+        {
+            float scale = refraction > 0.0f ? powf(refraction, powers[c]) : 0.0f;
+            reach = scale > reach || scale != scale ? scale : reach;
+        }
+    }
+    m_reach = reach;
+    return reach + GetRefractionError() * max(reach, 1.0f);
+}
+
+// NDC bounds (min x, min y, max x, max y) of what the main panel, or the merged panels, can
+// sample from the background blur. False when that is unbounded.
+bool LiquidGlass::GetPanelSampleBounds(float bounds[4])
+{
+    float box[4];
+    float pixelScale;
+    if (m_liquidMerge)
+    {
+        // The merged shape's center lies between the panels' and its pixels inside their
+        // bounds grown by the blend radius, a sample is off the pixel by (scale - 1) times
+        // their distance
+        bounds[0] = bounds[1] = 1.0f;
+        bounds[2] = bounds[3] = -1.0f;
+        if (m_mergeShapeCount == 0)
+            return true;
+        box[0] = box[1] = FLT_MAX;
+        box[2] = box[3] = -FLT_MAX;
+        pixelScale = FLT_MAX;
+        for (int i = 0; i < m_mergeShapeCount; i++)
+        {
+            const MergeShape& shape = m_mergeShapes[i];
+            box[0] = min(box[0], shape.midPoint[0] - shape.quadScale[0]);
+            box[1] = min(box[1], shape.midPoint[1] - shape.quadScale[1]);
+            box[2] = max(box[2], shape.midPoint[0] + shape.quadScale[0]);
+            box[3] = max(box[3], shape.midPoint[1] + shape.quadScale[1]);
+            pixelScale = min(pixelScale, shape.pixelScale);
+        }
+        float growX = 2.0f * m_mergeRadius / m_screenWidth;
+        float growY = 2.0f * m_mergeRadius / m_screenHeight;
+        box[0] -= growX;
+        box[1] -= growY;
+        box[2] += growX;
+        box[3] += growY;
+    }
+    else
+    {
+        XMMATRIX viewProjection = m_camera.GetViewProjection();
+        XMVECTOR mid = XMVector3TransformCoord(XMVectorSet(m_position.x, m_position.y, m_position.z, 1.0f), viewProjection);
+        XMVECTOR corner = XMVector3TransformCoord(XMVectorSet(m_position.x + m_width, m_position.y + m_height, m_position.z, 1.0f), viewProjection);
+        float midX = XMVectorGetX(mid), midY = XMVectorGetY(mid);
+        float quadX = fabsf(XMVectorGetX(corner) - midX), quadY = fabsf(XMVectorGetY(corner) - midY);
+        box[0] = midX - quadX;
+        box[1] = midY - quadY;
+        box[2] = midX + quadX;
+        box[3] = midY + quadY;
+        pixelScale = min(quadX * m_screenWidth, quadY * m_screenHeight) * 0.5f;
+    }
+
+    // No point inside is farther from the edge than the half diagonal
+    float halfX = (box[2] - box[0]) * 0.25f * m_screenWidth;
+    float halfY = (box[3] - box[1]) * 0.25f * m_screenHeight;
+    float reach = GetRefractionReach(sqrtf(halfX * halfX + halfY * halfY) / max(pixelScale, 0.0001f));
+    if (!(reach < 1e4f))
+        return false;
+    if (m_liquidMerge)
+    {
+        float grow = max(reach - 1.0f, 0.0f);
+        float growX = grow * (box[2] - box[0]);
+        float growY = grow * (box[3] - box[1]);
+        bounds[0] = box[0] - growX;
+        bounds[1] = box[1] - growY;
+        bounds[2] = box[2] + growX;
+        bounds[3] = box[3] + growY;
+    }
+    else
+    {
+        float midX = (box[0] + box[2]) * 0.5f, midY = (box[1] + box[3]) * 0.5f;
+        float quadX = (box[2] - box[0]) * 0.5f * reach, quadY = (box[3] - box[1]) * 0.5f * reach;
+        bounds[0] = midX - quadX;
+        bounds[1] = midY - quadY;
+        bounds[2] = midX + quadX;
+        bounds[3] = midY + quadY;
+    }
+    return true;
+}
+
+// Blur target texels [left, right) x [top, bottom) glass sampling bounds (NDC, see
+// GetPanelSampleBounds()) can read, the whole target for null bounds or with the region of
+// interest off. Every pass reads a kernel radius past the texels it writes and the stale
+// texels outside the region creep in by that much, so it grows by one radius per iteration.
+// topDown for the scene snapshot, the background blur is stored bottom-up.
+void LiquidGlass::GetBlurRegion(const float* bounds, bool topDown, int region[4]) const
+{
+    int width = (int)(m_screenWidth * m_blurDownscaleFactor);
+    int height = (int)(m_screenHeight * m_blurDownscaleFactor);
+    region[0] = 0;
+    region[1] = 0;
+    region[2] = width;
+    region[3] = height;
+    if (!m_blurRegionOfInterest || !bounds)
+        return;
+    for (int i = 0; i < 4; i++)
+    {
+        if (!(fabsf(bounds[i]) < 1e4f))
+            return;
+    }
+
+    // BlurPS's farthest tap is 5.18 radii out
+    int margin = m_blurIterations * ((int)ceilf(5.1764706f * fabsf(m_blurParams.u_radius)) + 1) + 1;
+    float top = topDown ? 0.5f - bounds[3] * 0.5f : bounds[1] * 0.5f + 0.5f;
+    float bottom = topDown ? 0.5f - bounds[1] * 0.5f : bounds[3] * 0.5f + 0.5f;
+    region[0] = max((int)floorf((bounds[0] * 0.5f + 0.5f) * width) - margin, 0);
+    region[1] = max((int)floorf(top * height) - margin, 0);
+    region[2] = min((int)ceilf((bounds[2] * 0.5f + 0.5f) * width) + margin, width);
+    region[3] = min((int)ceilf(bottom * height) + margin, height);
+    if (bounds[2] < bounds[0] || bounds[3] < bounds[1] || region[2] <= region[0] || region[3] <= region[1])
+        memset(region, 0, sizeof(int) * 4);
+}
+
+// Temporal reuse: the last frame's output may stand in for the interior while nothing but
+// the panel's position changed since. Also estimates how much of the panel that covers, on a
+// grid over the quad like the dispersion stats.
+void LiquidGlass::UpdateGlassHistory()
+{
+    XMMATRIX viewProjection = m_camera.GetViewProjection();
+    XMVECTOR mid = XMVector3TransformCoord(XMVectorSet(m_position.x, m_position.y, m_position.z, 1.0f), viewProjection);
+    XMVECTOR corner = XMVector3TransformCoord(XMVectorSet(m_position.x + m_width, m_position.y + m_height, m_position.z, 1.0f), viewProjection);
+    m_midPoint = XMFLOAT2(XMVectorGetX(mid), XMVectorGetY(mid));
+
+    GlassHistoryKey key;
+    memset(&key, 0, sizeof(key));
+    key.blur = GetBlurCacheKey();
+    key.shader = m_shaderParams;
+    key.quadScale = XMFLOAT2(fabsf(XMVectorGetX(corner) - m_midPoint.x), fabsf(XMVectorGetY(corner) - m_midPoint.y));
+    key.objectSize = XMFLOAT2(m_width, m_height);
+    key.shape = m_shape;
+    key.cornerRadii = m_cornerRadii;
+
+    bool valid = m_temporalReuse && !m_liquidMerge && m_historyWritten && key == m_historyKey &&
+        m_historyTolerance == m_historyKeyTolerance;
+    if (!valid)
+    {
+        // The history holds the old key's output until the glass pass rewrites it, this runs
+        // again before that (the glass windows update the constants first) and must not match
+        if (m_historyWritten)
+            m_historyInvalidations++;
+        m_historyWritten = false;
+        m_historyKey = key;
+        m_historyKeyTolerance = m_historyTolerance;
+        m_historyStart = GetHistoryStart(key.quadScale);
+    }
+    m_historyReuseStart = valid ? m_historyStart : 0.0f;
+    m_historyReuseRatio = 0.0f;
+    if (m_historyReuseStart <= 0.0f || key.quadScale.x <= 0.0f || key.quadScale.y <= 0.0f)
+        return;
+
+    // p of this frame's panel to last frame's, as the shader does it (p.y down)
+    float shiftX = (m_midPoint.x - m_historyMidPoint.x) / key.quadScale.x;
+    float shiftY = -(m_midPoint.y - m_historyMidPoint.y) / key.quadScale.y;
+    float n = m_shaderParams.u_powerFactor;
+    const int gridSize = 64;
+    int inside = 0, reused = 0;
+    for (int y = 0; y < gridSize; y++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            float px = (x + 0.5f) / gridSize * 2.0f - 1.0f;
+            float py = (y + 0.5f) / gridSize * 2.0f - 1.0f;
+            float d = GlassShapeSdf(m_shape, px, py, m_width, m_height, &m_cornerRadii.x, n, nullptr, nullptr);
+            if (d > 0.0f)
+                continue;
+            inside++;
+            if (-d < m_historyReuseStart)
+                continue;
+            float historyD = GlassShapeSdf(m_shape, px + shiftX, py + shiftY, m_width, m_height, &m_cornerRadii.x, n, nullptr, nullptr);
+            if (-historyD >= m_historyReuseStart)
+                reused++;
+        }
+    }
+    m_historyReuseRatio = inside ? (float)reused / inside : 0.0f;
+}
+
+// Allocates into the ring's open batch, written by its next Flush()
 void LiquidGlass::UpdateConstantBuffers()
 {
-    D3D11_MAPPED_SUBRESOURCE mapped;
+    // The variable rate fields follow the settings (a preset may carry stale ones); two
+    // interior texels of margin cover the bilinear upsample and the texel centers
+    bool variableRate = m_shadingRate > 1 && !m_liquidMerge;
+    m_shaderParams.u_interiorBand = variableRate ? max(m_interiorBand, 0.0001f) : 0.0f;
+    m_shaderParams.u_interiorMargin = variableRate ? 2.0f * m_shadingRate : 0.0f;
+    UpdateRefractionFit();
+    UpdateGlassHistory();
+
+    // Transform, only when the camera or the object moved or the ring started over
+    TransformBuffer transform;
+    memset(&transform, 0, sizeof(transform));
+    transform.ViewProjection = XMMatrixTranspose(m_camera.GetViewProjection());
+    transform.ObjectPosition = m_position;
+    transform.ObjectSize = XMFLOAT2(m_width, m_height);
+    transform.ScreenSize = XMFLOAT2((float)m_screenWidth, (float)m_screenHeight);
+    transform.ShapeRadii = m_cornerRadii;
+    transform.InteriorScale = XMFLOAT2(1.0f / (m_shadingRate * m_interiorWidth), 1.0f / (m_shadingRate * m_interiorHeight));
+    transform.HistoryMidPoint = m_historyMidPoint;
+    transform.HistoryStart = m_historyReuseStart;
+    if (m_constantRing.IsCurrent(m_transformRange) && memcmp(&transform, &m_transformData, sizeof(TransformBuffer)) == 0)
+    {
+        m_transformSkips++;
+    }
+    else
+    {
+        m_constantRing.Allocate(&transform, sizeof(TransformBuffer), m_transformRange);
+        m_transformData = transform;
+        m_transformUploads++;
+    }
 
-    // Transform buffer
-    m_context->Map(m_transformBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    TransformBuffer* transformData = (TransformBuffer*)mapped.pData;
+    // Shader params, only when a slider or the timeline actually changed something
+    if (m_constantRing.IsCurrent(m_shaderParamsRange) && memcmp(&m_uploadedShaderParams, &m_shaderParams, sizeof(ShaderParams)) == 0)
+    {
+        m_shaderParamsSkips++;
+        return;
+    }
+    m_constantRing.Allocate(&m_shaderParams, sizeof(ShaderParams), m_shaderParamsRange);
+    m_uploadedShaderParams = m_shaderParams;
+    m_shaderParamsUploads++;
+}
 
-    float orthoSize = 15.0f;
-    float aspect = (float)m_screenHeight / (float)m_screenWidth;
-    XMMATRIX projection = XMMatrixOrthographicLH(orthoSize, orthoSize * aspect, -10.0f, 10.0f);
-    XMMATRIX view = XMMatrixTranslation(-m_cameraPosition.x, -m_cameraPosition.y, -m_cameraPosition.z);
+// Refits the refraction when a slider or the timeline changed it and folds the fit into the
+// shader params, which only upload when that changed them
+void LiquidGlass::UpdateRefractionFit()
+{
+    ShaderParams& p = m_shaderParams;
+    float key[5] = { p.u_a, p.u_b, p.u_c, p.u_d, p.u_fPower };
+    if (memcmp(key, m_refractionKey, sizeof(key)) != 0)
+    {
+        memcpy(m_refractionKey, key, sizeof(key));
+        FitRefraction(p.u_a, p.u_b, p.u_c, p.u_d, p.u_fPower, m_refractionFit);
+    }
+    const RefractionFit& fit = m_refractionFit;
+    GlassRefractionMode mode = m_refractionMode == GlassRefraction_Cubic && !fit.cubicValid ? GlassRefraction_Folded : m_refractionMode;
+    p.u_refractionMode = (float)mode;
+    p.u_refractionCubic = XMFLOAT4(fit.cubic[0], fit.cubic[1], fit.cubic[2], fit.cubic[3]);
+    p.u_refractionSlope = fit.slope;
+    p.u_refractionWeight = fit.weight;
+}
+
+float LiquidGlass::GetRefractionError() const
+{
+    switch ((int)m_shaderParams.u_refractionMode)
+    {
+    case GlassRefraction_Folded: return m_refractionFit.foldedError;
+    case GlassRefraction_Cubic: return m_refractionFit.cubicError;
+    default: return 0.0f;
+    }
+}
 
-    transformData->ViewProjection = XMMatrixTranspose(projection * view);
-    transformData->ObjectPosition = m_position;
-    transformData->ObjectSize = XMFLOAT2(m_width, m_height);
-    transformData->ScreenSize = XMFLOAT2((float)m_screenWidth, (float)m_screenHeight);
-    m_context->Unmap(m_transformBuffer, 0);
+// Samples the same SDF as the shader over the quad, only when its inputs change
+void LiquidGlass::UpdateDispersionStats()
+{
+    float n = m_shaderParams.u_powerFactor;
+    float band = m_shaderParams.u_dispersionBand;
+    float key[8] = { n, band, (float)m_shape, m_width / max(m_height, 0.0001f), m_cornerRadii.x, m_cornerRadii.y, m_cornerRadii.z, m_cornerRadii.w };
+    if (memcmp(key, m_dispersionStatsKey, sizeof(key)) == 0)
+        return;
+    memcpy(m_dispersionStatsKey, key, sizeof(key));
 
-    // Shader params
-    m_context->Map(m_shaderParamsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    memcpy(mapped.pData, &m_shaderParams, sizeof(ShaderParams));
-    m_context->Unmap(m_shaderParamsBuffer, 0);
+    const int gridSize = 64;
+    int inside = 0, inBand = 0;
+    for (int y = 0; y < gridSize; y++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            float px = (x + 0.5f) / gridSize * 2.0f - 1.0f;
+            float py = (y + 0.5f) / gridSize * 2.0f - 1.0f;
+            float d = GlassShapeSdf(m_shape, px, py, m_width, m_height, &m_cornerRadii.x, n, nullptr, nullptr);
+            if (d > 0.0f)
+                continue;
+            inside++;
+            if (-d < band)
+                inBand++;
+        }
+    }
+    m_dispersionInsideFraction = (float)inside / (gridSize * gridSize);
+    m_dispersionBandFraction = inside ? (float)inBand / inside : 0.0f;
 }
 
-void LiquidGlass::RenderBackground()
+// Variable rate cost model, sampled like the dispersion stats: the edge band at full rate,
+// plus the interior pass (interior and margin) at 1/rate^2, against all of it at full rate.
+// The upsampled pixels still run the glass pass's cheap path, one fetch and the noise.
+void LiquidGlass::UpdateShadingRateStats()
 {
-    // Set render target
-    m_context->OMSetRenderTargets(1, &m_backgroundRTV, nullptr);
-    
+    float n = m_shaderParams.u_powerFactor;
+    float pixelScale = min(m_width, m_height) * m_camera.GetPixelsPerUnit();  // Shorter half side
+    float key[11] = { n, m_interiorBand, (float)m_shadingRate, pixelScale, (float)m_shape, m_width / max(m_height, 0.0001f),
+        m_cornerRadii.x, m_cornerRadii.y, m_cornerRadii.z, m_cornerRadii.w, (float)m_liquidMerge };
+    if (memcmp(key, m_shadingRateStatsKey, sizeof(key)) == 0)
+        return;
+    memcpy(m_shadingRateStatsKey, key, sizeof(key));
+
+    // Same thresholds as InteriorStart() in the shader
+    float margin = 2.0f * m_shadingRate / max(pixelScale, 1.0f);
+    float interiorStart = max(max(m_interiorBand, 0.0001f), margin);
+    const int gridSize = 64;
+    int inside = 0, edge = 0, lowRate = 0;
+    for (int y = 0; y < gridSize; y++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            float px = (x + 0.5f) / gridSize * 2.0f - 1.0f;
+            float py = (y + 0.5f) / gridSize * 2.0f - 1.0f;
+            float dist = -GlassShapeSdf(m_shape, px, py, m_width, m_height, &m_cornerRadii.x, n, nullptr, nullptr);
+            if (dist >= interiorStart - margin)
+                lowRate++;
+            if (dist < 0.0f)
+                continue;
+            inside++;
+            if (dist < interiorStart)
+                edge++;
+        }
+    }
+    if (m_shadingRate <= 1 || m_liquidMerge || inside == 0)
+    {
+        m_shadingRateInterior = 0.0f;
+        m_shadingRateSaved = 0.0f;
+        return;
+    }
+    m_shadingRateInterior = (float)(inside - edge) / inside;
+    m_shadingRateSaved = 1.0f - (edge + (float)lowRate / (m_shadingRate * m_shadingRate)) / inside;
+}
+
+void LiquidGlass::RecordBackground(GlassCommandList& list)
+{
+    list.BeginScope("Background");
+    list.SetTargets(m_backgroundRTV);
+
     // Clear background
     float clearColor[4] = { 0.2f, 0.2f, 0.3f, 1.0f };  // Dark blue fallback
-    m_context->ClearRenderTargetView(m_backgroundRTV, clearColor);
+    list.ClearTarget(m_backgroundRTV, clearColor);
+    list.SetViewport((float)m_screenWidth, (float)m_screenHeight);
 
-    D3D11_VIEWPORT viewport = {};
-    viewport.Width = (float)m_screenWidth;
-    viewport.Height = (float)m_screenHeight;
-    viewport.MaxDepth = 1.0f;
-    m_context->RSSetViewports(1, &viewport);
-    
     // If we have a background texture, render it
-    if (m_currentBackgroundId >= 0 && m_currentBackgroundId < (int)m_backgrounds.size())
+    ID3D11ShaderResourceView* texture = GetCurrentBackgroundTexture();
+    if (texture)
     {
-        Background& bg = m_backgrounds[m_currentBackgroundId];
-        
-        // Use simple texture shader to draw fullscreen textured quad
-        m_context->IASetInputLayout(m_blurInputLayout);
-        m_context->VSSetShader(m_blurVS, nullptr, 0);
-        m_context->PSSetShader(m_simpleTexturePS, nullptr, 0);  // Use simple texture shader
-        m_context->PSSetShaderResources(0, 1, &bg.texture);
-        m_context->PSSetSamplers(0, 1, &m_linearSampler);
-        
-        // Draw using main vertex buffer (it's a quad)
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-        m_context->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-        m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        
-        m_context->DrawIndexed(6, 0, 0);
-        
+        // Use simple texture shader to draw a fullscreen textured triangle
+        GlassPipeline pipeline = { nullptr, m_blurVS, m_simpleTexturePS, nullptr, m_depthStencilState, m_rasterizerState };
+        list.SetPipeline(pipeline);
+        list.BindTexture(0, texture);
+        list.BindSampler(0, m_linearSampler);
+
+        // Fullscreen triangle, no vertex buffer
+        list.SetGeometry(nullptr, 0, nullptr);
+        list.Draw(3);
+
         // Unbind
-        ID3D11ShaderResourceView* nullSRV = nullptr;
-        m_context->PSSetShaderResources(0, 1, &nullSRV);
+        list.BindTexture(0, nullptr);
     }
+    list.EndScope();
 }
 
-void LiquidGlass::ApplyBlur()
+// Blurs source into the target texels region (see GetBlurRegion()), the passes clipped to it.
+// Every pass flips the image vertically, the horizontal ones write the region mirrored.
+void LiquidGlass::RecordBlur(GlassCommandList& list, ID3D11ShaderResourceView* source, ID3D11RenderTargetView* targetRTV, ID3D11ShaderResourceView* targetSRV,
+    const int region[4])
 {
     if (m_blurIterations == 0) return;
 
-    m_context->IASetInputLayout(m_blurInputLayout);
-    m_context->VSSetShader(m_blurVS, nullptr, 0);
-    m_context->PSSetShader(m_blurPS, nullptr, 0);
-    m_context->PSSetSamplers(0, 1, &m_linearSampler);
+    GlassPipeline pipeline = { nullptr, m_blurVS, m_blurPS, nullptr, m_depthStencilState, m_scissorRasterizerState };
+    float width = m_screenWidth * m_blurDownscaleFactor;
+    float height = m_screenHeight * m_blurDownscaleFactor;
+    int targetHeight = (int)height;
 
-    D3D11_VIEWPORT viewport = {};
-    viewport.Width = m_screenWidth * m_blurDownscaleFactor;
-    viewport.Height = m_screenHeight * m_blurDownscaleFactor;
-    viewport.MaxDepth = 1.0f;
-    m_context->RSSetViewports(1, &viewport);
+    // Every pass binds and writes all of its state and may be replayed apart, on a deferred
+    // context that must map the buffers it reads itself. The replay skips the repeats.
+    auto beginPass = [&](const char* name, bool mirrored)
+    {
+        list.BeginScope(name);
+        list.SetPipeline(pipeline);
+        list.BindSampler(0, m_linearSampler);
+        list.SetViewport(width, height);
+        if (mirrored)
+            list.SetScissor(region[0], targetHeight - region[3], region[2], targetHeight - region[1]);
+        else
+            list.SetScissor(region[0], region[1], region[2], region[3]);
+        list.SetGeometry(nullptr, 0, nullptr);
+    };
 
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_context->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    BlurParams horizontal = {};
+    horizontal.u_direction = XMFLOAT2(1.0f, 0.0f);
+    horizontal.u_resolution = XMFLOAT2(width, height);
+    horizontal.u_radius = m_blurParams.u_radius;
+    BlurParams vertical = horizontal;
+    vertical.u_direction = XMFLOAT2(0.0f, 1.0f);
 
     for (int i = 0; i < m_blurIterations; i++)
     {
-        ID3D11ShaderResourceView* inputSRV = (i == 0) ? m_backgroundSRV : m_blurFinalSRV;
+        ID3D11ShaderResourceView* inputSRV = (i == 0) ? source : targetSRV;
+        char scopeName[32];
 
         // Horizontal
-        D3D11_MAPPED_SUBRESOURCE mapped;
-        m_context->Map(m_blurParamsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-        BlurParams* blur = (BlurParams*)mapped.pData;
-        blur->u_direction = XMFLOAT2(1.0f, 0.0f);
-        blur->u_resolution = XMFLOAT2(viewport.Width, viewport.Height);
-        blur->u_radius = m_blurParams.u_radius;
-        m_context->Unmap(m_blurParamsBuffer, 0);
-        m_context->PSSetConstantBuffers(0, 1, &m_blurParamsBuffer);
-
-        m_context->OMSetRenderTargets(1, &m_blurIntermediateRTV, nullptr);
-        m_context->PSSetShaderResources(0, 1, &inputSRV);
-        m_context->DrawIndexed(6, 0, 0);
+        snprintf(scopeName, sizeof(scopeName), "Blur %d H", i);
+        beginPass(scopeName, true);
+        list.UpdateConstants(m_blurParamsBuffer, &horizontal, sizeof(horizontal));
+        list.BindConstants(GlassStage_Pixel, 0, m_blurParamsBuffer);
+        list.SetTargets(m_blurIntermediateRTV);
+        list.BindTexture(0, inputSRV);
+        list.Draw(3);
+        list.EndScope();
 
         // Vertical
-        m_context->Map(m_blurParamsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-        blur = (BlurParams*)mapped.pData;
-        blur->u_direction = XMFLOAT2(0.0f, 1.0f);
-        blur->u_resolution = XMFLOAT2(viewport.Width, viewport.Height);
-        blur->u_radius = m_blurParams.u_radius;
-        m_context->Unmap(m_blurParamsBuffer, 0);
+        snprintf(scopeName, sizeof(scopeName), "Blur %d V", i);
+        beginPass(scopeName, false);
+        list.UpdateConstants(m_blurVerticalParamsBuffer, &vertical, sizeof(vertical));
+        list.BindConstants(GlassStage_Pixel, 0, m_blurVerticalParamsBuffer);
+        list.SetTargets(targetRTV);
+        list.BindTexture(0, m_blurIntermediateSRV);
+        list.Draw(3);
+        list.EndScope();
+    }
+
+    list.BindTexture(0, nullptr);
+}
+
+// The main panel: its interior at the variable rate, then the glass itself into the main
+// target and the history slot historyIndex, reading the other slot back
+void LiquidGlass::RecordLiquidGlass(GlassCommandList& list, ID3D11RenderTargetView* mainRenderTarget, int historyIndex)
+{
+    GlassPipeline pipeline = { m_inputLayout, m_liquidGlassVS, m_liquidGlassPS[m_shape], nullptr, m_depthStencilState, m_rasterizerState };
+
+    // The transform and shader params, ranges of the ring mapped on the immediate context. For
+    // the recording threads every pass writes this frame's copy into buffers of its own instead,
+    // read when replayed: a deferred context only reads the dynamic buffers it mapped itself.
+    bool deferred = m_recordThreads > 0;
+    auto bindConstants = [&]()
+    {
+        if (deferred)
+        {
+            list.UpdateConstantsFrom(m_deferredTransformBuffer, &m_transformData, sizeof(TransformBuffer));
+            list.UpdateConstantsFrom(m_deferredShaderParamsBuffer, &m_uploadedShaderParams, sizeof(ShaderParams));
+            list.BindConstants(GlassStage_Vertex, 0, m_deferredTransformBuffer);
+            list.BindConstants(GlassStage_Pixel, 0, m_deferredShaderParamsBuffer);
+            list.BindConstants(GlassStage_Pixel, 1, m_deferredTransformBuffer);
+        }
+        else
+        {
+            list.BindConstantRange(GlassStage_Vertex, 0, &m_transformRange);
+            list.BindConstantRange(GlassStage_Pixel, 0, &m_shaderParamsRange);
+            list.BindConstantRange(GlassStage_Pixel, 1, &m_transformRange);
+        }
+    };
+
+    // Variable rate: the interior at 1/m_shadingRate per axis, read back by the glass pass.
+    // Every texel the upsample reads is shaded here, so the target is not cleared.
+    if (m_shadingRate > 1)
+    {
+        list.BeginScope("Glass Interior");
+        list.SetTargets(m_interiorRTV);
+        list.SetViewport((float)m_screenWidth / m_shadingRate, (float)m_screenHeight / m_shadingRate);
+        list.SetPipeline(pipeline);
+        bindConstants();
+        list.BindConstants(GlassStage_Pixel, 3, m_modeBuffers[GlassMode_Interior]);
+        list.BindTexture(0, m_backgroundSRV);
+        list.BindTexture(1, m_blurFinalSRV);
+        list.BindTexture(2, m_glowLUT);
+        list.BindTexture(3, m_blueNoise);
+        list.BindSampler(0, m_linearSampler);
+        list.BindSampler(1, m_wrapSampler);
+        list.SetGeometry(m_vertexBuffer, sizeof(Vertex), m_indexBuffer);
+        list.DrawIndexed(6);
+        list.EndScope();
+    }
+
+    // Blend for transparent rendering
+    list.BeginScope("Glass");
+    list.SetTargets(mainRenderTarget, m_historyRTV[historyIndex]);
+    list.SetViewport((float)m_screenWidth, (float)m_screenHeight);
+    pipeline.blendState = m_blendState;
+    list.SetPipeline(pipeline);
+    bindConstants();
+    list.BindConstants(GlassStage_Pixel, 3, m_modeBuffers[GlassMode_Glass]);
+    list.BindTexture(0, m_backgroundSRV);
+    list.BindTexture(1, m_blurFinalSRV);
+    list.BindTexture(2, m_glowLUT);
+    list.BindTexture(3, m_blueNoise);
+    list.BindTexture(7, m_interiorSRV);
+    list.BindTexture(8, m_historySRV[1 - historyIndex]);
+    list.BindSampler(0, m_linearSampler);
+    list.BindSampler(1, m_wrapSampler);
+    list.SetGeometry(m_vertexBuffer, sizeof(Vertex), m_indexBuffer);
+    list.DrawIndexed(6);
+
+    list.BindTexture(0, nullptr);
+    list.BindTexture(1, nullptr);
+    list.BindTexture(7, nullptr);
+    list.BindTexture(8, nullptr);
+    list.SetTargets(mainRenderTarget);
+    list.EndScope();
+}
 
-        m_context->OMSetRenderTargets(1, &m_blurFinalRTV, nullptr);
-        m_context->PSSetShaderResources(0, 1, &m_blurIntermediateSRV);
-        m_context->DrawIndexed(6, 0, 0);
+// Re-records the background and blur lists whose key no longer holds, the blurs clipped to
+// m_blurRegion and m_sceneBlurRegion
+void LiquidGlass::UpdateBlurLists()
+{
+    PassListKey key;
+    memset(&key, 0, sizeof(key));
+    key.targetRevision = m_renderTargetRevision;
+    key.resource = GetCurrentBackgroundTexture();
+    if (!(key == m_backgroundListKey))
+    {
+        m_backgroundCommands.Clear();
+        RecordBackground(m_backgroundCommands);
+        m_backgroundListKey = key;
+        m_passListRecords++;
     }
 
-    ID3D11ShaderResourceView* nullSRV = nullptr;
-    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    key.resource = nullptr;
+    key.iterations = m_blurIterations;
+    key.radius = m_blurParams.u_radius;
+    key.downscale = m_blurDownscaleFactor;
+    memcpy(key.region, m_blurRegion, sizeof(key.region));
+    if (!(key == m_blurListKey))
+    {
+        m_blurCommands.Clear();
+        RecordBlur(m_blurCommands, m_backgroundSRV, m_blurFinalRTV, m_blurFinalSRV, m_blurRegion);
+        m_blurListKey = key;
+        m_passListRecords++;
+    }
+
+    memcpy(key.region, m_sceneBlurRegion, sizeof(key.region));
+    if (!(key == m_sceneBlurListKey))
+    {
+        m_sceneBlurCommands.Clear();
+        RecordBlur(m_sceneBlurCommands, m_sceneSnapshotSRV, m_sceneBlurRTV, m_sceneBlurSRV, m_sceneBlurRegion);
+        m_sceneBlurListKey = key;
+        m_passListRecords++;
+    }
+}
+
+void LiquidGlass::UpdateGlassLists(ID3D11RenderTargetView* mainRenderTarget)
+{
+    PassListKey key;
+    memset(&key, 0, sizeof(key));
+    key.resource = mainRenderTarget;
+    key.targetRevision = m_renderTargetRevision;
+    key.shadingRate = m_shadingRate;
+    key.shape = (int)m_shape;
+    key.deferred = m_recordThreads > 0;
+    if (key == m_glassListKey)
+        return;
+    for (int i = 0; i < 2; i++)
+    {
+        m_glassCommands[i].Clear();
+        RecordLiquidGlass(m_glassCommands[i], mainRenderTarget, i);
+    }
+    m_glassListKey = key;
+    m_passListRecords++;
+}
+
+// Projects the panels like the vertex shader does and re-bins them when anything moved
+void LiquidGlass::UpdateMergeBins()
+{
+    XMMATRIX viewProjection = m_camera.GetViewProjection();
+    MergeShape shapes[MaxMergeShapes];
+    memset(shapes, 0, sizeof(shapes));
+    int count = 0;
+    for (int i = -1; i < (int)m_mergePanels.size() && count < MaxMergeShapes; i++)
+    {
+        GlassPanel panel;
+        if (i < 0)
+        {
+            panel.position = XMFLOAT2(m_position.x, m_position.y);
+            panel.size = XMFLOAT2(m_width, m_height);
+            panel.shape = m_shape;
+            panel.cornerRadii = m_cornerRadii;
+        }
+        else
+        {
+            panel = m_mergePanels[i];
+        }
+        XMVECTOR mid = XMVector3TransformCoord(XMVectorSet(panel.position.x, panel.position.y, 0.0f, 1.0f), viewProjection);
+        XMVECTOR corner = XMVector3TransformCoord(XMVectorSet(panel.position.x + panel.size.x, panel.position.y + panel.size.y, 0.0f, 1.0f), viewProjection);
+        MergeShape& shape = shapes[count++];
+        shape.midPoint[0] = XMVectorGetX(mid);
+        shape.midPoint[1] = XMVectorGetY(mid);
+        shape.quadScale[0] = max(fabsf(XMVectorGetX(corner) - shape.midPoint[0]), 0.0001f);
+        shape.quadScale[1] = max(fabsf(XMVectorGetY(corner) - shape.midPoint[1]), 0.0001f);
+        shape.halfSize[0] = shape.quadScale[0] * 0.5f * m_screenWidth;
+        shape.halfSize[1] = shape.quadScale[1] * 0.5f * m_screenHeight;
+        shape.pixelScale = min(shape.halfSize[0], shape.halfSize[1]);
+        shape.shape = panel.shape;
+        memcpy(shape.cornerRadii, &panel.cornerRadii, sizeof(shape.cornerRadii));
+    }
+
+    if (m_mergeBinsValid && count == m_mergeShapeCount && memcmp(shapes, m_mergeShapes, sizeof(MergeShape) * count) == 0 &&
+        m_mergeBinsRadius == m_mergeRadius && m_mergeBinsPower == m_shaderParams.u_powerFactor)
+    {
+        // Unchanged, but a ring that started over has to be given the constants again
+        if (!m_constantRing.IsCurrent(m_mergeParamsRange))
+            m_constantRing.Allocate(&m_mergeParams, sizeof(MergeParams), m_mergeParamsRange);
+        if (!m_constantRing.IsCurrent(m_mergeTransformRange))
+            m_constantRing.Allocate(&m_mergeTransform, sizeof(TransformBuffer), m_mergeTransformRange);
+        return;
+    }
+    memcpy(m_mergeShapes, shapes, sizeof(shapes));
+    m_mergeShapeCount = count;
+    m_mergeBinsRadius = m_mergeRadius;
+    m_mergeBinsPower = m_shaderParams.u_powerFactor;
+    m_mergeBinsValid = true;
+    m_mergeValidationError = -1.0f;
+    m_mergeRebins++;
+    BinMergeShapes(m_mergeShapes, m_mergeShapeCount, m_shaderParams.u_powerFactor, m_mergeRadius, m_screenWidth, m_screenHeight, m_mergeBins);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    m_context->Map(m_mergeShapeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    memcpy(mapped.pData, m_mergeShapes, sizeof(MergeShape) * m_mergeShapeCount);
+    m_context->Unmap(m_mergeShapeBuffer, 0);
+    m_context->Map(m_mergeTileBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    memcpy(mapped.pData, m_mergeBins.ranges.data(), m_mergeBins.ranges.size() * sizeof(UINT));
+    m_context->Unmap(m_mergeTileBuffer, 0);
+    if (!m_mergeBins.shapes.empty())
+    {
+        m_context->Map(m_mergeTileShapeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        memcpy(mapped.pData, m_mergeBins.shapes.data(), m_mergeBins.shapes.size() * sizeof(UINT));
+        m_context->Unmap(m_mergeTileShapeBuffer, 0);
+        m_directMaps++;
+    }
+    m_directMaps += 2;
+
+    m_mergeParams.u_tilesX = m_mergeBins.tilesX;
+    m_mergeParams.u_mergeRadius = m_mergeRadius;
+    m_mergeParams._pad = XMFLOAT2(0.0f, 0.0f);
+    m_constantRing.Allocate(&m_mergeParams, sizeof(MergeParams), m_mergeParamsRange);
+
+    // The quad covers the binned tiles only, straight in NDC
+    float minX = m_mergeBins.boundsMin[0] / m_screenWidth * 2.0f - 1.0f;
+    float maxX = m_mergeBins.boundsMax[0] / m_screenWidth * 2.0f - 1.0f;
+    float minY = 1.0f - m_mergeBins.boundsMax[1] / m_screenHeight * 2.0f;
+    float maxY = 1.0f - m_mergeBins.boundsMin[1] / m_screenHeight * 2.0f;
+    memset(&m_mergeTransform, 0, sizeof(TransformBuffer));
+    m_mergeTransform.ViewProjection = XMMatrixIdentity();
+    m_mergeTransform.ObjectPosition = XMFLOAT3((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, 0.0f);
+    m_mergeTransform.ObjectSize = XMFLOAT2((maxX - minX) * 0.5f, (maxY - minY) * 0.5f);
+    m_mergeTransform.ScreenSize = XMFLOAT2((float)m_screenWidth, (float)m_screenHeight);
+    m_constantRing.Allocate(&m_mergeTransform, sizeof(TransformBuffer), m_mergeTransformRange);
 }
 
-void LiquidGlass::RenderLiquidGlass()
+void LiquidGlass::RenderMergedGlass()
 {
-    // Set viewport
+    if (m_mergeBins.occupiedTiles == 0)
+        return;
+
     D3D11_VIEWPORT viewport = {};
     viewport.Width = (float)m_screenWidth;
     viewport.Height = (float)m_screenHeight;
     viewport.MaxDepth = 1.0f;
     m_context->RSSetViewports(1, &viewport);
-    
-    // Set blend state for transparent rendering
+
     m_context->OMSetBlendState(m_blendState, nullptr, 0xFFFFFFFF);
     m_context->OMSetDepthStencilState(m_depthStencilState, 0);
     m_context->RSSetState(m_rasterizerState);
-    
+
+    const ConstantRange* ranges[3] = { &m_shaderParamsRange, &m_mergeTransformRange, &m_mergeParamsRange };
+    ID3D11Buffer* psBuffers[3];
+    UINT firstConstants[3], numConstants[3];
+    for (int i = 0; i < 3; i++)
+    {
+        psBuffers[i] = ranges[i]->buffer;
+        firstConstants[i] = ranges[i]->firstConstant;
+        numConstants[i] = ranges[i]->numConstants;
+    }
     m_context->IASetInputLayout(m_inputLayout);
     m_context->VSSetShader(m_liquidGlassVS, nullptr, 0);
-    m_context->PSSetShader(m_liquidGlassPS, nullptr, 0);
-    m_context->VSSetConstantBuffers(0, 1, &m_transformBuffer);
-    m_context->PSSetConstantBuffers(0, 1, &m_shaderParamsBuffer);
-    m_context->PSSetShaderResources(0, 1, &m_backgroundSRV);
-    m_context->PSSetShaderResources(1, 1, &m_blurFinalSRV);
-    m_context->PSSetSamplers(0, 1, &m_linearSampler);
+    m_context->PSSetShader(m_liquidGlassPS[m_shape], nullptr, 0);
+    m_context1->VSSetConstantBuffers1(0, 1, &m_mergeTransformRange.buffer, &m_mergeTransformRange.firstConstant, &m_mergeTransformRange.numConstants);
+    m_context1->PSSetConstantBuffers1(0, 3, psBuffers, firstConstants, numConstants);
+    m_context->PSSetConstantBuffers(3, 1, &m_modeBuffers[GlassMode_Merge]);
+    ID3D11ShaderResourceView* srvs[7] = { m_backgroundSRV, m_blurFinalSRV, m_glowLUT, m_blueNoise, m_mergeShapeSRV, m_mergeTileSRV, m_mergeTileShapeSRV };
+    ID3D11SamplerState* samplers[2] = { m_linearSampler, m_wrapSampler };
+    m_context->PSSetShaderResources(0, 7, srvs);
+    m_context->PSSetSamplers(0, 2, samplers);
 
     UINT stride = sizeof(Vertex);
     UINT offset = 0;
     m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_context->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_context->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R16_UINT, 0);
     m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     m_context->DrawIndexed(6, 0, 0);
@@ -709,13 +2362,291 @@ void LiquidGlass::RenderLiquidGlass()
 
 void LiquidGlass::Render(ID3D11RenderTargetView* mainRenderTarget)
 {
+    int scope = m_profiler.BeginScope(m_context, "Constants");
+    m_constantRing.BeginBatch();
     UpdateConstantBuffers();
-    RenderBackground();  // Render to internal RT for blur reference
-    ApplyBlur();         // Blur the background
-    
-    // Set main render target for final render
-    m_context->OMSetRenderTargets(1, &mainRenderTarget, nullptr);
-    
-    // Draw liquid glass effect (background is already drawn by ImGui)
-    RenderLiquidGlass();
+    if (m_liquidMerge)
+        UpdateMergeBins();
+    else if (m_shadingRate > 1)
+        UpdateShadingRateStats();
+    m_constantRing.Flush(m_context);
+    m_profiler.EndScope(m_context, scope);
+
+    // The background copy and its blur only change with the background or the blur settings,
+    // and only the region the glass samples is blurred. Glass that leaves the cached region
+    // gets the whole frame blurred, once, rather than a new region every frame it moves.
+    const GlassCommandList* lists[3];
+    int listCount = 0;
+    BlurCacheKey key = GetBlurCacheKey();
+    float bounds[4];
+    int region[4];
+    GetBlurRegion(GetPanelSampleBounds(bounds) ? bounds : nullptr, false, region);
+    bool cached = m_blurCacheValid && key == m_blurCacheKey;
+    bool inside = region[2] <= region[0] || (region[0] >= m_blurRegion[0] && region[1] >= m_blurRegion[1] &&
+        region[2] <= m_blurRegion[2] && region[3] <= m_blurRegion[3]);
+    if (cached && inside)
+    {
+        m_blurCacheHits++;
+    }
+    else
+    {
+        if (cached)
+            GetBlurRegion(nullptr, false, region);
+        memcpy(m_blurRegion, region, sizeof(region));
+        UpdateBlurLists();
+        lists[listCount++] = &m_backgroundCommands;    // Render to internal RT for blur reference
+        lists[listCount++] = &m_blurCommands;          // Blur the background
+        m_blurCacheKey = key;
+        m_blurCacheValid = true;
+        m_blurCacheMisses++;
+    }
+    int blurWidth = (int)(m_screenWidth * m_blurDownscaleFactor);
+    int blurHeight = (int)(m_screenHeight * m_blurDownscaleFactor);
+    m_blurArea = (float)(m_blurRegion[2] - m_blurRegion[0]) * (m_blurRegion[3] - m_blurRegion[1]) / max(blurWidth * blurHeight, 1);
+
+    // Draw liquid glass effect (background is already drawn by ImGui). The main panel also
+    // writes its output to this frame's history, read back by the next frame.
+    if (!m_liquidMerge)
+    {
+        UpdateGlassLists(mainRenderTarget);
+        lists[listCount++] = &m_glassCommands[m_historyIndex];
+        m_historyIndex = 1 - m_historyIndex;
+        m_historyMidPoint = m_midPoint;
+        m_historyWritten = m_temporalReuse;
+    }
+    ReplayPasses(lists, listCount);
+
+    if (m_liquidMerge)
+    {
+        scope = m_profiler.BeginScope(m_context, "Glass");
+        m_context->OMSetRenderTargets(1, &mainRenderTarget, nullptr);
+        RenderMergedGlass();
+        m_profiler.EndScope(m_context, scope);
+        m_historyWritten = false;
+    }
+
+    // Glass windows replay their scene blur before this, during ImGui's rendering
+    m_lastReplayStats = m_commandBackend.GetStats();
+    m_lastReplayStats.Add(m_parallelReplay.GetStats());
+    m_lastFrameMaps = m_constantRing.GetMaps() + m_lastReplayStats.uploads + m_directMaps;
+    m_commandBackend.ResetStats();
+    m_parallelReplay.ResetStats();
+    m_constantRing.ResetStats();
+    m_directMaps = 0;
+}
+
+// The frame's fixed passes in order, on this thread or recorded by m_parallelReplay (the glass
+// lists are recorded for it then, see RecordLiquidGlass()). "Submit" times the CPU side either way.
+void LiquidGlass::ReplayPasses(const GlassCommandList* const* lists, int count)
+{
+    if (count == 0)
+        return;
+    int scope = m_profiler.BeginScope(m_context, "Submit");
+    if (m_recordThreads > 0)
+    {
+        m_parallelReplay.Replay(m_context, lists, count);
+
+        // The recorders wrote constants behind the immediate backend's back
+        m_commandBackend.ForgetUploads();
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
+            m_commandBackend.Replay(*lists[i]);
+    }
+    m_profiler.EndScope(m_context, scope);
+}
+
+void LiquidGlass::SetRecordThreads(int threads)
+{
+    threads = max(0, min(threads, (int)D3D11ParallelReplay::MaxThreads));
+    if (threads == m_recordThreads)
+        return;
+    if (threads == 0)
+        m_parallelReplay.Release();
+    else if (!m_device || !m_parallelReplay.Create(m_device, threads))
+        threads = 0;
+    m_recordThreads = threads;
+}
+
+bool LiquidGlass::BeginGlassWindow(const char* name, bool* open, ImGuiWindowFlags flags)
+{
+    if (!m_glassWindows)
+        return ImGui::Begin(name, open, flags);
+
+    if (!ImGui::Begin(name, open, flags | ImGuiWindowFlags_NoBackground))
+        return false;
+
+    // Title bar and border are already in the draw list, the glass goes under the
+    // client area and everything the window submits from here on is drawn over it
+    ImGuiStyle& style = ImGui::GetStyle();
+    ImVec2 pos = ImGui::GetWindowPos();
+    ImVec2 size = ImGui::GetWindowSize();
+    float titleBarHeight = (flags & ImGuiWindowFlags_NoTitleBar) ? 0.0f : ImGui::GetFrameHeight();
+
+    GlassWindowCallbackData data;
+    data.glass = this;
+    data.frame = ImGui::GetFrameCount();
+    data.min = ImVec2(pos.x + style.WindowBorderSize, pos.y + max(titleBarHeight, style.WindowBorderSize));
+    data.max = ImVec2(pos.x + size.x - style.WindowBorderSize, pos.y + size.y - style.WindowBorderSize);
+    data.windowMin = pos;
+    data.windowMax = ImVec2(pos.x + size.x, pos.y + size.y);
+    data.topRounding = titleBarHeight > 0.0f ? 0.0f : style.WindowRounding;
+    data.bottomRounding = style.WindowRounding;
+    if (data.max.x <= data.min.x || data.max.y <= data.min.y)
+        return true;
+
+    // What this frame's scene blur has to cover, see SnapshotScene()
+    if (data.frame != m_frameGlassWindowsFrame)
+    {
+        m_frameGlassWindows.clear();
+        m_frameGlassWindowsFrame = data.frame;
+    }
+    m_frameGlassWindows.push_back(ImVec4(data.min.x, data.min.y, data.max.x, data.max.y));
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddCallback(GlassWindowCallback, &data, sizeof(data));
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    return true;
+}
+
+void LiquidGlass::GlassWindowCallback(const ImDrawList* drawList, const ImDrawCmd* cmd)
+{
+    const GlassWindowCallbackData* data = (const GlassWindowCallbackData*)cmd->UserCallbackData;
+    data->glass->RenderGlassWindow(*data);
+}
+
+// Copies what has been drawn so far and blurs it into the scene targets, as far as the glass
+// windows this frame began can sample it
+void LiquidGlass::SnapshotScene(ID3D11RenderTargetView* sceneRTV)
+{
+    int scope = m_profiler.BeginScope(m_context, "Scene Copy");
+    ID3D11Resource* sceneResource = nullptr;
+    sceneRTV->GetResource(&sceneResource);
+    m_context->CopyResource(m_sceneSnapshotRT, sceneResource);
+    sceneResource->Release();
+    m_profiler.EndScope(m_context, scope);
+
+    // Window quads are in pixels, y down
+    bool bounded = m_frameGlassWindowsFrame == m_sceneSnapshotFrame && !m_frameGlassWindows.empty();
+    float maxDistance = 0.0f;
+    for (size_t i = 0; bounded && i < m_frameGlassWindows.size(); i++)
+    {
+        const ImVec4& r = m_frameGlassWindows[i];
+        float halfX = (r.z - r.x) * 0.5f, halfY = (r.w - r.y) * 0.5f;
+        maxDistance = max(maxDistance, sqrtf(halfX * halfX + halfY * halfY) / max(min(halfX, halfY), 0.0001f));
+    }
+    float reach = bounded ? GetRefractionReach(maxDistance) : 0.0f;
+    float bounds[4] = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t i = 0; bounded && i < m_frameGlassWindows.size(); i++)
+    {
+        const ImVec4& r = m_frameGlassWindows[i];
+        float midX = (r.x + r.z) * 0.5f, midY = (r.y + r.w) * 0.5f;
+        float halfX = (r.z - r.x) * 0.5f * reach, halfY = (r.w - r.y) * 0.5f * reach;
+        bounds[0] = min(bounds[0], (midX - halfX) / m_screenWidth * 2.0f - 1.0f);
+        bounds[1] = min(bounds[1], 1.0f - (midY + halfY) / m_screenHeight * 2.0f);
+        bounds[2] = max(bounds[2], (midX + halfX) / m_screenWidth * 2.0f - 1.0f);
+        bounds[3] = max(bounds[3], 1.0f - (midY - halfY) / m_screenHeight * 2.0f);
+    }
+    GetBlurRegion(bounded ? bounds : nullptr, true, m_sceneBlurRegion);
+    int blurWidth = (int)(m_screenWidth * m_blurDownscaleFactor);
+    int blurHeight = (int)(m_screenHeight * m_blurDownscaleFactor);
+    m_sceneBlurArea = (float)(m_sceneBlurRegion[2] - m_sceneBlurRegion[0]) * (m_sceneBlurRegion[3] - m_sceneBlurRegion[1]) /
+        max(blurWidth * blurHeight, 1);
+
+    UpdateBlurLists();
+    m_commandBackend.Replay(m_sceneBlurCommands);
+}
+
+void LiquidGlass::RenderGlassWindow(const GlassWindowCallbackData& data)
+{
+    // Called from ImGui_ImplDX11_RenderDrawData(), draw into whatever it is drawing into
+    ID3D11RenderTargetView* sceneRTV = nullptr;
+    m_context->OMGetRenderTargets(1, &sceneRTV, nullptr);
+    if (!sceneRTV) return;
+
+    // The first glass window of a frame snapshots the scene and every later one samples the
+    // same blur, unless it sits over glass drawn after that snapshot and has to see it
+    bool snapshot = false;
+    m_constantRing.BeginBatch();
+    if (data.frame != m_sceneSnapshotFrame)
+    {
+        UpdateConstantBuffers();
+        m_sceneSnapshotFrame = data.frame;
+        m_lastGlassStats = m_glassStats;
+        m_glassStats = GlassFrameStats();
+        snapshot = true;
+    }
+    else if (m_glassSeesGlass)
+    {
+        for (size_t i = 0; i < m_glassSinceSnapshot.size() && !snapshot; i++)
+        {
+            const ImVec4& r = m_glassSinceSnapshot[i];
+            snapshot = data.min.x < r.z && data.max.x > r.x && data.min.y < r.w && data.max.y > r.y;
+        }
+    }
+    if (snapshot)
+    {
+        SnapshotScene(sceneRTV);
+        m_glassSinceSnapshot.clear();
+        m_glassStats.snapshots++;
+    }
+    m_glassSinceSnapshot.push_back(ImVec4(data.windowMin.x, data.windowMin.y, data.windowMax.x, data.windowMax.y));
+    m_glassStats.glassWindows++;
+
+    // Pixel space, y up, so the window quad lines up with the main glass quad's conventions.
+    // Every window gets its own range, the windows drawn before still read theirs.
+    int scope = m_profiler.BeginScope(m_context, "Glass Window");
+    TransformBuffer transformData;
+    memset(&transformData, 0, sizeof(transformData));
+    XMMATRIX projection = XMMatrixOrthographicOffCenterLH(0.0f, (float)m_screenWidth, 0.0f, (float)m_screenHeight, -1.0f, 1.0f);
+    transformData.ViewProjection = XMMatrixTranspose(projection);
+    transformData.ObjectPosition = XMFLOAT3((data.min.x + data.max.x) * 0.5f, m_screenHeight - (data.min.y + data.max.y) * 0.5f, 0.0f);
+    transformData.ObjectSize = XMFLOAT2((data.max.x - data.min.x) * 0.5f, (data.max.y - data.min.y) * 0.5f);
+    transformData.ScreenSize = XMFLOAT2((float)m_screenWidth, (float)m_screenHeight);
+    transformData.CornerRadii = XMFLOAT2(data.topRounding, data.bottomRounding);
+    if (!m_constantRing.IsCurrent(m_shaderParamsRange))
+        m_constantRing.Allocate(&m_uploadedShaderParams, sizeof(ShaderParams), m_shaderParamsRange);
+    m_constantRing.Allocate(&transformData, sizeof(TransformBuffer), m_windowTransformRange);
+    m_constantRing.Flush(m_context);
+
+    m_context->OMSetRenderTargets(1, &sceneRTV, nullptr);
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = (float)m_screenWidth;
+    viewport.Height = (float)m_screenHeight;
+    viewport.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &viewport);
+
+    m_context->OMSetBlendState(m_blendState, nullptr, 0xFFFFFFFF);
+    m_context->OMSetDepthStencilState(m_depthStencilState, 0);
+    m_context->RSSetState(m_rasterizerState);
+
+    ID3D11ShaderResourceView* blurred = m_blurIterations > 0 ? m_sceneBlurSRV : m_sceneSnapshotSRV;
+    ID3D11Buffer* psBuffers[2] = { m_shaderParamsRange.buffer, m_windowTransformRange.buffer };
+    UINT firstConstants[2] = { m_shaderParamsRange.firstConstant, m_windowTransformRange.firstConstant };
+    UINT numConstants[2] = { m_shaderParamsRange.numConstants, m_windowTransformRange.numConstants };
+    m_context->IASetInputLayout(m_inputLayout);
+    m_context->VSSetShader(m_liquidGlassVS, nullptr, 0);
+    m_context->PSSetShader(m_liquidGlassPS[m_shape], nullptr, 0);
+    m_context1->VSSetConstantBuffers1(0, 1, &m_windowTransformRange.buffer, &m_windowTransformRange.firstConstant, &m_windowTransformRange.numConstants);
+    m_context1->PSSetConstantBuffers1(0, 2, psBuffers, firstConstants, numConstants);
+    m_context->PSSetConstantBuffers(3, 1, &m_modeBuffers[GlassMode_Window]);
+    ID3D11ShaderResourceView* srvs[3] = { blurred, m_glowLUT, m_blueNoise };
+    ID3D11SamplerState* samplers[2] = { m_linearSampler, m_wrapSampler };
+    m_context->PSSetShaderResources(1, 3, srvs);
+    m_context->PSSetSamplers(0, 2, samplers);
+
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    m_context->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+    m_context->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    m_context->DrawIndexed(6, 0, 0);
+    m_profiler.EndScope(m_context, scope);
+
+    // The snapshot is a copy destination next frame, don't leave it bound
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    m_context->PSSetShaderResources(1, 1, &nullSRV);
+    sceneRTV->Release();
 }
@@ -3,15 +3,56 @@
 #include <DirectXMath.h>
 #include <vector>
 #include <string>
+#include <string.h>
+#include "AnimatedBackground.h"
+#include "BackgroundCache.h"
+#include "ConstantRing.h"
+#include "D3D11CommandBackend.h"
+#include "D3D11ParallelReplay.h"
+#include "FrameProfiler.h"
+#include "GlassLookupTables.h"
+#include "GlassShapes.h"
+#include "OrthoCamera.h"
+#include "ParameterTimeline.h"
+#include "imgui.h"
 
 using namespace DirectX;
 
+struct ImGuiSettingsHandler;
+
+// Panel quad corner: position as R16G16_SNORM, UV as R16G16_UNORM. Screen passes have no
+// vertices at all, they draw a fullscreen triangle from the vertex id (BlurVS.hlsl).
 struct Vertex
 {
-    XMFLOAT3 Position;
-    XMFLOAT2 TexCoord;
-    XMFLOAT4 Color;
-    UINT LiquidGlass;
+    short Position[2];
+    unsigned short TexCoord[2];
+};
+
+// Which effect a glass draw shades, bound as its GlassPassParams (b3)
+enum GlassMode
+{
+    GlassMode_Texture,      // Background texture as is
+    GlassMode_Glass,        // Main panel
+    GlassMode_Background,   // Blurred background as is
+    GlassMode_Window,       // Glass under an ImGui window
+    GlassMode_Merge,        // Liquid merge of the main panel and the merge panels
+    GlassMode_Interior,     // Main panel interior at the variable rate
+    GlassMode_COUNT
+};
+
+// How the pixel shader evaluates the refraction profile, see FitRefraction()
+enum GlassRefractionMode
+{
+    GlassRefraction_Exact,      // The formula as written, for validation
+    GlassRefraction_Folded,     // One exp2 of the folded constants, same up to float rounding
+    GlassRefraction_Cubic,      // Scale from a cubic fit, no pow; the folded form where it can't apply
+    GlassRefraction_COUNT
+};
+
+struct GlassPassParams
+{
+    UINT u_mode;
+    XMFLOAT3 _pad;
 };
 
 struct TransformBuffer
@@ -21,6 +62,12 @@ struct TransformBuffer
     float _pad0;
     XMFLOAT2 ObjectSize;
     XMFLOAT2 ScreenSize;
+    XMFLOAT2 CornerRadii;   // Glass windows only: top and bottom corner radius in pixels
+    XMFLOAT2 InteriorScale; // Variable rate: screen pixel to interior texture coordinate
+    XMFLOAT4 ShapeRadii;    // Rounded rect panel: top-left, top-right, bottom-right, bottom-left
+    XMFLOAT2 HistoryMidPoint;   // Temporal reuse: panel center (NDC) in the frame the history holds
+    float HistoryStart;         // Temporal reuse: distance from the edge where it starts, 0 is off
+    float _pad2;
 };
 
 struct ShaderParams
@@ -36,7 +83,21 @@ struct ShaderParams
     float u_glowBias;
     float u_glowEdge0;
     float u_glowEdge1;
-    float _pad[1];
+    float u_dispersion;
+    float u_dispersionBand;
+    float u_specular;
+    float u_shininess;
+    float u_fresnel;
+    XMFLOAT3 u_lightDir;
+    float u_bevel;
+    float u_exact;          // Exact glow/noise instead of the lookup tables, for validation
+    float u_interiorBand;   // Variable rate, set from the LiquidGlass settings each frame
+    float u_interiorMargin;
+    float u_refractionMode;         // Folded from the refraction and the settings each frame, see FitRefraction()
+    XMFLOAT4 u_refractionCubic;
+    float u_refractionSlope;
+    float u_refractionWeight;
+    XMFLOAT2 _pad;
 };
 
 struct BlurParams
@@ -47,13 +108,131 @@ struct BlurParams
     XMFLOAT3 _pad;
 };
 
+struct MergeParams
+{
+    UINT u_tilesX;
+    float u_mergeRadius;
+    XMFLOAT2 _pad;
+};
+
+// Extra panel of the liquid merge, world units like the main panel (size is the half size)
+struct GlassPanel
+{
+    XMFLOAT2 position;
+    XMFLOAT2 size;
+    GlassShapeType shape;
+    XMFLOAT4 cornerRadii;   // Rounded rect, in shorter half sides
+};
+
 struct Background
 {
     std::string name;
     std::string credits;
+    std::string path;
     ID3D11ShaderResourceView* texture;
     int width;
     int height;
+    BackgroundCacheFormat format;
+    size_t memoryBytes;     // Whole mip chain as uploaded
+    AnimatedBackground* animation;  // Owned, nullptr for still images
+};
+
+// Everything the blurred background depends on, the blur passes are skipped while it holds
+struct BlurCacheKey
+{
+    int backgroundId;
+    uint64_t backgroundRevision;
+    int iterations;
+    float radius;
+    float downscale;
+    int width;
+    int height;
+
+    bool operator==(const BlurCacheKey& other) const
+    {
+        return backgroundId == other.backgroundId && backgroundRevision == other.backgroundRevision &&
+            iterations == other.iterations && radius == other.radius && downscale == other.downscale &&
+            width == other.width && height == other.height;
+    }
+};
+
+// Everything a recorded pass list bakes in besides resources that live as long as the render
+// targets, the list is re-recorded when it changes (see LiquidGlass::UpdateBlurLists())
+struct PassListKey
+{
+    const void* resource;   // Background texture or main render target
+    int targetRevision;     // LiquidGlass::m_renderTargetRevision
+    int iterations;
+    float radius;
+    float downscale;
+    int shadingRate;
+    int shape;
+    int deferred;           // Recorded for the recording threads
+    int region[4];          // Blur scissor, see LiquidGlass::GetBlurRegion()
+
+    bool operator==(const PassListKey& other) const { return memcmp(this, &other, sizeof(PassListKey)) == 0; }
+};
+
+// Everything the main panel's output depends on but its position: last frame's output is
+// reused while it holds (see LiquidGlass::UpdateGlassHistory())
+struct GlassHistoryKey
+{
+    BlurCacheKey blur;
+    ShaderParams shader;
+    XMFLOAT2 quadScale;     // NDC half extent
+    XMFLOAT2 objectSize;
+    GlassShapeType shape;
+    XMFLOAT4 cornerRadii;
+
+    bool operator==(const GlassHistoryKey& other) const
+    {
+        return blur == other.blur && memcmp(&shader, &other.shader, sizeof(ShaderParams)) == 0 &&
+            quadScale.x == other.quadScale.x && quadScale.y == other.quadScale.y &&
+            objectSize.x == other.objectSize.x && objectSize.y == other.objectSize.y && shape == other.shape &&
+            memcmp(&cornerRadii, &other.cornerRadii, sizeof(XMFLOAT4)) == 0;
+    }
+};
+
+// Tunable state saved by presets: shader parameters, blur settings, panel size and shape.
+// Floats only, so presets are copied, compared and blended field by field.
+struct GlassPreset
+{
+    ShaderParams shader;
+    float blurRadius;
+    float blurIterations;   // Rounded when applied
+    float blurDownscale;
+    float width;
+    float height;
+    float shape;            // GlassShapeType, rounded and clamped when applied
+    XMFLOAT4 cornerRadii;
+};
+
+enum { GlassPresetNameSize = 32 };
+
+// Named preset, also the record layout of the binary preset file (GlassPresets.h)
+struct GlassPresetEntry
+{
+    char name[GlassPresetNameSize];
+    GlassPreset preset;
+};
+
+struct GlassFrameStats
+{
+    int glassWindows;
+    int snapshots;          // Scene copies + blurs
+};
+
+// Payload of the draw callback that puts glass under an ImGui window
+struct GlassWindowCallbackData
+{
+    class LiquidGlass* glass;
+    int frame;
+    ImVec2 min;             // Glass area in display pixels (below the title bar)
+    ImVec2 max;
+    ImVec2 windowMin;       // Whole window, what later glass sees of this one
+    ImVec2 windowMax;
+    float topRounding;
+    float bottomRounding;
 };
 
 class LiquidGlass
@@ -68,40 +247,145 @@ public:
     void Render(ID3D11RenderTargetView* mainRenderTarget);
     void OnResize(int width, int height);
     void RenderUI();
+
+    // ImGui::Begin() for a window drawn over refracted, blurred glass instead of its background.
+    // Glass windows share a blurred snapshot of the scene drawn before the first of them; a new
+    // snapshot is only taken when a glass window overlaps glass drawn since the last one.
+    bool BeginGlassWindow(const char* name, bool* open = nullptr, ImGuiWindowFlags flags = 0);
     
+    // Keyframes for every ShaderParams field, the panel position/size and the blur radius.
+    // Tracks are named after the fields without the u_ prefix ("powerFactor", "lightDir.x",
+    // "width", "positionX", "blurRadius"...), see RegisterTimelineTracks().
+    ParameterTimeline& GetTimeline() { return m_timeline; }
+
+    // Presets: named GlassPreset snapshots, kept in imgui.ini through a settings handler
+    // along with the live values, and in a binary file for fast bulk switching.
+    void CapturePreset(GlassPreset& preset) const;
+    void ApplyPreset(const GlassPreset& preset);
+    bool SavePreset(const char* name);      // Current values, replaces a preset of the same name
+    bool LoadPreset(const char* name);
+    bool SavePresetFile(const char* path) const;
+    bool LoadPresetFile(const char* path);
+    const std::vector<GlassPresetEntry>& GetPresets() const { return m_presets; }
+
+    // Per-pass CPU/GPU timings. The application brackets its frame with BeginFrame()/EndFrame()
+    // and its own passes (ImGui) with scopes, LiquidGlass records its passes inside.
+    FrameProfiler& GetProfiler() { return m_profiler; }
+
+    // Outline of the main panel, the pixel shader variant follows it
+    void SetShape(GlassShapeType shape) { m_shape = shape; }
+    GlassShapeType GetShape() const { return m_shape; }
+
+    // Variable rate shading of the main panel: 1, 2 or 4 (interior shaded at 1/rate per axis),
+    // and the estimated share of its full rate pixel shading saved
+    void SetShadingRate(int rate) { m_shadingRate = rate; }
+    int GetShadingRate() const { return m_shadingRate; }
+    float GetShadingRateSaved() const { return m_shadingRateSaved; }
+
+    // Temporal reuse of the main panel's output: share of its pixels copied from the last
+    // frame in the last Render(), 0 whenever anything but the panel's position changed
+    void SetTemporalReuse(bool enabled) { m_temporalReuse = enabled; }
+    float GetTemporalReuseRatio() const { return m_historyReuseRatio; }
+
+    // Refraction evaluation, and the largest error of the refraction scale it shades with
+    void SetRefractionMode(GlassRefractionMode mode) { m_refractionMode = mode; }
+    GlassRefractionMode GetRefractionMode() const { return m_refractionMode; }
+    float GetRefractionError() const;
+
+    // Threads recording the background, blur and glass passes into deferred contexts, up to
+    // D3D11ParallelReplay::MaxThreads; 0 replays them on the immediate context
+    void SetRecordThreads(int threads);
+    int GetRecordThreads() const { return m_recordThreads; }
+
+    // Forces the next Render() to redraw and blur the background, for benchmarks
+    void InvalidateBlurCache() { m_blurCacheValid = false; }
+    const GlassFrameStats& GetLastGlassStats() const { return m_lastGlassStats; }
+    // Share of the blur targets the last background and scene blurs covered
+    float GetBlurArea() const { return m_blurArea; }
+    float GetSceneBlurArea() const { return m_sceneBlurArea; }
+    const GlassReplayStats& GetLastReplayStats() const { return m_lastReplayStats; }
+    int GetLastFrameMaps() const { return m_lastFrameMaps; }
+
     // Getter for backgrounds
     const std::vector<Background>& GetBackgrounds() const { return m_backgrounds; }
+    ID3D11ShaderResourceView* GetCurrentBackgroundTexture() const;
 
 private:
     // Helper methods
     bool CreateShaders();
     bool CreateBuffers();
     bool CreateRenderTargets(int width, int height);
-    bool LoadTexture(const char* filename, ID3D11ShaderResourceView** textureView, int* width, int* height);
+    bool CreateLookupTextures();
+    bool LoadTexture(const char* filename, BackgroundCacheFormat format, ID3D11ShaderResourceView** textureView,
+        int* width, int* height, size_t* memoryBytes);
+    bool ReloadBackground(Background& bg, BackgroundCacheFormat format);
+    bool LoadAnimatedBackground(const char* filename, const char* name);
+    static ID3D11ShaderResourceView* GetBackgroundTexture(const Background& bg);
+    bool CreateTextureFromMips(BackgroundCacheFormat format, UINT width, UINT height, UINT mipCount,
+        const BackgroundCacheMip* mips, const unsigned char* base, ID3D11ShaderResourceView** textureView);
+    void RegisterTimelineTracks();
+    void RegisterSettingsHandler();
+    int FindPreset(const char* name) const;
+    static void* SettingsHandler_ReadOpen(ImGuiContext* ctx, ImGuiSettingsHandler* handler, const char* name);
+    static void SettingsHandler_ReadLine(ImGuiContext* ctx, ImGuiSettingsHandler* handler, void* entry, const char* line);
+    static void SettingsHandler_ApplyAll(ImGuiContext* ctx, ImGuiSettingsHandler* handler);
+    static void SettingsHandler_WriteAll(ImGuiContext* ctx, ImGuiSettingsHandler* handler, ImGuiTextBuffer* buf);
+    BlurCacheKey GetBlurCacheKey() const;
+    float GetHistoryStart(XMFLOAT2 quadScale) const;
+    float GetRefractionReach(float maxDistance);
+    bool GetPanelSampleBounds(float bounds[4]);
+    void GetBlurRegion(const float* bounds, bool topDown, int region[4]) const;
+    void UpdateGlassHistory();
     void UpdateConstantBuffers();
-    void RenderBackground();
-    void ApplyBlur();
-    void RenderLiquidGlass();
+    void UpdateDispersionStats();
+    void UpdateShadingRateStats();
+    void UpdateRefractionFit();
+    void RecordBackground(GlassCommandList& list);
+    void RecordBlur(GlassCommandList& list, ID3D11ShaderResourceView* source, ID3D11RenderTargetView* targetRTV, ID3D11ShaderResourceView* targetSRV,
+        const int region[4]);
+    void RecordLiquidGlass(GlassCommandList& list, ID3D11RenderTargetView* mainRenderTarget, int historyIndex);
+    void UpdateBlurLists();
+    void ReplayPasses(const GlassCommandList* const* lists, int count);
+    void UpdateGlassLists(ID3D11RenderTargetView* mainRenderTarget);
+    void UpdateMergeBins();
+    void RenderMergedGlass();
+    void SnapshotScene(ID3D11RenderTargetView* sceneRTV);
+    void RenderGlassWindow(const GlassWindowCallbackData& data);
+    static void GlassWindowCallback(const ImDrawList* drawList, const ImDrawCmd* cmd);
 
 private:
     ID3D11Device* m_device;
     ID3D11DeviceContext* m_context;
+    ID3D11DeviceContext1* m_context1;       // Binds ranges of m_constantRing
 
     // Shaders
     ID3D11VertexShader* m_liquidGlassVS;
-    ID3D11PixelShader* m_liquidGlassPS;
+    ID3D11PixelShader* m_liquidGlassPS[GlassShape_COUNT];  // Specialized for the main panel's shape
     ID3D11VertexShader* m_blurVS;
     ID3D11PixelShader* m_blurPS;
     ID3D11PixelShader* m_simpleTexturePS;  // For rendering background texture
     ID3D11InputLayout* m_inputLayout;
-    ID3D11InputLayout* m_blurInputLayout;
 
     // Buffers
-    ID3D11Buffer* m_vertexBuffer;
+    ID3D11Buffer* m_vertexBuffer;          // Panel quad, every glass mode
     ID3D11Buffer* m_indexBuffer;
-    ID3D11Buffer* m_transformBuffer;
-    ID3D11Buffer* m_shaderParamsBuffer;
+    ID3D11Buffer* m_modeBuffers[GlassMode_COUNT];  // Immutable GlassPassParams
     ID3D11Buffer* m_blurParamsBuffer;
+    ID3D11Buffer* m_blurVerticalParamsBuffer;  // Second direction, both keep their contents between replays
+    ID3D11Buffer* m_deferredTransformBuffer;   // m_transformData for the recording threads
+    ID3D11Buffer* m_deferredShaderParamsBuffer;
+
+    // Per-frame constants, ranges of one ring buffer written a batch per Map
+    ConstantRing m_constantRing;
+    ConstantRange m_transformRange;
+    ConstantRange m_shaderParamsRange;
+    ConstantRange m_windowTransformRange;      // The glass window being drawn
+    ConstantRange m_mergeTransformRange;
+    ConstantRange m_mergeParamsRange;
+    int m_directMaps;                          // Maps outside the ring and the command lists this frame
+    int m_lastFrameMaps;
+    ID3D11Buffer* m_mergeShapeBuffer;
+    ID3D11ShaderResourceView* m_mergeShapeSRV;
 
     // Render targets
     ID3D11Texture2D* m_backgroundRT;
@@ -116,32 +400,177 @@ private:
     ID3D11RenderTargetView* m_blurFinalRTV;
     ID3D11ShaderResourceView* m_blurFinalSRV;
 
+    // Scene copy for glass windows (top-down, unlike the background targets above)
+    ID3D11Texture2D* m_sceneSnapshotRT;
+    ID3D11ShaderResourceView* m_sceneSnapshotSRV;
+    ID3D11Texture2D* m_sceneBlurRT;
+    ID3D11RenderTargetView* m_sceneBlurRTV;
+    ID3D11ShaderResourceView* m_sceneBlurSRV;
+
+    // Variable rate interior of the main panel, half the screen (a quarter rate uses a corner)
+    ID3D11Texture2D* m_interiorRT;
+    ID3D11RenderTargetView* m_interiorRTV;
+    ID3D11ShaderResourceView* m_interiorSRV;
+    int m_interiorWidth;
+    int m_interiorHeight;
+
+    // Main panel output of the last two frames, written and read in turn (temporal reuse)
+    ID3D11Texture2D* m_historyRT[2];
+    ID3D11RenderTargetView* m_historyRTV[2];
+    ID3D11ShaderResourceView* m_historySRV[2];
+
+    // Liquid merge tile bins, sized by the screen
+    ID3D11Buffer* m_mergeTileBuffer;
+    ID3D11ShaderResourceView* m_mergeTileSRV;
+    ID3D11Buffer* m_mergeTileShapeBuffer;
+    ID3D11ShaderResourceView* m_mergeTileShapeSRV;
+
+    // Glow and noise lookup tables (t2, t3)
+    ID3D11ShaderResourceView* m_glowLUT;
+    ID3D11ShaderResourceView* m_blueNoise;
+
     // Samplers
     ID3D11SamplerState* m_linearSampler;
+    ID3D11SamplerState* m_wrapSampler;     // Glow LUT
 
     // Rasterizer states
     ID3D11RasterizerState* m_rasterizerState;
+    ID3D11RasterizerState* m_scissorRasterizerState;   // Blur passes, clipped to their region
     ID3D11BlendState* m_blendState;
     ID3D11DepthStencilState* m_depthStencilState;
 
     // Backgrounds
     std::vector<Background> m_backgrounds;
     int m_currentBackgroundId;
+    uint64_t m_backgroundRevision;  // Bumped when a still background is reloaded
+
+    // Blur cache
+    BlurCacheKey m_blurCacheKey;
+    bool m_blurCacheValid;
+    int m_blurCacheHits;
+    int m_blurCacheMisses;
+
+    // Region of interest blur: only the blur target texels some glass can sample are blurred
+    bool m_blurRegionOfInterest;
+    int m_blurRegion[4];            // Background blur texels valid while the cache holds
+    int m_sceneBlurRegion[4];       // Of the current scene snapshot
+    float m_blurArea;
+    float m_sceneBlurArea;
+    float m_reachKey[7];            // Refraction and distance m_reach was sampled for
+    float m_reach;
+
+    // Glass windows
+    bool m_glassWindows;
+    bool m_glassSeesGlass;          // Re-snapshot when glass overlaps earlier glass
+    int m_sceneSnapshotFrame;       // ImGui frame of the current scene snapshot
+    std::vector<ImVec4> m_glassSinceSnapshot;   // Windows drawn over the current snapshot
+    std::vector<ImVec4> m_frameGlassWindows;    // Glass quads BeginGlassWindow() submitted, pixels
+    int m_frameGlassWindowsFrame;               // ImGui frame they were submitted in
+    GlassFrameStats m_glassStats;   // This frame so far
+    GlassFrameStats m_lastGlassStats;
+
+    // Liquid merge: the main panel and m_mergePanels blended into one shape
+    bool m_liquidMerge;
+    float m_mergeRadius;            // Pixels
+    std::vector<GlassPanel> m_mergePanels;
+    MergeShape m_mergeShapes[MaxMergeShapes];   // As binned
+    int m_mergeShapeCount;
+    MergeBins m_mergeBins;
+    bool m_mergeBinsValid;
+    float m_mergeBinsRadius;
+    float m_mergeBinsPower;
+    int m_mergeRebins;
+    MergeParams m_mergeParams;      // Contents of m_mergeParamsRange
+    TransformBuffer m_mergeTransform;   // Contents of m_mergeTransformRange
+    float m_mergeValidationError;   // Negative until validated
+
+    FrameProfiler m_profiler;
+
+    // Command lists: the fixed passes, recorded once and replayed until their key changes
+    D3D11CommandBackend m_commandBackend;
+    GlassCommandList m_backgroundCommands;      // Background texture into m_backgroundRT
+    GlassCommandList m_blurCommands;            // m_backgroundRT blurred into m_blurFinalRT
+    GlassCommandList m_sceneBlurCommands;       // Scene snapshot blurred into m_sceneBlurRT
+    GlassCommandList m_glassCommands[2];        // Interior and main glass, per history index
+    PassListKey m_backgroundListKey;
+    PassListKey m_blurListKey;
+    PassListKey m_sceneBlurListKey;
+    PassListKey m_glassListKey;
+    int m_renderTargetRevision;                 // Bumped by OnResize()
+    int m_passListRecords;
+    GlassReplayStats m_lastReplayStats;
+    D3D11ParallelReplay m_parallelReplay;
+    int m_recordThreads;
+
+    // Parameter animation
+    ParameterTimeline m_timeline;
+    int m_timelineTrack;            // Selected in the UI
+    int m_timelineEasing;
+
+    // Presets
+    std::vector<GlassPresetEntry> m_presets;
+    GlassPreset m_iniPreset;        // Live values as last read from or marked dirty for imgui.ini
+    bool m_iniPresetRead;           // [LiquidGlass][Current] was read and waits for ApplyAll
+    bool m_settingsHandler;
+    char m_presetName[GlassPresetNameSize];
+    int m_presetBlendA;
+    int m_presetBlendB;
+    float m_presetBlend;
 
     // Shader parameters
     ShaderParams m_shaderParams;
+    ShaderParams m_uploadedShaderParams;    // Contents of m_shaderParamsRange
+    int m_shaderParamsUploads;
+    int m_shaderParamsSkips;
     BlurParams m_blurParams;
-    TransformBuffer m_transformData;
+    TransformBuffer m_transformData;       // Contents of m_transformRange
+    int m_transformUploads;
+    int m_transformSkips;
+
+    // Dispersion cost model: share of the glass inside the three-fetch edge band
+    float m_dispersionStatsKey[8];      // Shape and band the fractions were sampled for
+    float m_dispersionBandFraction;
+    float m_dispersionInsideFraction;   // Share of the quad inside the shape
+
+    // Variable rate shading: the main panel's interior past m_interiorBand is shaded at
+    // 1/m_shadingRate per axis and upsampled, the edge band at full rate
+    int m_shadingRate;
+    float m_interiorBand;               // Distance from the edge, shorter half sides
+    float m_shadingRateStatsKey[11];    // Shape, band, rate and size the fractions were sampled for
+    float m_shadingRateInterior;        // Share of the glass upsampled
+    float m_shadingRateSaved;           // Share of the full rate shading saved
+
+    // Refraction evaluation, the fit is folded into m_shaderParams every frame
+    GlassRefractionMode m_refractionMode;
+    float m_refractionKey[5];           // Refraction and power m_refractionFit was made for
+    RefractionFit m_refractionFit;
+
+    // Temporal reuse: m_historyRT[m_historyIndex] is written this frame, the other one holds
+    // the last frame's output, rendered with m_historyKey with the panel at m_historyMidPoint
+    bool m_temporalReuse;
+    float m_historyTolerance;           // Pixels the refracted sample may drift from the pixel
+    float m_historyKeyTolerance;
+    int m_historyIndex;
+    bool m_historyWritten;              // The last frame drew the main panel into its history
+    GlassHistoryKey m_historyKey;
+    XMFLOAT2 m_historyMidPoint;
+    XMFLOAT2 m_midPoint;                // This frame's panel center, NDC
+    float m_historyStart;               // Reuse distance for m_historyKey, 0 when nothing settles
+    float m_historyReuseStart;          // As uploaded this frame, 0 when the history is stale
+    float m_historyReuseRatio;
+    int m_historyInvalidations;
 
     // Animation state
     XMFLOAT3 m_position;
-    XMFLOAT3 m_cameraPosition;
+    OrthoCamera m_camera;
     float m_velocityMultiplier;
     float m_cameraVelocityMultiplier;
     float m_velocity;
     float m_cameraVelocity;
     float m_width;
     float m_height;
+    GlassShapeType m_shape;
+    XMFLOAT4 m_cornerRadii;         // Rounded rect, in shorter half sides
     int m_blurIterations;
     float m_blurDownscaleFactor;
     bool m_mouseControl;
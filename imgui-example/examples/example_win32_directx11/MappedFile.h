@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file. The mapping is released by
+// Close() or the destructor; pointers returned by Data() die with it.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const char* filename);
+    void Close();
+
+    const unsigned char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+// Decodes an image straight out of a file mapping through stbi_load_from_memory,
+// so the encoded bytes are never copied into stdio or stb_image buffers.
+// Same contract as stbi_load(); free the result with stbi_image_free().
+unsigned char* LoadImageMapped(const char* filename, int* width, int* height, int* channels, int desiredChannels);
@@ -0,0 +1,116 @@
+#include "OrthoCamera.h"
+
+using namespace DirectX;
+
+const float OrthoCamera::MinZoom = 0.1f;
+const float OrthoCamera::MaxZoom = 20.0f;
+
+OrthoCamera::OrthoCamera()
+{
+    m_viewportWidth = 1280;
+    m_viewportHeight = 800;
+    m_referenceSize = XMFLOAT2(15.0f, 15.0f * 800.0f / 1280.0f);
+    m_fit = CameraFit_Width;
+    m_zoom = 1.0f;
+    m_position = XMFLOAT2(0.0f, 0.0f);
+    m_matrixDirty = true;
+}
+
+void OrthoCamera::SetViewport(int width, int height)
+{
+    width = width > 1 ? width : 1;
+    height = height > 1 ? height : 1;
+    if (width == m_viewportWidth && height == m_viewportHeight)
+        return;
+    m_viewportWidth = width;
+    m_viewportHeight = height;
+    Changed();
+}
+
+void OrthoCamera::SetReferenceSize(float width, float height)
+{
+    if (width == m_referenceSize.x && height == m_referenceSize.y)
+        return;
+    m_referenceSize = XMFLOAT2(width, height);
+    Changed();
+}
+
+void OrthoCamera::SetFit(CameraFit fit)
+{
+    if (fit == m_fit)
+        return;
+    m_fit = fit;
+    Changed();
+}
+
+void OrthoCamera::SetZoom(float zoom)
+{
+    zoom = zoom < MinZoom ? MinZoom : zoom > MaxZoom ? MaxZoom : zoom;
+    if (zoom == m_zoom)
+        return;
+    m_zoom = zoom;
+    Changed();
+}
+
+void OrthoCamera::SetPosition(float x, float y)
+{
+    if (x == m_position.x && y == m_position.y)
+        return;
+    m_position = XMFLOAT2(x, y);
+    Changed();
+}
+
+void OrthoCamera::PanPixels(float dx, float dy)
+{
+    float unitsPerPixel = 1.0f / GetPixelsPerUnit();
+    Pan(-dx * unitsPerPixel, dy * unitsPerPixel);
+}
+
+void OrthoCamera::ZoomAt(float factor, float screenX, float screenY)
+{
+    XMFLOAT2 before = ScreenToWorld(screenX, screenY);
+    SetZoom(m_zoom * factor);
+    XMFLOAT2 after = ScreenToWorld(screenX, screenY);
+    Pan(before.x - after.x, before.y - after.y);
+}
+
+void OrthoCamera::Reset()
+{
+    SetZoom(1.0f);
+    SetPosition(0.0f, 0.0f);
+}
+
+XMFLOAT2 OrthoCamera::GetViewSize() const
+{
+    float aspect = (float)m_viewportHeight / (float)m_viewportWidth;
+    bool fitWidth = m_fit == CameraFit_Width ||
+        (m_fit == CameraFit_Contain && aspect >= m_referenceSize.y / m_referenceSize.x);
+    XMFLOAT2 size = fitWidth ? XMFLOAT2(m_referenceSize.x, m_referenceSize.x * aspect)
+                             : XMFLOAT2(m_referenceSize.y / aspect, m_referenceSize.y);
+    return XMFLOAT2(size.x / m_zoom, size.y / m_zoom);
+}
+
+float OrthoCamera::GetPixelsPerUnit() const
+{
+    return m_viewportWidth / GetViewSize().x;
+}
+
+XMFLOAT2 OrthoCamera::ScreenToWorld(float screenX, float screenY) const
+{
+    XMFLOAT2 size = GetViewSize();
+    return XMFLOAT2(m_position.x + (screenX / m_viewportWidth - 0.5f) * size.x,
+                    m_position.y + (0.5f - screenY / m_viewportHeight) * size.y);
+}
+
+XMMATRIX OrthoCamera::GetViewProjection() const
+{
+    if (m_matrixDirty)
+    {
+        XMFLOAT2 size = GetViewSize();
+        XMMATRIX view = XMMatrixTranslation(-m_position.x, -m_position.y, 0.0f);
+        XMMATRIX projection = XMMatrixOrthographicLH(size.x, size.y, -10.0f, 10.0f);
+        XMStoreFloat4x4(&m_viewProjection, view * projection);
+        m_matrixDirty = false;
+    }
+    return XMLoadFloat4x4(&m_viewProjection);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <DirectXMath.h>
+
+// 2D orthographic camera over the glass scene (world units, y up).
+//
+// At zoom 1 the view shows a reference rectangle fitted to the viewport by the fit
+// mode; zoom divides the visible extent, position is the world point at the center.
+// The view-projection is cached and only rebuilt after something actually changed.
+
+enum CameraFit
+{
+    CameraFit_Width,        // Reference width spans the viewport, height follows its aspect
+    CameraFit_Height,
+    CameraFit_Contain,      // Whole reference rectangle visible
+    CameraFit_COUNT
+};
+
+class OrthoCamera
+{
+public:
+    OrthoCamera();
+
+    void SetViewport(int width, int height);
+    void SetReferenceSize(float width, float height);
+    void SetFit(CameraFit fit);
+    void SetZoom(float zoom);       // Clamped to [MinZoom, MaxZoom]
+    void SetPosition(float x, float y);
+    void Pan(float dx, float dy) { SetPosition(m_position.x + dx, m_position.y + dy); }
+    void PanPixels(float dx, float dy);                 // Screen pixels, y down (mouse drag)
+    void ZoomAt(float factor, float screenX, float screenY);   // Keeps the world point under the pixel in place
+    void Reset();
+
+    CameraFit GetFit() const { return m_fit; }
+    float GetZoom() const { return m_zoom; }
+    const DirectX::XMFLOAT2& GetPosition() const { return m_position; }
+    DirectX::XMFLOAT2 GetViewSize() const;              // Visible world extent
+    float GetPixelsPerUnit() const;
+    DirectX::XMFLOAT2 ScreenToWorld(float screenX, float screenY) const;
+
+    // Row-vector world -> clip transform, not transposed
+    DirectX::XMMATRIX GetViewProjection() const;
+
+    static const float MinZoom;
+    static const float MaxZoom;
+
+private:
+    void Changed() { m_matrixDirty = true; }
+
+private:
+    int m_viewportWidth;
+    int m_viewportHeight;
+    DirectX::XMFLOAT2 m_referenceSize;
+    CameraFit m_fit;
+    float m_zoom;
+    DirectX::XMFLOAT2 m_position;
+
+    mutable DirectX::XMFLOAT4X4 m_viewProjection;
+    mutable bool m_matrixDirty;
+};
@@ -0,0 +1,203 @@
+#include "ParameterTimeline.h"
+#include <math.h>
+#include <string.h>
+
+const char* GetTimelineEasingName(TimelineEasing easing)
+{
+    switch (easing)
+    {
+    case TimelineEasing_Linear: return "Linear";
+    case TimelineEasing_Step: return "Step";
+    case TimelineEasing_EaseIn: return "Ease In";
+    case TimelineEasing_EaseOut: return "Ease Out";
+    case TimelineEasing_EaseInOut: return "Ease In/Out";
+    default: return "?";
+    }
+}
+
+float ApplyTimelineEasing(TimelineEasing easing, float t)
+{
+    switch (easing)
+    {
+    case TimelineEasing_Step: return 0.0f;
+    case TimelineEasing_EaseIn: return t * t;
+    case TimelineEasing_EaseOut: return t * (2.0f - t);
+    case TimelineEasing_EaseInOut: return t * t * (3.0f - 2.0f * t);
+    default: return t;
+    }
+}
+
+ParameterTimeline::ParameterTimeline()
+{
+    m_time = 0.0f;
+    m_playing = false;
+    m_looping = true;
+    m_dirty = false;
+    m_lastChanged = 0;
+}
+
+int ParameterTimeline::AddTrack(const char* name, float* target)
+{
+    m_trackNames.push_back(name);
+    m_targets.push_back(target);
+    m_keyBegin.push_back((int)m_keyTime.size());
+    m_keyCount.push_back(0);
+    m_cursor.push_back(0);
+    return (int)m_targets.size() - 1;
+}
+
+int ParameterTimeline::FindTrack(const char* name) const
+{
+    for (int i = 0; i < (int)m_trackNames.size(); i++)
+        if (strcmp(m_trackNames[i].c_str(), name) == 0)
+            return i;
+    return -1;
+}
+
+void ParameterTimeline::SetKey(int track, float time, float value, TimelineEasing easing)
+{
+    if (track < 0 || track >= (int)m_targets.size())
+        return;
+
+    int begin = m_keyBegin[track];
+    int end = begin + m_keyCount[track];
+    int at = begin;
+    while (at < end && m_keyTime[at] < time)
+        at++;
+    if (at < end && m_keyTime[at] == time)
+    {
+        m_keyValue[at] = value;
+        m_keyEasing[at] = (unsigned char)easing;
+    }
+    else
+    {
+        m_keyTime.insert(m_keyTime.begin() + at, time);
+        m_keyValue.insert(m_keyValue.begin() + at, value);
+        m_keyEasing.insert(m_keyEasing.begin() + at, (unsigned char)easing);
+        m_keyCount[track]++;
+        for (int i = track + 1; i < (int)m_keyBegin.size(); i++)
+            m_keyBegin[i]++;
+    }
+    m_cursor[track] = 0;
+    m_dirty = true;
+}
+
+void ParameterTimeline::SetKeyFromTarget(int track, float time, TimelineEasing easing)
+{
+    if (track >= 0 && track < (int)m_targets.size())
+        SetKey(track, time, *m_targets[track], easing);
+}
+
+void ParameterTimeline::ClearTrack(int track)
+{
+    if (track < 0 || track >= (int)m_targets.size() || m_keyCount[track] == 0)
+        return;
+
+    int begin = m_keyBegin[track];
+    int count = m_keyCount[track];
+    m_keyTime.erase(m_keyTime.begin() + begin, m_keyTime.begin() + begin + count);
+    m_keyValue.erase(m_keyValue.begin() + begin, m_keyValue.begin() + begin + count);
+    m_keyEasing.erase(m_keyEasing.begin() + begin, m_keyEasing.begin() + begin + count);
+    m_keyCount[track] = 0;
+    m_cursor[track] = 0;
+    for (int i = track + 1; i < (int)m_keyBegin.size(); i++)
+        m_keyBegin[i] -= count;
+}
+
+void ParameterTimeline::Clear()
+{
+    m_keyTime.clear();
+    m_keyValue.clear();
+    m_keyEasing.clear();
+    for (int i = 0; i < (int)m_targets.size(); i++)
+    {
+        m_keyBegin[i] = 0;
+        m_keyCount[i] = 0;
+        m_cursor[i] = 0;
+    }
+}
+
+int ParameterTimeline::Evaluate(float time)
+{
+    const float* keyTime = m_keyTime.data();
+    const float* keyValue = m_keyValue.data();
+    const unsigned char* keyEasing = m_keyEasing.data();
+
+    int changed = 0;
+    int trackCount = (int)m_targets.size();
+    for (int track = 0; track < trackCount; track++)
+    {
+        int count = m_keyCount[track];
+        if (count == 0)
+            continue;
+
+        int begin = m_keyBegin[track];
+        int last = begin + count - 1;
+        float value;
+        if (time <= keyTime[begin])
+        {
+            value = keyValue[begin];
+        }
+        else if (time >= keyTime[last])
+        {
+            value = keyValue[last];
+        }
+        else
+        {
+            // Segment [i, i + 1] holding the time, resumed from the previous evaluation
+            int i = begin + m_cursor[track];
+            if (i >= last || keyTime[i] > time)
+                i = begin;
+            while (keyTime[i + 1] <= time)
+                i++;
+            m_cursor[track] = i - begin;
+
+            float t = (time - keyTime[i]) / (keyTime[i + 1] - keyTime[i]);
+            t = ApplyTimelineEasing((TimelineEasing)keyEasing[i], t);
+            value = keyValue[i] + (keyValue[i + 1] - keyValue[i]) * t;
+        }
+
+        float* target = m_targets[track];
+        if (*target != value)
+        {
+            *target = value;
+            changed++;
+        }
+    }
+    m_dirty = false;
+    m_lastChanged = changed;
+    return changed;
+}
+
+int ParameterTimeline::Update(float deltaTime)
+{
+    if (m_playing)
+    {
+        float duration = GetDuration();
+        m_time += deltaTime;
+        if (m_time > duration)
+            m_time = m_looping && duration > 0.0f ? fmodf(m_time, duration) : duration;
+        m_dirty = true;
+    }
+    if (!m_dirty)
+    {
+        m_lastChanged = 0;
+        return 0;
+    }
+    return Evaluate(m_time);
+}
+
+void ParameterTimeline::SetTime(float time)
+{
+    m_time = time < 0.0f ? 0.0f : time;
+    m_dirty = true;
+}
+
+float ParameterTimeline::GetDuration() const
+{
+    float duration = 0.0f;
+    for (int track = 0; track < (int)m_targets.size(); track++)
+        if (m_keyCount[track] > 0 && m_keyTime[m_keyBegin[track] + m_keyCount[track] - 1] > duration)
+            duration = m_keyTime[m_keyBegin[track] + m_keyCount[track] - 1];
+    return duration;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Keyframe animation of float parameters. Each track drives one float the owner
+// registered (a ShaderParams field, the panel size, the blur radius...), keys are
+// stored structure-of-arrays with every track's keys contiguous and sorted by time,
+// so evaluating all tracks is a single forward pass over three flat arrays.
+//
+// A track only writes its target when the value actually changes, Evaluate() reports
+// how many did so the owner can skip constant buffer uploads on still frames.
+
+enum TimelineEasing
+{
+    TimelineEasing_Linear,
+    TimelineEasing_Step,        // Holds the key's value until the next key
+    TimelineEasing_EaseIn,      // Quadratic
+    TimelineEasing_EaseOut,
+    TimelineEasing_EaseInOut,   // Smoothstep
+    TimelineEasing_COUNT
+};
+
+const char* GetTimelineEasingName(TimelineEasing easing);
+float ApplyTimelineEasing(TimelineEasing easing, float t);
+
+class ParameterTimeline
+{
+public:
+    ParameterTimeline();
+
+    // target must outlive the timeline, returns the track index
+    int AddTrack(const char* name, float* target);
+    int FindTrack(const char* name) const;
+    int GetTrackCount() const { return (int)m_trackNames.size(); }
+    const char* GetTrackName(int track) const { return m_trackNames[track].c_str(); }
+    int GetKeyCount(int track) const { return m_keyCount[track]; }
+    int GetTotalKeyCount() const { return (int)m_keyTime.size(); }
+
+    // The easing shapes the segment from this key to the next one. A key at the same time is replaced.
+    void SetKey(int track, float time, float value, TimelineEasing easing = TimelineEasing_Linear);
+    void SetKeyFromTarget(int track, float time, TimelineEasing easing = TimelineEasing_Linear);
+    void ClearTrack(int track);
+    void Clear();
+
+    // Writes every animated track at the given time, returns the number of targets that changed
+    int Evaluate(float time);
+
+    // Playback: advances while playing and evaluates when the time or the keys changed,
+    // so a paused timeline leaves hand edited values alone. Returns Evaluate()'s count.
+    int Update(float deltaTime);
+    float GetTime() const { return m_time; }
+    void SetTime(float time);
+    float GetDuration() const;      // Time of the last key
+    bool IsPlaying() const { return m_playing; }
+    void SetPlaying(bool playing) { m_playing = playing; }
+    bool IsLooping() const { return m_looping; }
+    void SetLooping(bool looping) { m_looping = looping; }
+    int GetLastChangedCount() const { return m_lastChanged; }
+
+private:
+    // Per track
+    std::vector<std::string> m_trackNames;
+    std::vector<float*> m_targets;
+    std::vector<int> m_keyBegin;    // First key in the arrays below
+    std::vector<int> m_keyCount;
+    std::vector<int> m_cursor;      // Segment found last time, playback rarely moves more than one
+
+    // Keys of all tracks, track after track
+    std::vector<float> m_keyTime;
+    std::vector<float> m_keyValue;
+    std::vector<unsigned char> m_keyEasing;
+
+    float m_time;
+    bool m_playing;
+    bool m_looping;
+    bool m_dirty;                   // Time or keys changed since the last evaluation
+    int m_lastChanged;
+};
@@ -0,0 +1,140 @@
+// Liquid Glass example
+// (background_cache_test.cpp)
+// Checks of BackgroundCacheFile::Open() validation: a cache written by WriteBackgroundCache()
+// opens, then copies of it with one field broken at a time must be rejected before anything
+// past the header is read. The .lgbc files are trusted once they open, their mips are handed
+// to the GPU straight out of the mapping, so a mip outside the file is a memory safety bug.
+
+// Build with, e.g:
+//   # cl.exe /nologo /EHsc background_cache_test.cpp BackgroundCache.cpp MappedFile.cpp
+//   # g++ -std=c++11 -Wall background_cache_test.cpp BackgroundCache.cpp MappedFile.cpp -o background_cache_test
+
+// Usage:
+//   background_cache_test.exe
+// Writes and removes background_cache_test.lgbc in the working directory. Prints every failed
+// check and exits with 1 when there is any.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "BackgroundCache.h"
+
+static const char* s_path = "background_cache_test.lgbc";
+static const uint64_t s_sourceHash = 0x0123456789abcdefULL;
+static const uint64_t s_sourceSize = 4096;
+static int s_failures = 0;
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+static void check(bool condition, const char* what, int line)
+{
+    if (condition)
+        return;
+    printf("background_cache_test.cpp(%d): failed %s\n", line, what);
+    s_failures++;
+}
+
+static bool read_file(std::vector<unsigned char>* out_data)
+{
+    FILE* f = fopen(s_path, "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out_data->resize(size > 0 ? (size_t)size : 0);
+    bool ok = size > 0 && fread(out_data->data(), 1, out_data->size(), f) == out_data->size();
+    fclose(f);
+    return ok;
+}
+
+static bool write_file(const std::vector<unsigned char>& data, size_t size)
+{
+    FILE* f = fopen(s_path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(data.data(), 1, size, f) == size;
+    return (fclose(f) == 0) && ok;
+}
+
+static bool open_cache()
+{
+    BackgroundCacheFile cache;
+    return cache.Open(s_path, s_sourceHash, s_sourceSize);
+}
+
+// The valid cache with its header changed by patch
+template <typename Patch>
+static bool open_patched(const std::vector<unsigned char>& valid, Patch patch)
+{
+    std::vector<unsigned char> data = valid;
+    patch(*(BackgroundCacheHeader*)data.data());
+    return write_file(data, data.size()) && open_cache();
+}
+
+int main(int, char**)
+{
+    // 8x4 gradient, 4 mips
+    const int width = 8, height = 4;
+    unsigned char pixels[width * height * 4];
+    for (int i = 0; i < width * height * 4; i++)
+        pixels[i] = (unsigned char)(i * 7);
+    BackgroundMipChain chain;
+    BuildBackgroundMipChain(pixels, width, height, &chain);
+    std::vector<unsigned char> valid;
+    if (!WriteBackgroundCache(s_path, chain, s_sourceHash, s_sourceSize) || !read_file(&valid))
+    {
+        printf("Cannot write %s\n", s_path);
+        return 1;
+    }
+    const uint64_t fileSize = valid.size();
+
+    CHECK(open_cache());
+    {
+        BackgroundCacheFile cache;
+        CHECK(cache.Open(s_path, s_sourceHash, s_sourceSize) && cache.Header().mipCount == 4 &&
+            memcmp(cache.Base() + cache.Header().mips[0].offset, pixels, sizeof(pixels)) == 0);
+        BackgroundCacheFile other;
+        CHECK(!other.Open(s_path, s_sourceHash + 1, s_sourceSize));
+        CHECK(!other.Open(s_path, s_sourceHash, s_sourceSize + 1));
+    }
+
+    // Truncated: into the header, and into the last mip (the file may end in padding)
+    const BackgroundCacheMip& last = ((const BackgroundCacheHeader*)valid.data())->mips[3];
+    CHECK(!(write_file(valid, sizeof(BackgroundCacheHeader) - 1) && open_cache()));
+    CHECK(!(write_file(valid, (size_t)(last.offset + last.size - 1)) && open_cache()));
+    CHECK(write_file(valid, (size_t)(last.offset + last.size)) && open_cache());
+    CHECK(!(write_file(valid, 0) && open_cache()));
+
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.magic++; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.version++; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.format = BackgroundCacheFormat_COUNT; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mipCount = 5; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mipCount = 0; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[1].width++; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[0].size += 16; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[0].offset += 1; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[0].offset = 0; }));
+
+    // Mips past the end of the file, and aligned offsets whose end wraps around to inside it
+    CHECK(!open_patched(valid, [&](BackgroundCacheHeader& h) { h.mips[3].offset = fileSize; }));
+    CHECK(!open_patched(valid, [&](BackgroundCacheHeader& h) { h.mips[0].offset = fileSize - 16; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[0].offset = ~(uint64_t)15; }));
+    CHECK(!open_patched(valid, [](BackgroundCacheHeader& h) { h.mips[0].offset = 0 - (uint64_t)h.mips[0].size + 16; }));
+
+    // The untouched file still opens
+    CHECK(write_file(valid, valid.size()) && open_cache());
+    remove(s_path);
+
+    if (s_failures)
+    {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
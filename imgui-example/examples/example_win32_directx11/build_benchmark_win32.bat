@@ -0,0 +1,8 @@
+@REM Build the headless glass benchmark (glass_benchmark.cpp) for Visual Studio compiler. Run your copy of vcvars32.bat or vcvarsall.bat to setup command-line compiler.
+@set OUT_DIR=Release
+@set OUT_EXE=glass_benchmark
+@set INCLUDES=/I..\.. /I..\..\backends /I "%WindowsSdkDir%Include\um" /I "%WindowsSdkDir%Include\shared" /I "%DXSDK_DIR%Include"
+@set SOURCES=glass_benchmark.cpp AnimatedBackground.cpp BackgroundCache.cpp BlockCompress.cpp ConstantRing.cpp D3D11CommandBackend.cpp D3D11ParallelReplay.cpp FrameProfiler.cpp GlassCommandList.cpp GlassLookupTables.cpp GlassPresets.cpp GlassShapes.cpp LiquidGlass.cpp MappedFile.cpp OrthoCamera.cpp ParameterTimeline.cpp ..\..\backends\imgui_impl_dx11.cpp ..\..\imgui*.cpp
+@set LIBS=/LIBPATH:"%DXSDK_DIR%/Lib/x86" d3d11.lib d3dcompiler.lib user32.lib
+mkdir %OUT_DIR%
+cl /nologo /O2 /MD /utf-8 %INCLUDES% /D UNICODE /D _UNICODE %SOURCES% /Fe%OUT_DIR%/%OUT_EXE%.exe /Fo%OUT_DIR%/ /link %LIBS%
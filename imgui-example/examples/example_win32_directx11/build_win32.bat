@@ -2,7 +2,7 @@
 @set OUT_DIR=Debug
 @set OUT_EXE=example_win32_directx11
 @set INCLUDES=/I..\.. /I..\..\backends /I "%WindowsSdkDir%Include\um" /I "%WindowsSdkDir%Include\shared" /I "%DXSDK_DIR%Include"
-@set SOURCES=main.cpp ..\..\backends\imgui_impl_dx11.cpp ..\..\backends\imgui_impl_win32.cpp ..\..\imgui*.cpp
+@set SOURCES=main.cpp AnimatedBackground.cpp BackgroundCache.cpp BlockCompress.cpp ConstantRing.cpp D3D11CommandBackend.cpp D3D11ParallelReplay.cpp FrameProfiler.cpp GlassCommandList.cpp GlassLookupTables.cpp GlassPresets.cpp GlassShapes.cpp LiquidGlass.cpp MappedFile.cpp OrthoCamera.cpp ParameterTimeline.cpp ..\..\backends\imgui_impl_dx11.cpp ..\..\backends\imgui_impl_win32.cpp ..\..\imgui*.cpp
 @set LIBS=/LIBPATH:"%DXSDK_DIR%/Lib/x86" d3d11.lib d3dcompiler.lib
 mkdir %OUT_DIR%
 cl /nologo /Zi /MD /utf-8 %INCLUDES% /D UNICODE /D _UNICODE %SOURCES% /Fe%OUT_DIR%/%OUT_EXE%.exe /Fo%OUT_DIR%/ /link %LIBS%
@@ -0,0 +1,523 @@
+// Liquid Glass example
+// (glass_benchmark.cpp)
+// Headless benchmark of the glass pipeline: no window and no swap chain, the frame is drawn
+// into an offscreen target exactly like main.cpp draws it (ImGui background image, glass
+// windows, then the glass quad), on the WARP software rasterizer by default so results
+// compare across machines, or on the hardware adapter with -hardware.
+
+// Every configuration runs -warmup frames, then -frames measured frames. Each frame waits
+// for the GPU (event query) so the wall time covers recording and execution; GPU times per
+// pass come from the FrameProfiler. The blur cache is invalidated every frame so the
+// background blur is always paid for. By default each parameter is swept on its own around
+// a baseline, -full runs the whole cartesian product instead. The panels hold still, so
+// temporal reuse is off unless -reuse (reuseRatio: share of the last frame's output reused).
+//
+// Sweeps:
+// - Resolution, panel count and size, blur radius, iterations and downscale.
+// - Shape: every main panel shader variant, compare the "Glass" pass to the superellipse.
+// - Shading rate: the main panel's interior at 1/2 and 1/4 rate ("Glass Interior" plus
+//   "Glass"), shadingSaved is the estimated share of full rate shading saved.
+// - Recording threads, at 4 blur iterations: background, blur and glass passes replayed on
+//   the immediate context (0) or recorded on 1 to 8 threads. "Submit" cpuP50 is the calling
+//   thread's cost. "recordScaling" lists it and the median wall time per thread count, with
+//   their speedup over 0 threads.
+// - Refraction: exact, folded and cubic forms ("Glass" pass), refractionError is the largest
+//   error of the scale shaded with. "refraction" times each form on the CPU beforehand,
+//   refraction_fit_test.cpp checks their errors.
+//
+// Per configuration also: inputBytes (vertex and index data the replayed passes fetch),
+// iaVertices and iaPrimitives (last frame's pipeline statistics, ImGui included), maps
+// (Map/Unmap pairs the glass issued in the last frame).
+
+// Build with build_benchmark_win32.bat, or the same sources in a new project.
+// Run from this directory, it needs shaders/ and pic.jpg like the example.
+
+// Usage:
+//   glass_benchmark.exe [-hardware] [-full] [-reuse] [-frames N] [-warmup N] [-out file.json]
+// Usage example:
+//   # glass_benchmark.exe -frames 60 -out benchmark.json
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "imgui.h"
+#include "imgui_impl_dx11.h"
+#include <d3d11.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "LiquidGlass.h"
+
+struct BenchmarkConfig
+{
+    int width;
+    int height;
+    int panels;             // Glass windows
+    int panelSize;          // Pixels, square
+    float blurRadius;
+    int blurIterations;
+    float blurDownscale;
+    int shape;              // GlassShapeType of the main panel
+    int shadingRate;        // Main panel interior at 1/shadingRate per axis
+    int recordThreads;      // Deferred context recorders, 0: immediate context
+    int refractionMode;     // GlassRefractionMode
+
+    bool operator==(const BenchmarkConfig& other) const
+    {
+        return width == other.width && height == other.height && panels == other.panels && panelSize == other.panelSize &&
+            blurRadius == other.blurRadius && blurIterations == other.blurIterations && blurDownscale == other.blurDownscale &&
+            shape == other.shape && shadingRate == other.shadingRate && recordThreads == other.recordThreads &&
+            refractionMode == other.refractionMode;
+    }
+};
+
+struct BenchmarkTarget
+{
+    ID3D11Texture2D* texture;
+    ID3D11RenderTargetView* rtv;
+};
+
+// One configuration of the recording thread sweep
+struct RecordScalingSample
+{
+    int threads;
+    float submitMs;         // "Submit" cpuP50
+    float wallMs;           // Median
+};
+
+static const int    s_resolutions[][2] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 } };
+static const int    s_panelCounts[] = { 1, 4, 16 };
+static const int    s_panelSizes[] = { 128, 256, 512 };
+static const float  s_blurRadii[] = { 1.0f, 4.0f, 10.0f };
+static const int    s_blurIterations[] = { 1, 2, 4 };
+static const float  s_blurDownscales[] = { 1.0f, 0.5f, 0.25f };
+static const int    s_shapes[] = { GlassShape_Superellipse, GlassShape_Circle, GlassShape_RoundedRect, GlassShape_Capsule };
+static const int    s_shadingRates[] = { 1, 2, 4 };
+static const int    s_recordThreads[] = { 0, 1, 2, 4, 8 };
+static const int    s_refractionModes[] = { GlassRefraction_Exact, GlassRefraction_Folded, GlassRefraction_Cubic };
+static const BenchmarkConfig s_baseline = { 1280, 720, 4, 256, 4.0f, 1, 0.5f, GlassShape_Superellipse, 1, 0, GlassRefraction_Folded };
+
+static void AddConfig(std::vector<BenchmarkConfig>& configs, const BenchmarkConfig& config)
+{
+    if (std::find(configs.begin(), configs.end(), config) == configs.end())
+        configs.push_back(config);
+}
+
+static void BuildConfigs(std::vector<BenchmarkConfig>& configs, bool full)
+{
+    if (full)
+    {
+        for (const int* res : s_resolutions)
+            for (int panels : s_panelCounts)
+                for (int size : s_panelSizes)
+                    for (float radius : s_blurRadii)
+                        for (int iterations : s_blurIterations)
+                            for (float downscale : s_blurDownscales)
+                                for (int shape : s_shapes)
+                                    for (int rate : s_shadingRates)
+                                        for (int threads : s_recordThreads)
+                                            for (int mode : s_refractionModes)
+                                                AddConfig(configs, { res[0], res[1], panels, size, radius, iterations, downscale, shape, rate, threads, mode });
+        return;
+    }
+
+    // One parameter at a time, the others at the baseline
+    AddConfig(configs, s_baseline);
+    BenchmarkConfig config;
+    for (const int* res : s_resolutions)        { config = s_baseline; config.width = res[0]; config.height = res[1]; AddConfig(configs, config); }
+    for (int panels : s_panelCounts)            { config = s_baseline; config.panels = panels; AddConfig(configs, config); }
+    for (int size : s_panelSizes)               { config = s_baseline; config.panelSize = size; AddConfig(configs, config); }
+    for (float radius : s_blurRadii)            { config = s_baseline; config.blurRadius = radius; AddConfig(configs, config); }
+    for (int iterations : s_blurIterations)     { config = s_baseline; config.blurIterations = iterations; AddConfig(configs, config); }
+    for (float downscale : s_blurDownscales)    { config = s_baseline; config.blurDownscale = downscale; AddConfig(configs, config); }
+    for (int shape : s_shapes)                  { config = s_baseline; config.shape = shape; AddConfig(configs, config); }
+    for (int rate : s_shadingRates)             { config = s_baseline; config.shadingRate = rate; AddConfig(configs, config); }
+    for (int threads : s_recordThreads)         { config = s_baseline; config.blurIterations = 4; config.recordThreads = threads; AddConfig(configs, config); }
+    for (int mode : s_refractionModes)          { config = s_baseline; config.refractionMode = mode; AddConfig(configs, config); }
+}
+
+static bool CreateTarget(ID3D11Device* device, int width, int height, BenchmarkTarget& target)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+    target.texture = nullptr;
+    target.rtv = nullptr;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &target.texture)))
+        return false;
+    return SUCCEEDED(device->CreateRenderTargetView(target.texture, nullptr, &target.rtv));
+}
+
+static void ReleaseTarget(BenchmarkTarget& target)
+{
+    if (target.rtv) { target.rtv->Release(); target.rtv = nullptr; }
+    if (target.texture) { target.texture->Release(); target.texture = nullptr; }
+}
+
+static double GetSeconds()
+{
+    static LARGE_INTEGER frequency = {};
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return (double)ticks.QuadPart / (double)frequency.QuadPart;
+}
+
+// Same nearest-rank percentile as FrameProfiler::GetPercentile()
+static float Percentile(std::vector<float> samples, float percentile)
+{
+    if (samples.empty())
+        return 0.0f;
+    int rank = (int)(percentile / 100.0f * (samples.size() - 1) + 0.5f);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+// One frame as main.cpp draws it, into the offscreen target, then waits for the GPU
+static void RenderFrame(LiquidGlass* glass, ID3D11DeviceContext* context, ID3D11Query* done, const BenchmarkTarget& target, const BenchmarkConfig& config)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float)config.width, (float)config.height);
+    io.DeltaTime = 1.0f / 60.0f;
+    ImGui_ImplDX11_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
+    ImGui::Begin("Background", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize |
+        ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoBackground);
+    if (ID3D11ShaderResourceView* background = glass->GetCurrentBackgroundTexture())
+        ImGui::Image((void*)background, io.DisplaySize);
+    ImGui::End();
+    ImGui::PopStyleVar();
+
+    // Panels on a grid, overlapping (and re-snapshotting the scene) only when they don't fit
+    int columns = (int)ceilf(sqrtf((float)config.panels));
+    int rows = (config.panels + columns - 1) / columns;
+    float stepX = columns > 1 ? min((float)config.panelSize + 8.0f, (float)(config.width - config.panelSize) / (columns - 1)) : 0.0f;
+    float stepY = rows > 1 ? min((float)config.panelSize + 8.0f, (float)(config.height - config.panelSize) / (rows - 1)) : 0.0f;
+    for (int i = 0; i < config.panels; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "Panel %d", i);
+        ImGui::SetNextWindowPos(ImVec2((i % columns) * max(stepX, 0.0f), (i / columns) * max(stepY, 0.0f)));
+        ImGui::SetNextWindowSize(ImVec2((float)config.panelSize, (float)config.panelSize));
+        if (glass->BeginGlassWindow(name, nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings))
+            ImGui::Text("Panel %d", i);
+        ImGui::End();
+    }
+
+    glass->Update(io.DeltaTime);
+    ImGui::Render();
+
+    FrameProfiler& profiler = glass->GetProfiler();
+    profiler.BeginFrame(context);
+    const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    context->OMSetRenderTargets(1, &target.rtv, nullptr);
+    context->ClearRenderTargetView(target.rtv, clearColor);
+    int scope = profiler.BeginScope(context, "ImGui");
+    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    profiler.EndScope(context, scope);
+    glass->InvalidateBlurCache();
+    glass->Render(target.rtv);
+    profiler.EndFrame(context);
+
+    context->End(done);
+    while (context->GetData(done, nullptr, 0, 0) == S_FALSE)
+        ;
+}
+
+// FitRefraction() over a grid of the refraction sliders, then the CPU time of every form
+// evaluated over the grid, 256 distances each (the glass sees 0..1, past it the scale has
+// settled). refraction_fit_test.cpp checks their errors.
+static void WriteRefractionSweep(FILE* f)
+{
+    const float as[] = { 0.0f, 0.45f, 1.0f, 2.5f, 5.0f };
+    const float bs[] = { 0.5f, 1.0f, 2.3f, 4.0f, 6.0f };
+    const float cs[] = { 0.25f, 1.0f, 3.5f, 6.0f };
+    const float ds[] = { 0.5f, 3.3f, 10.0f };
+    const float powers[] = { -1.5f, 0.5f, 1.7f, 3.0f, 6.0f };
+    struct Sample
+    {
+        float a, b, c, d, power;
+        RefractionFit fit;
+    };
+    std::vector<Sample> samples;
+    for (float a : as)
+        for (float b : bs)
+            for (float c : cs)
+                for (float d : ds)
+                    for (float power : powers)
+                    {
+                        Sample sample = { a, b, c, d, power };
+                        FitRefraction(a, b, c, d, power, sample.fit);
+                        samples.push_back(sample);
+                    }
+
+    const int distances = 256;
+    double ns[3];
+    volatile float sink = 0.0f;
+    for (int mode = 0; mode < 3; mode++)
+    {
+        float sum = 0.0f;
+        double start = GetSeconds();
+        for (const Sample& s : samples)
+        {
+            for (int i = 0; i < distances; i++)
+            {
+                float x = (float)i / distances;
+                if (mode == GlassRefraction_Exact)
+                    sum += RefractionScaleExact(s.a, s.b, s.c, s.d, s.power, x);
+                else if (mode == GlassRefraction_Folded)
+                    sum += RefractionScaleFolded(s.fit, s.power, x);
+                else
+                    sum += RefractionScaleCubic(s.fit, x);
+            }
+        }
+        ns[mode] = (GetSeconds() - start) * 1e9 / ((double)samples.size() * distances);
+        sink = sink + sum;
+    }
+
+    fprintf(f, "  \"refraction\": { \"fits\": %d, \"exactNs\": %.2f, \"foldedNs\": %.2f, \"cubicNs\": %.2f },\n", (int)samples.size(), ns[0], ns[1], ns[2]);
+}
+
+// The recording thread sweep against the immediate context: how much each thread count
+// speeds up the calling thread's submission and the whole frame
+static void WriteRecordScaling(FILE* f, const std::vector<RecordScalingSample>& samples)
+{
+    const RecordScalingSample* immediate = nullptr;
+    for (const RecordScalingSample& sample : samples)
+        if (sample.threads == 0)
+            immediate = &sample;
+    fprintf(f, "  \"recordScaling\": [");
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        const RecordScalingSample& sample = samples[i];
+        float submitSpeedup = immediate && sample.submitMs > 0.0f ? immediate->submitMs / sample.submitMs : 0.0f;
+        float wallSpeedup = immediate && sample.wallMs > 0.0f ? immediate->wallMs / sample.wallMs : 0.0f;
+        fprintf(f, "%s\n    { \"threads\": %d, \"submitCpuP50\": %.4f, \"wallP50\": %.4f, \"submitSpeedup\": %.3f, \"wallSpeedup\": %.3f }",
+            i > 0 ? "," : "", sample.threads, sample.submitMs, sample.wallMs, submitSpeedup, wallSpeedup);
+    }
+    fprintf(f, "\n  ]\n");
+}
+
+static void WriteTimings(FILE* f, const char* name, const std::vector<float>& samples)
+{
+    fprintf(f, "\"%s\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f }", name,
+        Percentile(samples, 50.0f), Percentile(samples, 95.0f), Percentile(samples, 99.0f));
+}
+
+int main(int argc, char** argv)
+{
+    bool hardware = false;
+    bool full = false;
+    bool reuse = false;
+    int frames = 120;
+    int warmup = 10;
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-hardware") == 0)
+            hardware = true;
+        else if (strcmp(argv[i], "-full") == 0)
+            full = true;
+        else if (strcmp(argv[i], "-reuse") == 0)
+            reuse = true;
+        else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-warmup") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: glass_benchmark.exe [-hardware] [-full] [-reuse] [-frames N] [-warmup N] [-out file.json]\n");
+            return 1;
+        }
+    }
+    // The profiler only keeps HistorySize samples per pass
+    frames = max(1, min(frames, (int)FrameProfiler::HistorySize));
+    warmup = max(0, warmup);
+
+    ID3D11Device* device = nullptr;
+    ID3D11DeviceContext* context = nullptr;
+    D3D_FEATURE_LEVEL featureLevel;
+    const D3D_FEATURE_LEVEL featureLevelArray[2] = { D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_10_0, };
+    if (FAILED(D3D11CreateDevice(nullptr, hardware ? D3D_DRIVER_TYPE_HARDWARE : D3D_DRIVER_TYPE_WARP, nullptr, 0, featureLevelArray, 2,
+        D3D11_SDK_VERSION, &device, &featureLevel, &context)))
+    {
+        fprintf(stderr, "Failed to create the %s device\n", hardware ? "hardware" : "WARP");
+        return 1;
+    }
+
+    ID3D11Query* done = nullptr;
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+    device->CreateQuery(&queryDesc, &done);
+    ID3D11Query* statisticsQuery = nullptr;
+    queryDesc.Query = D3D11_QUERY_PIPELINE_STATISTICS;
+    device->CreateQuery(&queryDesc, &statisticsQuery);
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+    ImGui_ImplDX11_Init(device, context);
+
+    std::vector<BenchmarkConfig> configs;
+    BuildConfigs(configs, full);
+
+    BenchmarkTarget target = { nullptr, nullptr };
+    LiquidGlass* glass = new LiquidGlass();
+    if (!done || !CreateTarget(device, s_baseline.width, s_baseline.height, target) ||
+        !glass->Initialize(device, context, s_baseline.width, s_baseline.height))
+    {
+        fprintf(stderr, "Failed to initialize, run from the example directory (shaders/, pic.jpg)\n");
+        delete glass;
+        ReleaseTarget(target);
+        ImGui_ImplDX11_Shutdown();
+        ImGui::DestroyContext();
+        if (done) done->Release();
+        if (statisticsQuery) statisticsQuery->Release();
+        context->Release();
+        device->Release();
+        return 1;
+    }
+
+    FILE* f = outPath ? fopen(outPath, "wt") : stdout;
+    if (!f)
+    {
+        fprintf(stderr, "Cannot write %s\n", outPath);
+        f = stdout;
+    }
+    fprintf(f, "{\n  \"driver\": \"%s\",\n  \"frames\": %d,\n  \"warmup\": %d,\n", hardware ? "hardware" : "warp", frames, warmup);
+    WriteRefractionSweep(f);
+    fprintf(f, "  \"results\": [\n");
+
+    FrameProfiler& profiler = glass->GetProfiler();
+    int targetWidth = s_baseline.width, targetHeight = s_baseline.height;
+    BenchmarkConfig scalingBaseline = s_baseline;
+    scalingBaseline.blurIterations = 4;
+    std::vector<RecordScalingSample> scaling;
+    for (size_t c = 0; c < configs.size(); c++)
+    {
+        const BenchmarkConfig& config = configs[c];
+        fprintf(stderr, "[%d/%d] %dx%d, %d x %dpx panels, blur radius %g x%d at %g, %s at 1/%d, %d recording threads, refraction mode %d\n",
+            (int)c + 1, (int)configs.size(), config.width, config.height, config.panels, config.panelSize, config.blurRadius, config.blurIterations,
+            config.blurDownscale, GlassShapeNames[config.shape], config.shadingRate, config.recordThreads, config.refractionMode);
+
+        GlassPreset preset;
+        glass->CapturePreset(preset);
+        preset.blurRadius = config.blurRadius;
+        preset.blurIterations = (float)config.blurIterations;
+        preset.blurDownscale = config.blurDownscale;
+        glass->ApplyPreset(preset);
+        glass->SetShape((GlassShapeType)config.shape);
+        glass->SetShadingRate(config.shadingRate);
+        glass->SetTemporalReuse(reuse);
+        glass->SetRecordThreads(config.recordThreads);
+        glass->SetRefractionMode((GlassRefractionMode)config.refractionMode);
+        if (config.width != targetWidth || config.height != targetHeight)
+        {
+            ReleaseTarget(target);
+            if (!CreateTarget(device, config.width, config.height, target))
+            {
+                fprintf(stderr, "Failed to create a %dx%d target\n", config.width, config.height);
+                break;
+            }
+            targetWidth = config.width;
+            targetHeight = config.height;
+        }
+        glass->OnResize(config.width, config.height);   // Blur targets follow the downscale
+
+        for (int i = 0; i < warmup; i++)
+            RenderFrame(glass, context, done, target, config);
+        profiler.Flush(context);
+        profiler.ResetHistory();
+
+        std::vector<float> wallMs;
+        D3D11_QUERY_DATA_PIPELINE_STATISTICS statistics = {};
+        for (int i = 0; i < frames; i++)
+        {
+            bool last = i == frames - 1 && statisticsQuery;
+            if (last)
+                context->Begin(statisticsQuery);
+            double start = GetSeconds();
+            RenderFrame(glass, context, done, target, config);
+            wallMs.push_back((float)((GetSeconds() - start) * 1000.0));
+            if (last)
+            {
+                context->End(statisticsQuery);
+                while (context->GetData(statisticsQuery, &statistics, sizeof(statistics), 0) == S_FALSE)
+                    ;
+            }
+        }
+        profiler.Flush(context);
+
+        // Output pixels, and the pixels actually shaded as glass (panels plus their blur)
+        float medianMs = max(Percentile(wallMs, 50.0f), 0.001f);
+        double framePixels = (double)config.width * config.height;
+        double glassPixels = (double)config.panels * config.panelSize * config.panelSize;
+        fprintf(f, "%s    {\n      \"width\": %d, \"height\": %d, \"panels\": %d, \"panelSize\": %d, \"blurRadius\": %g, \"blurIterations\": %d, \"blurDownscale\": %g, \"shape\": \"%s\",\n",
+            c > 0 ? ",\n" : "", config.width, config.height, config.panels, config.panelSize, config.blurRadius, config.blurIterations, config.blurDownscale,
+            GlassShapeNames[config.shape]);
+        fprintf(f, "      \"shadingRate\": %d, \"shadingSaved\": %.4f, \"reuseRatio\": %.4f, \"recordThreads\": %d,\n", config.shadingRate,
+            glass->GetShadingRateSaved(), glass->GetTemporalReuseRatio(), glass->GetRecordThreads());
+        fprintf(f, "      \"snapshots\": %d, \"inputBytes\": %d, \"iaVertices\": %llu, \"iaPrimitives\": %llu, \"maps\": %d,\n", glass->GetLastGlassStats().snapshots,
+            glass->GetLastReplayStats().inputBytes, (unsigned long long)statistics.IAVertices, (unsigned long long)statistics.IAPrimitives,
+            glass->GetLastFrameMaps());
+        fprintf(f, "      \"blurArea\": %.4f, \"sceneBlurArea\": %.4f, \"refractionMode\": %d, \"refractionError\": %g,\n      ", glass->GetBlurArea(),
+            glass->GetSceneBlurArea(), config.refractionMode, glass->GetRefractionError());
+        WriteTimings(f, "wallMs", wallMs);
+        fprintf(f, ",\n      \"mpixelsPerSec\": %.2f, \"glassMpixelsPerSec\": %.2f,\n", framePixels / medianMs / 1000.0, glassPixels / medianMs / 1000.0);
+        fprintf(f, "      \"droppedFrames\": %d,\n      \"passes\": {", profiler.GetDroppedFrames());
+        bool first = true;
+        for (int pass = 0; pass < profiler.GetPassCount(); pass++)
+        {
+            if (profiler.GetSampleCount(pass) == 0)
+                continue;
+            fprintf(f, "%s\n        \"%s\": { \"cpuP50\": %.4f, \"gpuP50\": %.4f, \"gpuP95\": %.4f, \"gpuP99\": %.4f }", first ? "" : ",",
+                profiler.GetPassName(pass), profiler.GetPercentile(pass, false, 50.0f),
+                profiler.GetPercentile(pass, true, 50.0f), profiler.GetPercentile(pass, true, 95.0f), profiler.GetPercentile(pass, true, 99.0f));
+            first = false;
+        }
+        fprintf(f, "\n      }\n    }");
+
+        // Part of the recording thread sweep, unless the deferred contexts failed to create
+        BenchmarkConfig unthreaded = config;
+        unthreaded.recordThreads = 0;
+        if (unthreaded == scalingBaseline && glass->GetRecordThreads() == config.recordThreads)
+        {
+            RecordScalingSample sample = { config.recordThreads, 0.0f, medianMs };
+            for (int pass = 0; pass < profiler.GetPassCount(); pass++)
+                if (strcmp(profiler.GetPassName(pass), "Submit") == 0)
+                    sample.submitMs = profiler.GetPercentile(pass, false, 50.0f);
+            scaling.push_back(sample);
+        }
+    }
+    fprintf(f, "\n  ],\n");
+    WriteRecordScaling(f, scaling);
+    fprintf(f, "}\n");
+    if (f != stdout)
+        fclose(f);
+
+    delete glass;
+    ReleaseTarget(target);
+    ImGui_ImplDX11_Shutdown();
+    ImGui::DestroyContext();
+    done->Release();
+    if (statisticsQuery) statisticsQuery->Release();
+    context->Release();
+    device->Release();
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Liquid Glass example
+// (glass_command_list_test.cpp)
+// Checks of GlassCommandList and GlassCommandBackend against a mock backend: the state a replay
+// binds or skips, constant uploads remembered across replays and dropped by ForgetUploads(),
+// constants read when replayed, and how GetPasses() splits a list. No graphics API needed,
+// the handles are plain addresses.
+
+// Build with, e.g:
+//   # cl.exe /nologo /EHsc glass_command_list_test.cpp GlassCommandList.cpp
+//   # g++ -std=c++11 -Wall glass_command_list_test.cpp GlassCommandList.cpp -o glass_command_list_test
+
+// Usage:
+//   glass_command_list_test.exe
+// Prints every failed check and exits with 1 when there is any.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "GlassCommandList.h"
+
+static int s_failures = 0;
+
+#define CHECK_EQUAL(actual, expected) check_equal((long long)(actual), (long long)(expected), #actual, __LINE__)
+
+static void check_equal(long long actual, long long expected, const char* what, int line)
+{
+    if (actual == expected)
+        return;
+    printf("glass_command_list_test.cpp(%d): %s is %lld, expected %lld\n", line, what, actual, expected);
+    s_failures++;
+}
+
+// Counts what reaches the API
+class MockBackend : public GlassCommandBackend
+{
+public:
+    int bindings;       // Every Apply* that binds state
+    int uploads;
+    int draws;
+    int scopes;
+
+    MockBackend() { bindings = uploads = draws = scopes = 0; }
+
+protected:
+    void ApplyTargets(int, const GlassHandle*) override { bindings++; }
+    void ApplyClear(GlassHandle, const float[4]) override {}
+    void ApplyViewport(float, float) override { bindings++; }
+    void ApplyScissor(const float[4]) override { bindings++; }
+    void ApplyInputLayout(GlassHandle) override { bindings++; }
+    void ApplyVertexShader(GlassHandle) override { bindings++; }
+    void ApplyPixelShader(GlassHandle) override { bindings++; }
+    void ApplyBlendState(GlassHandle) override { bindings++; }
+    void ApplyDepthStencilState(GlassHandle) override { bindings++; }
+    void ApplyRasterizerState(GlassHandle) override { bindings++; }
+    void ApplyTexture(int, GlassHandle) override { bindings++; }
+    void ApplySampler(int, GlassHandle) override { bindings++; }
+    void ApplyConstants(GlassShaderStage, int, GlassHandle) override { bindings++; }
+    void ApplyConstantRange(GlassShaderStage, int, GlassHandle) override { bindings++; }
+    void ApplyUpload(GlassHandle, const void*, size_t) override { uploads++; }
+    void ApplyGeometry(GlassHandle, int, GlassHandle) override { bindings++; }
+    void ApplyDraw(int) override { draws++; }
+    void ApplyDrawIndexed(int) override { draws++; }
+    void ApplyBeginScope(const char*) override { scopes++; }
+    void ApplyEndScope() override {}
+};
+
+// Stand-ins for API objects, only their addresses matter
+static int s_objects[16];
+#define HANDLE(i) ((GlassHandle)&s_objects[i])
+
+// Two blur-like passes: the same pipeline, sampler, viewport and constants into two targets,
+// each reading the other's output. The constants are written before the first scope.
+static void record_two_passes(GlassCommandList& list, size_t* secondPass)
+{
+    const float constants[4] = { 1.0f, 0.0f, 0.5f, 0.5f };
+    GlassPipeline pipeline = { nullptr, HANDLE(0), HANDLE(1), nullptr, HANDLE(2), HANDLE(3) };
+
+    list.UpdateConstants(HANDLE(4), constants, sizeof(constants));
+    list.BeginScope("First");
+    list.SetTargets(HANDLE(5));
+    list.SetViewport(640.0f, 360.0f);
+    list.SetPipeline(pipeline);
+    list.BindSampler(0, HANDLE(6));
+    list.BindConstants(GlassStage_Pixel, 0, HANDLE(4));
+    list.BindTexture(0, HANDLE(7));
+    list.SetGeometry(nullptr, 0, nullptr);
+    list.Draw(3);
+    list.EndScope();
+
+    *secondPass = list.GetCommands().size();
+    list.BeginScope("Second");
+    list.SetTargets(HANDLE(7));
+    list.SetViewport(640.0f, 360.0f);
+    list.SetPipeline(pipeline);
+    list.BindSampler(0, HANDLE(6));
+    list.BindConstants(GlassStage_Pixel, 0, HANDLE(4));
+    list.BindTexture(0, HANDLE(5));
+    list.SetGeometry(nullptr, 0, nullptr);
+    list.BeginScope("Nested");     // Inside the pass, no pass of its own
+    list.Draw(3);
+    list.EndScope();
+    list.EndScope();
+    list.BindTexture(0, nullptr);  // After the last scope, still the second pass
+}
+
+static void test_replay()
+{
+    GlassCommandList list;
+    size_t secondPass;
+    record_two_passes(list, &secondPass);
+    MockBackend backend;
+
+    // First pass: targets, viewport, the pipeline's 6 handles, sampler, constants, texture and
+    // geometry all change. Second pass: targets and texture change, the texture because new
+    // targets forget the textures; viewport, 6 pipeline handles, sampler, constants and
+    // geometry repeat. The trailing unbind changes the texture again.
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().replays, 1);
+    CHECK_EQUAL(backend.GetStats().commands, (int)list.GetCommands().size());
+    CHECK_EQUAL(backend.GetStats().stateChanges, 12 + 3);
+    CHECK_EQUAL(backend.GetStats().redundant, 10);
+    CHECK_EQUAL(backend.GetStats().uploads, 1);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 0);
+    CHECK_EQUAL(backend.GetStats().inputBytes, 0);     // Vertex-less draws
+    CHECK_EQUAL(backend.bindings, backend.GetStats().stateChanges);
+    CHECK_EQUAL(backend.uploads, 1);
+    CHECK_EQUAL(backend.draws, 2);
+    CHECK_EQUAL(backend.scopes, 3);
+
+    // Bound state is forgotten between replays, the uploaded contents are not
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().replays, 2);
+    CHECK_EQUAL(backend.GetStats().stateChanges, 2 * (12 + 3));
+    CHECK_EQUAL(backend.GetStats().redundant, 2 * 10);
+    CHECK_EQUAL(backend.GetStats().uploads, 1);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 1);
+    CHECK_EQUAL(backend.uploads, 1);
+
+    // Until another backend may have written the buffer
+    backend.ForgetUploads();
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().uploads, 2);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 1);
+    CHECK_EQUAL(backend.uploads, 2);
+
+    backend.ResetStats();
+    CHECK_EQUAL(backend.GetStats().replays, 0);
+    CHECK_EQUAL(backend.GetStats().stateChanges, 0);
+
+    // The second pass on its own binds everything it draws with and uploads nothing, the
+    // constants are written by the first pass
+    backend.Replay(list, secondPass, list.GetCommands().size());
+    CHECK_EQUAL(backend.GetStats().stateChanges, 12 + 1);
+    CHECK_EQUAL(backend.GetStats().redundant, 0);
+    CHECK_EQUAL(backend.GetStats().uploads + backend.GetStats().uploadSkips, 0);
+}
+
+static void test_passes()
+{
+    GlassCommandList list;
+    std::vector<size_t> passes;
+    list.GetPasses(passes);
+    CHECK_EQUAL(passes.size(), 0);
+
+    // Commands before the first scope belong to the first pass, nested scopes and commands
+    // after a scope to the pass they follow
+    size_t secondPass;
+    record_two_passes(list, &secondPass);
+    list.GetPasses(passes);
+    CHECK_EQUAL(passes.size(), 2);
+    if (passes.size() == 2)
+    {
+        CHECK_EQUAL(passes[0], 0);
+        CHECK_EQUAL(passes[1], secondPass);
+    }
+
+    // A list without scopes is one pass
+    GlassCommandList flat;
+    flat.SetTargets(HANDLE(5));
+    flat.Draw(3);
+    flat.GetPasses(passes);
+    CHECK_EQUAL(passes.size(), 1);
+
+    list.Clear();
+    CHECK_EQUAL(list.IsEmpty(), true);
+}
+
+static void test_redundant_state()
+{
+    GlassCommandList list;
+    const float constants[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    list.SetTargets(HANDLE(5), HANDLE(7));
+    list.SetTargets(HANDLE(5), HANDLE(7));     // Same targets
+    list.SetTargets(HANDLE(5));                 // Fewer targets is a change
+    list.SetScissor(0, 0, 64, 32);
+    list.SetScissor(0, 0, 64, 32);
+    list.SetScissor(0, 0, 64, 33);
+    list.BindConstants(GlassStage_Vertex | GlassStage_Pixel, 1, HANDLE(4));    // Two bindings
+    list.BindConstants(GlassStage_Pixel, 1, HANDLE(4));
+    list.UpdateConstants(HANDLE(4), constants, sizeof(constants));
+    list.UpdateConstants(HANDLE(4), constants, sizeof(constants));             // Same contents
+    list.UpdateConstants(HANDLE(8), constants, sizeof(constants));             // Other buffer
+    list.SetGeometry(HANDLE(9), 8, HANDLE(10));
+    list.DrawIndexed(6);
+
+    MockBackend backend;
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().stateChanges, 2 + 2 + 2 + 1);
+    CHECK_EQUAL(backend.GetStats().redundant, 1 + 1 + 1);
+    CHECK_EQUAL(backend.GetStats().uploads, 2);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 1);
+    CHECK_EQUAL(backend.GetStats().inputBytes, 6 * (8 + (int)sizeof(GlassIndex)));
+    CHECK_EQUAL(backend.bindings, backend.GetStats().stateChanges);
+}
+
+// UpdateConstantsFrom() reads its source when replayed, the list is recorded once
+static void test_constants_from()
+{
+    float constants[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    GlassCommandList list;
+    list.UpdateConstantsFrom(HANDLE(4), constants, sizeof(constants));
+    list.BindConstants(GlassStage_Pixel, 0, HANDLE(4));
+    list.Draw(3);
+
+    MockBackend backend;
+    backend.Replay(list);
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().uploads, 1);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 1);
+
+    constants[2] = 5.0f;
+    backend.Replay(list);
+    CHECK_EQUAL(backend.GetStats().uploads, 2);
+    CHECK_EQUAL(backend.uploads, 2);
+
+    // Shares what it remembers with UpdateConstants() of the same buffer
+    GlassCommandList copy;
+    copy.UpdateConstants(HANDLE(4), constants, sizeof(constants));
+    backend.Replay(copy);
+    CHECK_EQUAL(backend.GetStats().uploads, 2);
+    CHECK_EQUAL(backend.GetStats().uploadSkips, 2);
+}
+
+int main(int, char**)
+{
+    test_replay();
+    test_passes();
+    test_redundant_state();
+    test_constants_from();
+    if (s_failures)
+    {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -162,10 +162,10 @@ int main(int, char**)
                 ImGuiWindowFlags_NoBringToFrontOnFocus |
                 ImGuiWindowFlags_NoBackground);
             
-            auto& backgrounds = g_pLiquidGlass->GetBackgrounds();
-            if (!backgrounds.empty())
+            ID3D11ShaderResourceView* background = g_pLiquidGlass->GetCurrentBackgroundTexture();
+            if (background)
             {
-                ImGui::Image((void*)backgrounds[0].texture, ImGui::GetIO().DisplaySize);
+                ImGui::Image((void*)background, ImGui::GetIO().DisplaySize);
             }
             
             ImGui::End();
@@ -209,7 +209,10 @@ int main(int, char**)
         // 3. Show another simple window.
         if (show_another_window)
         {
-            ImGui::Begin("Another Window", &show_another_window);   // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
+            if (g_pLiquidGlass)
+                g_pLiquidGlass->BeginGlassWindow("Another Window", &show_another_window);   // Same as ImGui::Begin() but drawn over liquid glass
+            else
+                ImGui::Begin("Another Window", &show_another_window);   // Pass a pointer to our bool variable (the window will have a closing button that will clear the bool when clicked)
             ImGui::Text("Hello from another window!");
             if (ImGui::Button("Close Me"))
                 show_another_window = false;
@@ -229,14 +232,23 @@ int main(int, char**)
         g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView, nullptr);
         g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView, clear_color_with_alpha);
         
+        FrameProfiler* profiler = g_pLiquidGlass ? &g_pLiquidGlass->GetProfiler() : nullptr;
+        if (profiler)
+            profiler->BeginFrame(g_pd3dDeviceContext);
+
         // STEP 1: Draw ImGui first (includes fullscreen background image)
+        int imguiScope = profiler ? profiler->BeginScope(g_pd3dDeviceContext, "ImGui") : -1;
         ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+        if (profiler)
+            profiler->EndScope(g_pd3dDeviceContext, imguiScope);
         
         // STEP 2: Draw Liquid Glass effect on top of ImGui background
         if (show_liquid_glass && g_pLiquidGlass)
         {
             g_pLiquidGlass->Render(g_mainRenderTargetView);
         }
+        if (profiler)
+            profiler->EndFrame(g_pd3dDeviceContext);
 
         // Present
         HRESULT hr = g_pSwapChain->Present(1, 0);   // Present with vsync
@@ -0,0 +1,154 @@
+// Liquid Glass example
+// (refraction_fit_test.cpp)
+// Checks of FitRefraction() and the shader's refraction forms against the exact scale computed
+// in double, over a grid of the refraction sliders' ranges: the errors stay within the bounds
+// GlassLookupTables.h documents, and within the errors the fit reports (the settings window
+// shows them and the panel reach is padded by them), sampled more densely than the fit does.
+
+// Build with, e.g:
+//   # cl.exe /nologo /EHsc /O2 refraction_fit_test.cpp GlassLookupTables.cpp
+//   # g++ -std=c++11 -O2 -Wall refraction_fit_test.cpp GlassLookupTables.cpp -o refraction_fit_test
+
+// Usage:
+//   refraction_fit_test.exe
+// Prints every failed check and exits with 1 when there is any.
+
+#include <math.h>
+#include <stdio.h>
+#include "GlassLookupTables.h"
+
+// The bounds GlassLookupTables.h documents, where the refraction stays positive
+static const double FoldedBound = 2e-5;
+static const double CubicDefaultBound = 1e-3;      // At the default refraction
+static const double CubicBound = 2e-3;             // 1 - weight >= 0.25, power 0..3
+
+// Slack over the error the fit reports, for the samples it skips
+static const double ReportedSlack = 1e-5;
+
+static int s_failures = 0;
+
+#define CHECK_BELOW(value, bound, a, b, c, d, power) check_below(value, bound, #value, a, b, c, d, power, __LINE__)
+
+static void check_below(double value, double bound, const char* what, float a, float b, float c, float d, float power, int line)
+{
+    if (value <= bound)
+        return;
+    printf("refraction_fit_test.cpp(%d): %s is %g, above %g (a %g, b %g, c %g, d %g, power %g)\n", line, what, value, bound, a, b, c, d, power);
+    s_failures++;
+}
+
+static double exact_scale(double a, double b, double c, double d, double power, double x)
+{
+    double refraction = 1.0 - b * pow(c * 2.718281828459045, -d * x - a);
+    return refraction > 0.0 ? pow(refraction, power) : 0.0;
+}
+
+// NaN counts as the largest error
+static double worst(double error, double sample)
+{
+    return sample > error || sample != sample ? sample : error;
+}
+
+// Largest errors of the folded and cubic forms, relative past a scale of 1, over 4096 t
+// between the fit's samples (x in 0..8 for a flat t) and x in 0..1, where the glass samples it
+static void measure_errors(float a, float b, float c, float d, float power, const RefractionFit& fit, double* out_folded, double* out_cubic)
+{
+    const int samples = 4096;
+    double folded = 0.0, cubic = 0.0;
+    for (int i = 0; i < 2 * samples; i++)
+    {
+        double x = (double)(i - samples) / (samples - 1);
+        if (i < samples)
+            x = fit.slope < 0.0f ? log2((i + 0.5) / samples) / fit.slope : 8.0 * i / (samples - 1);
+        double exact = exact_scale(a, b, c, d, power, x);
+        double range = fmax(exact, 1.0);
+        folded = worst(folded, fabs(RefractionScaleFolded(fit, power, (float)x) - exact) / range);
+        cubic = worst(cubic, fabs(RefractionScaleCubic(fit, (float)x) - exact) / range);
+    }
+    *out_folded = folded;
+    *out_cubic = cubic;
+}
+
+static void test_default()
+{
+    const float a = 0.45f, b = 2.3f, c = 3.5f, d = 3.3f, power = 1.7f;
+    RefractionFit fit;
+    FitRefraction(a, b, c, d, power, fit);
+    if (!fit.cubicValid)
+    {
+        printf("refraction_fit_test.cpp(%d): no cubic fit at the default refraction\n", __LINE__);
+        s_failures++;
+        return;
+    }
+    double folded, cubic;
+    measure_errors(a, b, c, d, power, fit, &folded, &cubic);
+    CHECK_BELOW(folded, FoldedBound, a, b, c, d, power);
+    CHECK_BELOW(cubic, CubicDefaultBound, a, b, c, d, power);
+    CHECK_BELOW(fit.cubicError, CubicDefaultBound, a, b, c, d, power);
+
+    // The cubic interpolates the scale at the edge (t = 1) and deep inside (t = 0)
+    CHECK_BELOW(fabs(RefractionScaleCubic(fit, 0.0f) - exact_scale(a, b, c, d, power, 0.0)), 1e-5, a, b, c, d, power);
+    CHECK_BELOW(fabs(RefractionScaleCubic(fit, 100.0f) - exact_scale(a, b, c, d, power, 100.0)), 1e-5, a, b, c, d, power);
+}
+
+static void test_sweep()
+{
+    const float as[] = { 0.0f, 0.45f, 1.0f, 2.5f, 5.0f };
+    const float bs[] = { 0.0f, 0.5f, 1.0f, 2.3f, 4.0f, 6.0f };
+    const float cs[] = { 0.05f, 0.25f, 1.0f, 3.5f, 6.0f };  // (c*e)^-a is undefined at c = 0
+    const float ds[] = { 0.0f, 0.5f, 3.3f, 10.0f };
+    const float powers[] = { -1.5f, 0.0f, 0.5f, 1.7f, 3.0f, 6.0f };
+    int positive = 0, bounded = 0;
+    for (float a : as)
+        for (float b : bs)
+            for (float c : cs)
+                for (float d : ds)
+                    for (float power : powers)
+                    {
+                        RefractionFit fit;
+                        FitRefraction(a, b, c, d, power, fit);
+
+                        // The cubic needs t in (0, 1]
+                        if (fit.cubicValid != (fit.slope <= 0.0f) || (!fit.cubicValid && !isinf(fit.cubicError)))
+                        {
+                            printf("refraction_fit_test.cpp(%d): cubicValid %d with slope %g, cubicError %g\n", __LINE__, (int)fit.cubicValid, fit.slope, fit.cubicError);
+                            s_failures++;
+                        }
+
+                        // Past weight 1 or with a rising t the refraction reaches 0 inside the
+                        // glass: no bound holds at the pole or kink
+                        if (!(fit.weight < 1.0f && fit.slope <= 0.0f))
+                            continue;
+                        positive++;
+                        double folded, cubic;
+                        measure_errors(a, b, c, d, power, fit, &folded, &cubic);
+                        CHECK_BELOW(folded, FoldedBound, a, b, c, d, power);
+                        CHECK_BELOW(folded, fit.foldedError * (1.0 + ReportedSlack) + ReportedSlack, a, b, c, d, power);
+                        CHECK_BELOW(cubic, fit.cubicError * (1.0 + ReportedSlack) + ReportedSlack, a, b, c, d, power);
+                        if (1.0f - fit.weight >= 0.25f && power >= 0.0f && power <= 3.0f)
+                        {
+                            CHECK_BELOW(cubic, CubicBound, a, b, c, d, power);
+                            bounded++;
+                        }
+                    }
+
+    // The grid must keep covering both bounds
+    if (positive < 500 || bounded < 200)
+    {
+        printf("refraction_fit_test.cpp(%d): only %d fits with a positive refraction, %d within the cubic bound's range\n", __LINE__, positive, bounded);
+        s_failures++;
+    }
+}
+
+int main(int, char**)
+{
+    test_default();
+    test_sweep();
+    if (s_failures)
+    {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -1,11 +1,24 @@
 // Liquid Glass Pixel Shader (DirectX 11 / HLSL)
 
+// Shape of the main panel, compiled once per GlassShapeType (GlassShapes.h)
+#define GLASS_SHAPE_SUPERELLIPSE 0
+#define GLASS_SHAPE_CIRCLE 1
+#define GLASS_SHAPE_ROUNDED_RECT 2
+#define GLASS_SHAPE_CAPSULE 3
+#ifndef GLASS_SHAPE
+#define GLASS_SHAPE GLASS_SHAPE_SUPERELLIPSE
+#endif
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET0;
+    float4 History : SV_TARGET1;    // Same color, kept for the next frame where a target is bound
+};
+
 struct PSInput
 {
     float4 Position : SV_POSITION;
     float2 TexCoord : TEXCOORD0;
-    float4 Color : COLOR;
-    nointerpolation uint LiquidGlass : BLENDINDICES;
     nointerpolation float3 MidPoint : TEXCOORD1;
     nointerpolation float2 QuadScale : TEXCOORD2;
 };
@@ -23,18 +36,88 @@ cbuffer ShaderParams : register(b0)
     float u_glowBias;
     float u_glowEdge0;
     float u_glowEdge1;
-    float _pad[1];
+    float u_dispersion;         // 0 disables the dispersion mode
+    float u_dispersionBand;     // Distance from the edge where the channels split
+    float u_specular;
+    float u_shininess;
+    float u_fresnel;
+    float3 u_lightDir;          // Normalized, screen space with y up and z towards the viewer
+    float u_bevel;              // Distance from the edge over which the surface curves down
+    float u_exact;              // 1: atan2/sin glow and hashed noise instead of the lookup tables
+    float u_interiorBand;       // Variable rate: distance from the edge where the interior starts, 0 is off
+    float u_interiorMargin;     // Variable rate: pixels shaded past the interior for its bilinear upsample
+    float u_refractionMode;     // 0: exact, 1: folded exp2, 2: cubic, see RefractionScale()
+    float4 u_refractionCubic;   // Scale by powers of t, lowest first
+    float u_refractionSlope;    // t = exp2(slope * x) = (c*e)^(-d*x)
+    float u_refractionWeight;   // b * (c*e)^-a
+    float2 _pad;
+};
+
+// Same buffer as the vertex shader's, glass windows read their pixel size and rounding from it
+cbuffer TransformBuffer : register(b1)
+{
+    float4x4 ViewProjection;
+    float3 ObjectPosition;
+    float _pad0;
+    float2 ObjectSize;
+    float2 ScreenSize;
+    float2 CornerRadii;     // x: top corners, y: bottom corners
+    float2 InteriorScale;   // Variable rate: screen pixel to InteriorTexture coordinate
+    float4 ShapeRadii;      // Rounded rect panel: top-left, top-right, bottom-right, bottom-left
+    float2 HistoryMidPoint; // Temporal reuse: panel center (NDC) in the frame GlassHistory holds
+    float HistoryStart;     // Temporal reuse: distance from the edge where it starts, 0 is off
+    float _pad2;
+};
+
+// Liquid merge of several panels, see GlassShapes.h
+cbuffer MergeParams : register(b2)
+{
+    uint u_tilesX;
+    float u_mergeRadius;    // Pixels
+    float2 _mergePad;
+};
+
+// Which effect a draw shades, one immutable buffer per GlassMode (LiquidGlass.h)
+cbuffer GlassPass : register(b3)
+{
+    uint u_mode;
+    float3 _modePad;
+};
+
+struct MergeShape
+{
+    float2 midPoint;        // NDC
+    float2 quadScale;       // NDC half extent
+    float pixelScale;       // Pixels per distance unit
+    uint shape;             // GLASS_SHAPE_*
+    float2 halfSize;        // Pixels
+    float4 cornerRadii;
 };
 
 Texture2D BackgroundTexture : register(t0);
 Texture2D BlurredTexture : register(t1);
+Texture1D<float> GlowLUT : register(t2);      // Glow() by diamond angle, see GlassLookupTables.h
+Texture2D<float> BlueNoise : register(t3);    // 64x64 tile
+StructuredBuffer<MergeShape> MergeShapes : register(t4);
+StructuredBuffer<uint2> MergeTiles : register(t5);    // First entry in MergeTileShapes, count
+StructuredBuffer<uint> MergeTileShapes : register(t6);
+Texture2D InteriorTexture : register(t7);     // Variable rate interior: color, glow factor in alpha
+Texture2D GlassHistory : register(t8);        // Last frame's main panel output
 SamplerState LinearSampler : register(s0);
+SamplerState WrapSampler : register(s1);
 
 static const float M_E = 2.718281828459045;
 static const float EPSILON = 0.00001;
+static const uint BLUE_NOISE_MASK = 63;
+static const uint MERGE_TILE_SIZE = 32;
+
+// Cauchy dispersion, n(lambda) ~ 1/lambda^2, relative to green (550nm) for 650/550/450nm
+static const float3 DISPERSION_WAVELENGTH = float3(550.0 * 550.0 / (650.0 * 650.0) - 1.0, 0.0, 550.0 * 550.0 / (450.0 * 450.0) - 1.0);
 
 // Signed distance field for superellipse (squircle)
-float sdSuperellipse(float2 p, float n, float r)
+// gradient: outward unit normal of the level set, n * (|x|^(n-1), |y|^(n-1)) / denominator,
+// built from the same powers the distance already needs
+float sdSuperellipse(float2 p, float n, float r, out float2 gradient)
 {
     float2 p_abs = abs(p);
     
@@ -44,15 +127,110 @@ float sdSuperellipse(float2 p, float n, float r)
     float den_y = pow(p_abs.y, 2.0 * n - 2.0);
     float denominator = n * sqrt(den_x + den_y) + EPSILON;
     
+    gradient = n * sqrt(float2(den_x, den_y)) * sign(p) / denominator;
     return numerator / denominator;
 }
 
+// Signed distance to a rounded rectangle with a radius per corner: top-left, top-right,
+// bottom-right, bottom-left, p.y pointing down (a window's glass starts below its square
+// title bar). Exact, in the unit of p.
+float sdRoundedRect(float2 p, float2 halfSize, float4 radii, out float2 gradient)
+{
+    float2 side = p.y > 0.0 ? radii.wz : radii.xy;
+    float r = p.x > 0.0 ? side.y : side.x;
+    float2 q = abs(p) - halfSize + r;
+    float2 outside = max(q, 0.0);
+    float outsideLength = length(outside);
+
+    // Corner arcs point away from their center, straight edges along their axis
+    if (outsideLength > 0.0)
+        gradient = outside / outsideLength * sign(p);
+    else
+        gradient = (q.x > q.y ? float2(1.0, 0.0) : float2(0.0, 1.0)) * sign(p);
+    return min(max(q.x, q.y), 0.0) + outsideLength - r;
+}
+
+// Unit circle, exact
+float sdCircle(float2 q, out float2 gradient)
+{
+    float len = length(q);
+    gradient = q / max(len, EPSILON);
+    return len - 1.0;
+}
+
+// Radius 1 around a segment along the long axis of halfSize (its short side is 1), exact
+float sdCapsule(float2 q, float2 halfSize, out float2 gradient)
+{
+    float2 segment = halfSize - 1.0;
+    float2 v = q - clamp(q, -segment, segment);
+    float len = length(v);
+    if (len > 0.0)
+        gradient = v / len;
+    else
+        gradient = halfSize.x >= halfSize.y ? float2(0.0, sign(q.y)) : float2(sign(q.x), 0.0);
+    return len - 1.0;
+}
+
+// Any shape at p (-1..1 over a panel of the given size, only its aspect matters). The closed
+// forms work in units of the shorter half side, so a circle stays round on a wide panel.
+float sdGlassShape(uint shape, float2 p, float2 size, float4 cornerRadii, out float2 gradient)
+{
+    if (shape == GLASS_SHAPE_SUPERELLIPSE)
+        return sdSuperellipse(p, u_powerFactor, 1.0, gradient);
+
+    float2 halfSize = size / min(size.x, size.y);
+    if (shape == GLASS_SHAPE_CIRCLE)
+        return sdCircle(p * halfSize, gradient);
+    if (shape == GLASS_SHAPE_CAPSULE)
+        return sdCapsule(p * halfSize, halfSize, gradient);
+    return sdRoundedRect(p * halfSize, halfSize, cornerRadii, gradient);
+}
+
+// The main panel's shape, fixed per compiled variant so only its own distance is evaluated
+float sdPanel(float2 p, out float2 gradient)
+{
+#if GLASS_SHAPE == GLASS_SHAPE_SUPERELLIPSE
+    return sdSuperellipse(p, u_powerFactor, 1.0, gradient);
+#else
+    float2 halfSize = ObjectSize / min(ObjectSize.x, ObjectSize.y);
+#if GLASS_SHAPE == GLASS_SHAPE_CIRCLE
+    return sdCircle(p * halfSize, gradient);
+#elif GLASS_SHAPE == GLASS_SHAPE_CAPSULE
+    return sdCapsule(p * halfSize, halfSize, gradient);
+#else
+    return sdRoundedRect(p * halfSize, halfSize, ShapeRadii, gradient);
+#endif
+#endif
+}
+
 // Refraction function
 float refractionFunc(float x)
 {
     return 1.0 - u_b * pow(u_c * M_E, -u_d * x - u_a);
 }
 
+// Scale of the refracted sample at distance x inside the edge, pow(refractionFunc(x), u_fPower),
+// and the refraction itself for the dispersed channels. The constants are folded on the CPU
+// (FitRefraction() in GlassLookupTables.h): the refraction is 1 - weight * t with one exp2 for
+// t, where mode 0 evaluates the formula as written for validation. Mode 2 takes the scale
+// from a cubic in t instead of the pow, off by at most the fit's cubicError.
+float RefractionScale(float x, out float refraction)
+{
+    float t = exp2(u_refractionSlope * x);
+    [branch]
+    if (u_refractionMode == 0.0)
+        refraction = refractionFunc(x);
+    else
+        refraction = 1.0 - u_refractionWeight * t;
+    [branch]
+    if (u_refractionMode == 2.0)
+    {
+        float4 c = u_refractionCubic;
+        return ((c.w * t + c.z) * t + c.y) * t + c.x;
+    }
+    return pow(refraction, u_fPower);
+}
+
 // Pseudo-random noise
 float rand(float2 co)
 {
@@ -65,48 +243,246 @@ float Glow(float2 texCoord)
     return sin(atan2(texCoord.y * 2.0 - 1.0, texCoord.x * 2.0 - 1.0) - 0.5);
 }
 
-float4 LiquidGlassEffect(PSInput input)
+// Glow() from the lookup table: the diamond angle is monotonic in the real angle and
+// needs one divide, the table holds the sin(atan2) for it (max error ~0.002 at 256 texels)
+float GlowLookup(float2 texCoord)
 {
-    float2 center = float2(0.5, 0.5);
-    float2 p = (input.TexCoord - center) * 2.0;
-    float r = 1.0;
-    float d = sdSuperellipse(p, u_powerFactor, r);
-    
-    // Discard pixels outside the shape
-    if (d > 0.0)
-        discard;
-    
-    float dist = -d;
-    float2 sampleP = p * pow(refractionFunc(dist), u_fPower);
+    float2 v = texCoord * 2.0 - 1.0;
+    float s = v.y / (abs(v.x) + abs(v.y) + EPSILON);
+    float t = v.x >= 0.0 ? s : 2.0 - s;
+    return GlowLUT.SampleLevel(WrapSampler, t * 0.25, 0);
+}
+
+// Blurred texture coordinate seen through the glass at p, scaled by the refraction amount
+float2 RefractedCoord(float2 p, float scale, float2 midPoint, float2 quadScale, bool window)
+{
+    float2 sampleP = p * scale;
     
     // Flip refraction direction for DirectX coordinate system
     sampleP.y = -sampleP.y;
     
     // Transform to screen space for texture lookup
-    float2 targetNDC = sampleP * input.QuadScale + input.MidPoint.xy;
+    float2 targetNDC = sampleP * quadScale + midPoint;
     float2 coord = targetNDC * 0.5 + float2(0.5, 0.5);
+
+    // The scene snapshot behind glass windows is stored top-down
+    if (window)
+        coord.y = 1.0 - coord.y;
+    return coord;
+}
+
+// Per pixel noise, -0.5..0.5
+float GlassNoise(float2 position)
+{
+    [branch]
+    if (u_exact > 0.0)
+        return rand(position * 0.001) - 0.5;
+    return BlueNoise.Load(int3(uint2(position) & BLUE_NOISE_MASK, 0)) - 0.5;
+}
+
+// Refraction, glow and lighting of a point p (-1..1 over the shape, y down) at distance dist
+// inside the edge, seen through a shape centered on midPoint with quadScale half extent.
+// Everything but the noise, which is glowValue * GlassNoise() * u_noise on top: all of it
+// varies smoothly away from the edge except the noise, so it can be shaded at a lower rate.
+float4 ShadeGlassSmooth(float2 p, float dist, float2 gradient, float2 midPoint, float2 quadScale, bool window, out float glowValue)
+{
+    glowValue = 0.0;
+    float2 texCoord = p * 0.5 + 0.5;
+    float refraction;
+    float2 coord = RefractedCoord(p, RefractionScale(dist, refraction), midPoint, quadScale, window);
     
     // Return magenta for out-of-bounds
     if (max(coord.x, coord.y) > 1.0 || min(coord.x, coord.y) < 0.0)
         return float4(1.0, 0.0, 1.0, 1.0);
     
-    // Sample blurred texture with noise
-    float4 noise = float4((rand(input.Position.xy * 0.001) - 0.5).xxx, 0.0);
-    float4 color = BlurredTexture.Sample(LinearSampler, coord) + noise * u_noise;
+    // Sample blurred texture, each channel refracted on its own inside the edge band only
+    float4 color;
+    float dispersion = u_dispersion * smoothstep(u_dispersionBand, 0.0, dist);
+    [branch]
+    if (dispersion > 0.0)
+    {
+        float3 power = u_fPower * (1.0 + dispersion * DISPERSION_WAVELENGTH);
+        color.r = BlurredTexture.Sample(LinearSampler, RefractedCoord(p, pow(refraction, power.r), midPoint, quadScale, window)).r;
+        color.ga = BlurredTexture.Sample(LinearSampler, coord).ga;
+        color.b = BlurredTexture.Sample(LinearSampler, RefractedCoord(p, pow(refraction, power.b), midPoint, quadScale, window)).b;
+    }
+    else
+    {
+        color = BlurredTexture.Sample(LinearSampler, coord);
+    }
+
+    // Glow, from the lookup table unless validating against the exact function
+    float glow;
+    [branch]
+    if (u_exact > 0.0)
+        glow = Glow(texCoord);
+    else
+        glow = GlowLookup(texCoord);
+    glowValue = glow * u_glowWeight * smoothstep(u_glowEdge0, u_glowEdge1, dist) + 1.0 + u_glowBias;
+    color *= float4(glowValue.xxx, 1.0);
+
+    // Surface normal: flat in the middle, tilting outwards along the SDF gradient near the edge.
+    // p.y points down the screen, flip it to match the light direction.
+    float tilt = 1.0 - saturate(dist / max(u_bevel, EPSILON));
+    float3 normal = normalize(float3(float2(gradient.x, -gradient.y) * tilt, 1.0 - tilt + EPSILON));
+
+    // Blinn-Phong specular and Schlick Fresnel rim, viewer straight on
+    float3 viewDir = float3(0.0, 0.0, 1.0);
+    float3 halfDir = normalize(u_lightDir + viewDir);
+    float specular = u_specular * pow(saturate(dot(normal, halfDir)), u_shininess);
+    float rim = u_fresnel * pow(1.0 - saturate(dot(normal, viewDir)), 5.0);
+    color.rgb += specular + rim;
+    return color;
+}
+
+float4 ShadeGlass(float4 position, float2 p, float dist, float2 gradient, float2 midPoint, float2 quadScale, bool window)
+{
+    float glowValue;
+    float4 color = ShadeGlassSmooth(p, dist, gradient, midPoint, quadScale, window, glowValue);
+    color.rgb += GlassNoise(position.xy) * u_noise * glowValue;
+    return color;
+}
+
+// Variable rate: distance from the edge where the main panel's interior starts, at least the
+// upsample margin so every texel the upsample reads lies inside the shape
+float InteriorStart(float2 quadScale, out float margin)
+{
+    float pixelScale = min(quadScale.x * ScreenSize.x, quadScale.y * ScreenSize.y) * 0.5;
+    margin = u_interiorMargin / max(pixelScale, 1.0);
+    return max(u_interiorBand, margin);
+}
+
+float4 LiquidGlassEffect(PSInput input, bool window)
+{
+    float2 center = float2(0.5, 0.5);
+    float2 p = (input.TexCoord - center) * 2.0;
+    float d;
+    float2 gradient;
+    if (window)
+    {
+        // Normalized so the refraction profile spans the window's short side
+        d = sdRoundedRect(p * ObjectSize, ObjectSize, CornerRadii.xxyy, gradient) / min(ObjectSize.x, ObjectSize.y);
+    }
+    else
+    {
+        d = sdPanel(p, gradient);
+    }
+    
+    // Discard pixels outside the shape
+    if (d > 0.0)
+        discard;
+
+    // Temporal reuse: past HistoryStart the glass shows the background straight behind the
+    // pixel, so while only the panel moved, last frame's output at this pixel still holds if
+    // it was that far inside last frame's panel too. Newly covered pixels and the edge band
+    // are shaded below.
+    [branch]
+    if (!window && HistoryStart > 0.0 && -d >= HistoryStart)
+    {
+        float2 ndc = float2(input.Position.x / ScreenSize.x * 2.0 - 1.0, 1.0 - input.Position.y / ScreenSize.y * 2.0);
+        float2 historyP = (ndc - HistoryMidPoint) / input.QuadScale;
+        historyP.y = -historyP.y;
+        float2 historyGradient;
+        if (-sdPanel(historyP, historyGradient) >= HistoryStart)
+            return GlassHistory.Load(int3(input.Position.xy, 0));
+    }
+
+    // Variable rate: past the edge band the interior pass already shaded it at a lower rate
+    [branch]
+    if (!window && u_interiorBand > 0.0)
+    {
+        float margin;
+        if (-d >= InteriorStart(input.QuadScale, margin))
+        {
+            // The blurred background is opaque, alpha holds the glow factor for the noise
+            float4 interior = InteriorTexture.SampleLevel(LinearSampler, input.Position.xy * InteriorScale, 0);
+            return float4(interior.rgb + GlassNoise(input.Position.xy) * u_noise * interior.a, 1.0);
+        }
+    }
     
-    // Apply glow
-    float glowValue = Glow(input.TexCoord) * u_glowWeight * smoothstep(u_glowEdge0, u_glowEdge1, dist) + 1.0 + u_glowBias;
-    return color * float4(glowValue.xxx, 1.0);
+    return ShadeGlass(input.Position, p, -d, gradient, input.MidPoint.xy, input.QuadScale, window);
+}
+
+// Main panel interior at 1/rate per axis, into InteriorTexture; the margin past the interior
+// start covers the texels the full rate pass's bilinear upsample reads
+float4 InteriorGlassEffect(PSInput input)
+{
+    float2 p = (input.TexCoord - float2(0.5, 0.5)) * 2.0;
+    float2 gradient;
+    float d = sdPanel(p, gradient);
+    float margin;
+    if (-d < InteriorStart(input.QuadScale, margin) - margin)
+        discard;
+
+    float glowValue;
+    float4 color = ShadeGlassSmooth(p, -d, gradient, input.MidPoint.xy, input.QuadScale, false, glowValue);
+    return float4(color.rgb, glowValue);
+}
+
+// Smooth union of the panels binned into this pixel's tile. Distances are blended in pixels
+// with a polynomial smooth-min, and the gradient, center and extent along with them, so the
+// merged shape gets one refraction and glow evaluation like a single panel.
+float4 MergedGlassEffect(PSInput input)
+{
+    uint2 tile = uint2(input.Position.xy) / MERGE_TILE_SIZE;
+    uint2 bin = MergeTiles[tile.y * u_tilesX + tile.x];
+    if (bin.y == 0)
+        discard;
+
+    float2 ndc = float2(input.Position.x / ScreenSize.x * 2.0 - 1.0, 1.0 - input.Position.y / ScreenSize.y * 2.0);
+    float k = max(u_mergeRadius, EPSILON);
+    float d = 0.0;
+    float2 gradient = float2(0.0, 0.0);
+    float2 midPoint = float2(0.0, 0.0);
+    float2 quadScale = float2(1.0, 1.0);
+    float pixelScale = 1.0;
+    [loop]
+    for (uint i = 0; i < bin.y; i++)
+    {
+        MergeShape shape = MergeShapes[MergeTileShapes[bin.x + i]];
+        float2 p = (ndc - shape.midPoint) / shape.quadScale;
+        p.y = -p.y;
+        float2 shapeGradient;
+        float shapeD = sdGlassShape(shape.shape, p, shape.halfSize, shape.cornerRadii, shapeGradient) * shape.pixelScale;
+
+        // h: weight of the shapes so far
+        float h = i == 0 ? 0.0 : saturate(0.5 + 0.5 * (shapeD - d) / k);
+        d = lerp(shapeD, d, h) - k * h * (1.0 - h);
+        gradient = lerp(shapeGradient, gradient, h);
+        midPoint = lerp(shape.midPoint, midPoint, h);
+        quadScale = lerp(shape.quadScale, quadScale, h);
+        pixelScale = lerp(shape.pixelScale, pixelScale, h);
+    }
+
+    if (d > 0.0)
+        discard;
+
+    float2 p = (ndc - midPoint) / quadScale;
+    p.y = -p.y;
+    gradient /= max(length(gradient), EPSILON);
+    return ShadeGlass(input.Position, p, -d / pixelScale, gradient, midPoint, quadScale, false);
 }
 
-float4 main(PSInput input) : SV_TARGET
+float4 Shade(PSInput input)
 {
     // Mode 1: Liquid Glass effect
-    if (input.LiquidGlass == 1)
-        return LiquidGlassEffect(input);
+    if (u_mode == 1)
+        return LiquidGlassEffect(input, false);
+
+    // Mode 3: Liquid Glass under an ImGui window
+    if (u_mode == 3)
+        return LiquidGlassEffect(input, true);
+
+    // Mode 4: Liquid merge of several panels, drawn over their bounds
+    if (u_mode == 4)
+        return MergedGlassEffect(input);
+
+    // Mode 5: Main panel interior at a lower rate (variable rate shading)
+    if (u_mode == 5)
+        return InteriorGlassEffect(input);
     
     // Mode 2: Direct background rendering
-    if (input.LiquidGlass == 2)
+    if (u_mode == 2)
     {
         float2 coord = input.TexCoord;
         coord.y = 1.0 - coord.y;
@@ -114,5 +490,13 @@ float4 main(PSInput input) : SV_TARGET
     }
     
     // Mode 0: Normal rendering
-    return input.Color * BackgroundTexture.Sample(LinearSampler, input.TexCoord);
+    return BackgroundTexture.Sample(LinearSampler, input.TexCoord);
+}
+
+PSOutput main(PSInput input)
+{
+    PSOutput output;
+    output.Color = Shade(input);
+    output.History = output.Color;
+    return output;
 }
@@ -0,0 +1,164 @@
+// Liquid Glass example
+// (bake_background_cache.cpp)
+// Helper tool to pre-bake the .lgbc background caches for every image in a directory,
+// so the example never has to decode a wallpaper at startup.
+
+// Each <image> gets an <image>.lgbc next to it: full mip chain, RGBA8/BC1/BC7 payload
+// and a hash of the source file. The example validates that hash on load and ignores
+// (then rewrites) caches whose source has changed. See BackgroundCache.h for the layout.
+
+// Build with, e.g:
+//   # cl.exe /O2 /I..\..\examples\example_win32_directx11 bake_background_cache.cpp ..\..\examples\example_win32_directx11\BackgroundCache.cpp ..\..\examples\example_win32_directx11\BlockCompress.cpp ..\..\examples\example_win32_directx11\MappedFile.cpp
+//   # g++ -O2 -pthread -I../../examples/example_win32_directx11 bake_background_cache.cpp ../../examples/example_win32_directx11/BackgroundCache.cpp ../../examples/example_win32_directx11/BlockCompress.cpp ../../examples/example_win32_directx11/MappedFile.cpp
+
+// Usage:
+//   bake_background_cache.exe [-force] [-rgba|-bc1|-bc7] <directory>
+// Usage example:
+//   # bake_background_cache.exe ../../examples/example_win32_directx11
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "BackgroundCache.h"
+#include "BlockCompress.h"
+
+enum BakeResult
+{
+    BakeResult_Baked,
+    BakeResult_UpToDate,
+    BakeResult_Failed,
+};
+
+static bool list_directory(const char* directory, std::vector<std::string>* out_files);
+static bool is_image_file(const std::string& filename);
+static BakeResult bake_background_cache(const char* filename, BackgroundCacheFormat format, bool force);
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Syntax: %s [-force] [-rgba|-bc1|-bc7] <directory>\n", argv[0]);
+        printf(" -force = rebake caches that are already valid for their source image.\n");
+        printf(" -rgba  = uncompressed payload.\n");
+        printf(" -bc1   = BC1 payload, 8x smaller than RGBA8, fast to encode.\n");
+        printf(" -bc7   = BC7 payload, 4x smaller than RGBA8, higher quality (default, matches the example).\n");
+        return 0;
+    }
+
+    int argn = 1;
+    bool force = false;
+    BackgroundCacheFormat format = BackgroundCacheFormat_BC7;
+    while (argn < (argc - 1) && argv[argn][0] == '-')
+    {
+        if (strcmp(argv[argn], "-force") == 0) { force = true; argn++; }
+        else if (strcmp(argv[argn], "-rgba") == 0) { format = BackgroundCacheFormat_RGBA8; argn++; }
+        else if (strcmp(argv[argn], "-bc1") == 0) { format = BackgroundCacheFormat_BC1; argn++; }
+        else if (strcmp(argv[argn], "-bc7") == 0) { format = BackgroundCacheFormat_BC7; argn++; }
+        else
+        {
+            fprintf(stderr, "Unknown argument: '%s'\n", argv[argn]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> files;
+    if (!list_directory(argv[argn], &files))
+    {
+        fprintf(stderr, "Error opening directory: '%s'\n", argv[argn]);
+        return 1;
+    }
+
+    int baked = 0, up_to_date = 0, failed = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (!is_image_file(files[i]))
+            continue;
+        std::string path = std::string(argv[argn]) + "/" + files[i];
+        switch (bake_background_cache(path.c_str(), format, force))
+        {
+        case BakeResult_Baked:    printf("baked:      %s\n", path.c_str()); baked++; break;
+        case BakeResult_UpToDate: printf("up to date: %s\n", path.c_str()); up_to_date++; break;
+        case BakeResult_Failed:   fprintf(stderr, "failed:     %s\n", path.c_str()); failed++; break;
+        }
+    }
+    printf("%d baked, %d up to date, %d failed\n", baked, up_to_date, failed);
+    return failed ? 1 : 0;
+}
+
+static bool list_directory(const char* directory, std::vector<std::string>* out_files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA find_data;
+    std::string pattern = std::string(directory) + "\\*";
+    HANDLE find = FindFirstFileA(pattern.c_str(), &find_data);
+    if (find == INVALID_HANDLE_VALUE)
+        return false;
+    do
+    {
+        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            out_files->push_back(find_data.cFileName);
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory);
+    if (!dir)
+        return false;
+    while (struct dirent* entry = readdir(dir))
+        if (entry->d_name[0] != '.')
+            out_files->push_back(entry->d_name);
+    closedir(dir);
+#endif
+    return true;
+}
+
+static bool is_image_file(const std::string& filename)
+{
+    static const char* extensions[] = { ".jpg", ".jpeg", ".png", ".bmp", ".tga", ".psd", ".gif", ".hdr", ".pic", ".pnm" };
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string ext = filename.substr(dot);
+    for (size_t i = 0; i < ext.size(); i++)
+        ext[i] = (char)((ext[i] >= 'A' && ext[i] <= 'Z') ? ext[i] - 'A' + 'a' : ext[i]);
+    for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++)
+        if (ext == extensions[i])
+            return true;
+    return false;
+}
+
+static BakeResult bake_background_cache(const char* filename, BackgroundCacheFormat format, bool force)
+{
+    MappedFile source;
+    if (!source.Open(filename) || source.Size() > (size_t)INT_MAX)
+        return BakeResult_Failed;
+
+    uint64_t source_hash = HashBackgroundSource(source.Data(), source.Size());
+    std::string cache_path = GetBackgroundCachePath(filename);
+    BackgroundCacheFile cache;
+    if (!force && cache.Open(cache_path.c_str(), source_hash, source.Size()) && cache.Header().format == (uint32_t)format)
+        return BakeResult_UpToDate;
+    cache.Close();
+
+    int width, height, channels;
+    unsigned char* data = stbi_load_from_memory(source.Data(), (int)source.Size(), &width, &height, &channels, 4);
+    if (!data)
+        return BakeResult_Failed;
+
+    BackgroundMipChain chain;
+    bool built = BuildBackgroundMipChain(data, width, height, format, &chain);
+    stbi_image_free(data);
+    if (!built)
+        return BakeResult_Failed;
+    return WriteBackgroundCache(cache_path.c_str(), chain, source_hash, source.Size()) ? BakeResult_Baked : BakeResult_Failed;
+}
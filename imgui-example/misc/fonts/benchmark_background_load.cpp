@@ -0,0 +1,230 @@
+// Liquid Glass example
+// (benchmark_background_load.cpp)
+// Helper tool to time how the example loads its background images: stbi_load() through stdio
+// against LoadImageMapped() decoding straight out of a file mapping, for every image in a
+// directory, from a hot page cache or, with -cold, with each file evicted from it first.
+
+// Every image is loaded -runs times per method and the median reported, next to the decode
+// alone (stbi_load_from_memory() of the file already in memory), so what is left over is the
+// file access. Hot runs follow a read of the whole file. Cold runs evict the file before every
+// load: posix_fadvise(POSIX_FADV_DONTNEED) on POSIX, opening it unbuffered on Windows (which
+// purges its cached pages). Either only drops pages nobody else holds, and the drive's own
+// cache stays warm.
+
+// Build with, e.g:
+//   # cl.exe /O2 /I..\..\examples\example_win32_directx11 benchmark_background_load.cpp ..\..\examples\example_win32_directx11\MappedFile.cpp
+//   # g++ -O2 -I../../examples/example_win32_directx11 benchmark_background_load.cpp ../../examples/example_win32_directx11/MappedFile.cpp
+
+// Usage:
+//   benchmark_background_load.exe [-cold] [-runs N] <directory>
+// Usage example:
+//   # benchmark_background_load.exe -cold ../../examples/example_win32_directx11
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "MappedFile.h"
+
+enum LoadMethod
+{
+    LoadMethod_Stdio,
+    LoadMethod_Mapped,
+    LoadMethod_Decode,      // From memory, no file access
+    LoadMethod_COUNT
+};
+
+static bool list_directory(const char* directory, std::vector<std::string>* out_files);
+static bool is_image_file(const std::string& filename);
+static bool read_file(const char* filename, std::vector<unsigned char>* out_data);
+static bool evict_file(const char* filename);
+static bool time_load(const char* filename, LoadMethod method, const std::vector<unsigned char>& contents, bool cold, int runs, double* out_ms);
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Syntax: %s [-cold] [-runs N] <directory>\n", argv[0]);
+        printf(" -cold   = evict each file from the page cache before every load.\n");
+        printf(" -runs N = loads per image and method, the median is reported (default 5).\n");
+        return 0;
+    }
+
+    int argn = 1;
+    bool cold = false;
+    int runs = 5;
+    while (argn < (argc - 1) && argv[argn][0] == '-')
+    {
+        if (strcmp(argv[argn], "-cold") == 0) { cold = true; argn++; }
+        else if (strcmp(argv[argn], "-runs") == 0 && argn + 1 < argc - 1) { runs = atoi(argv[argn + 1]); argn += 2; }
+        else
+        {
+            fprintf(stderr, "Unknown argument: '%s'\n", argv[argn]);
+            return 1;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+
+    std::vector<std::string> files;
+    if (!list_directory(argv[argn], &files))
+    {
+        fprintf(stderr, "Error opening directory: '%s'\n", argv[argn]);
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    printf("%s page cache, median of %d runs\n", cold ? "Cold" : "Hot", runs);
+    printf("%10s %10s %10s %10s  %s\n", "KB", "stdio ms", "mapped ms", "decode ms", "image");
+    double total_kb = 0.0;
+    double total_ms[LoadMethod_COUNT] = {};
+    int loaded = 0, failed = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (!is_image_file(files[i]))
+            continue;
+        std::string path = std::string(argv[argn]) + "/" + files[i];
+        std::vector<unsigned char> contents;
+        double ms[LoadMethod_COUNT];
+        bool ok = read_file(path.c_str(), &contents);
+        for (int method = 0; ok && method < LoadMethod_COUNT; method++)
+            ok = time_load(path.c_str(), (LoadMethod)method, contents, cold, runs, &ms[method]);
+        if (!ok)
+        {
+            fprintf(stderr, "failed:     %s\n", path.c_str());
+            failed++;
+            continue;
+        }
+        double kb = contents.size() / 1024.0;
+        printf("%10.1f %10.3f %10.3f %10.3f  %s\n", kb, ms[LoadMethod_Stdio], ms[LoadMethod_Mapped], ms[LoadMethod_Decode], path.c_str());
+        total_kb += kb;
+        for (int method = 0; method < LoadMethod_COUNT; method++)
+            total_ms[method] += ms[method];
+        loaded++;
+    }
+    printf("%10.1f %10.3f %10.3f %10.3f  total, %d images, %d failed\n", total_kb, total_ms[LoadMethod_Stdio], total_ms[LoadMethod_Mapped],
+        total_ms[LoadMethod_Decode], loaded, failed);
+    return failed ? 1 : 0;
+}
+
+static bool list_directory(const char* directory, std::vector<std::string>* out_files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA find_data;
+    std::string pattern = std::string(directory) + "\\*";
+    HANDLE find = FindFirstFileA(pattern.c_str(), &find_data);
+    if (find == INVALID_HANDLE_VALUE)
+        return false;
+    do
+    {
+        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            out_files->push_back(find_data.cFileName);
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory);
+    if (!dir)
+        return false;
+    while (struct dirent* entry = readdir(dir))
+        if (entry->d_name[0] != '.')
+            out_files->push_back(entry->d_name);
+    closedir(dir);
+#endif
+    return true;
+}
+
+static bool is_image_file(const std::string& filename)
+{
+    static const char* extensions[] = { ".jpg", ".jpeg", ".png", ".bmp", ".tga", ".psd", ".gif", ".hdr", ".pic", ".pnm" };
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos)
+        return false;
+    std::string ext = filename.substr(dot);
+    for (size_t i = 0; i < ext.size(); i++)
+        ext[i] = (char)((ext[i] >= 'A' && ext[i] <= 'Z') ? ext[i] - 'A' + 'a' : ext[i]);
+    for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++)
+        if (ext == extensions[i])
+            return true;
+    return false;
+}
+
+static bool read_file(const char* filename, std::vector<unsigned char>* out_data)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+        return false;
+    unsigned char buffer[64 * 1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        out_data->insert(out_data->end(), buffer, buffer + read);
+    bool ok = !ferror(f) && !out_data->empty();
+    fclose(f);
+    return ok;
+}
+
+static bool evict_file(const char* filename)
+{
+#ifdef _WIN32
+    // Opening a file unbuffered flushes and purges its cached pages, as long as no other handle
+    // or mapping holds them
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    CloseHandle(file);
+    return true;
+#elif defined(POSIX_FADV_DONTNEED)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+    int result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return result == 0;
+#else
+    (void)filename;
+    fprintf(stderr, "-cold is not supported on this platform\n");
+    return false;
+#endif
+}
+
+static bool time_load(const char* filename, LoadMethod method, const std::vector<unsigned char>& contents, bool cold, int runs, double* out_ms)
+{
+    std::vector<double> samples;
+    for (int run = 0; run < runs; run++)
+    {
+        if (cold && method != LoadMethod_Decode && !evict_file(filename))
+            return false;
+
+        int width, height, channels;
+        unsigned char* data = nullptr;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        switch (method)
+        {
+        case LoadMethod_Stdio:  data = stbi_load(filename, &width, &height, &channels, 4); break;
+        case LoadMethod_Mapped: data = LoadImageMapped(filename, &width, &height, &channels, 4); break;
+        case LoadMethod_Decode: data = stbi_load_from_memory(contents.data(), (int)contents.size(), &width, &height, &channels, 4); break;
+        default: break;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        if (!data)
+            return false;
+        stbi_image_free(data);
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    *out_ms = samples[samples.size() / 2];
+    return true;
+}